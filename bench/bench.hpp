@@ -0,0 +1,45 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+
+/**
+ * Bits shared by the benchmarks. Each benchmark is a plain executable that
+ * prints a small table; they run on one thread, so the numbers are per core.
+ */
+namespace bench {
+
+/// Hides a result from the optimizer so the work producing it isn't dropped.
+template <class T>
+inline void keep(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static const void *volatile sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * @brief Best wall time of one fn() call in milliseconds, over repeated
+ *        calls adding up to at least minMs. The best call is the one least
+ *        disturbed by the rest of the system.
+ */
+template <class Fn>
+inline double bestMs(Fn fn, double minMs = 200.0) {
+    using clock = std::chrono::steady_clock;
+    double best = 1e300, total = 0.0;
+    for (int runs = 0; total < minMs || runs < 3; ++runs) {
+        auto start = clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        best = std::min(best, ms);
+        total += ms;
+    }
+    return best;
+}
+
+}
+
+#endif
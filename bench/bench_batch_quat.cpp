@@ -0,0 +1,159 @@
+// Batched quaternion kernels against one glm call per bone, in bones per
+// millisecond.
+//
+//     bench_batch_quat_level<N> [bones...]
+#include "bench.hpp"
+#include "include/batch_quat.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+glm::quat nlerpGlm(const glm::quat &a, glm::quat b, float t) {
+    if (glm::dot(a, b) < 0.0f)
+        b = -b;
+    return glm::normalize(a * (1.0f - t) + b * t);
+}
+
+// The same as Transform::matrix() in scene_graph.hpp.
+glm::mat4 composeGlm(const glm::vec3 &t, const glm::quat &r, const glm::vec3 &s) {
+    glm::mat4 m = glm::mat4_cast(r);
+    m[0] *= s.x;
+    m[1] *= s.y;
+    m[2] *= s.z;
+    m[3] = glm::vec4(t, 1.0f);
+    return m;
+}
+
+float maxDifference(const std::vector<glm::quat> &expected, const batch::QuatBatch &q) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        // q and -q are the same rotation.
+        glm::quat value = q.get(i);
+        float sign = glm::dot(value, expected[i]) < 0.0f ? -1.0f : 1.0f;
+        for (int k = 0; k < 4; ++k)
+            worst = std::max(worst, std::fabs(sign * value[k] - expected[i][k]));
+    }
+    return worst;
+}
+
+float maxDifference(const std::vector<glm::mat4> &expected, const batch::Mat4Batch &m) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        glm::mat4 value = m.get(i);
+        for (int c = 0; c < 4; ++c)
+            for (int r = 0; r < 4; ++r)
+                worst = std::max(worst, std::fabs(value[c][r] - expected[i][c][r]));
+    }
+    return worst;
+}
+
+void report(const char *name, size_t count, double glmMs, double batchMs, float difference) {
+    std::printf("  %-22s %9.0f %9.0f %7.2fx   max diff %.2g\n", name, count / glmMs, count / batchMs,
+                glmMs / batchMs, difference);
+}
+
+void run(size_t count) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f), blend(0.0f, 1.0f), size(0.5f, 2.0f);
+    std::vector<glm::quat> from(count), to(count), quats(count);
+    std::vector<glm::vec3> translations(count), scales(count);
+    std::vector<glm::mat4> matrices(count);
+    std::vector<float> t(count);
+    batch::QuatBatch fromBatch(count), toBatch(count), quatBatch(count);
+    batch::Vec3Batch translationBatch(count), scaleBatch(count);
+    batch::Mat4Batch matrixBatch(count);
+    for (size_t i = 0; i < count; ++i) {
+        // Neighbouring keyframes: the second key is the first turned a little.
+        from[i] = glm::normalize(glm::quat(unit(rng), unit(rng), unit(rng), unit(rng)));
+        to[i] = glm::normalize(from[i] * glm::angleAxis(unit(rng),
+                                                        glm::normalize(glm::vec3(unit(rng), unit(rng), 1.0f))));
+        translations[i] = glm::vec3(unit(rng), unit(rng), unit(rng)) * 10.0f;
+        scales[i] = glm::vec3(size(rng), size(rng), size(rng));
+        t[i] = blend(rng);
+        fromBatch.set(i, from[i]);
+        toBatch.set(i, to[i]);
+        translationBatch.set(i, translations[i]);
+        scaleBatch.set(i, scales[i]);
+    }
+
+    std::printf("%zu bones, bones per millisecond\n  %-22s %9s %9s %8s\n", count, "", "glm", "batch", "speedup");
+    double glmMs = bench::bestMs([&] {
+        for (size_t i = 0; i < count; ++i)
+            quats[i] = nlerpGlm(from[i], to[i], t[i]);
+        bench::keep(quats[0]);
+    });
+    double batchMs = bench::bestMs([&] {
+        batch::nlerp<fastmath::Exact>(fromBatch, toBatch, t, quatBatch);
+        bench::keep(quatBatch.e[0][0]);
+    });
+    report("nlerp", count, glmMs, batchMs, maxDifference(quats, quatBatch));
+    batchMs = bench::bestMs([&] {
+        batch::nlerp<fastmath::Fast>(fromBatch, toBatch, t, quatBatch);
+        bench::keep(quatBatch.e[0][0]);
+    });
+    report("nlerp (Fast)", count, glmMs, batchMs, maxDifference(quats, quatBatch));
+
+    glmMs = bench::bestMs([&] {
+        for (size_t i = 0; i < count; ++i)
+            quats[i] = glm::slerp(from[i], to[i], t[i]);
+        bench::keep(quats[0]);
+    });
+    batchMs = bench::bestMs([&] {
+        batch::slerp(fromBatch, toBatch, t, quatBatch);
+        bench::keep(quatBatch.e[0][0]);
+    });
+    report("slerp", count, glmMs, batchMs, maxDifference(quats, quatBatch));
+
+    glmMs = bench::bestMs([&] {
+        for (size_t i = 0; i < count; ++i)
+            matrices[i] = glm::mat4_cast(quats[i]);
+        bench::keep(matrices[0]);
+    });
+    batchMs = bench::bestMs([&] {
+        batch::toMat4(quatBatch, matrixBatch);
+        bench::keep(matrixBatch.e[0][0]);
+    });
+    report("toMat4", count, glmMs, batchMs, maxDifference(matrices, matrixBatch));
+
+    glmMs = bench::bestMs([&] {
+        for (size_t i = 0; i < count; ++i)
+            matrices[i] = composeGlm(translations[i], quats[i], scales[i]);
+        bench::keep(matrices[0]);
+    });
+    batchMs = bench::bestMs([&] {
+        batch::compose(translationBatch, quatBatch, scaleBatch, matrixBatch);
+        bench::keep(matrixBatch.e[0][0]);
+    });
+    report("compose", count, glmMs, batchMs, maxDifference(matrices, matrixBatch));
+
+    // A whole pose: blend the keys, then build the bone matrices.
+    glmMs = bench::bestMs([&] {
+        for (size_t i = 0; i < count; ++i)
+            matrices[i] = composeGlm(translations[i], glm::slerp(from[i], to[i], t[i]), scales[i]);
+        bench::keep(matrices[0]);
+    });
+    batchMs = bench::bestMs([&] {
+        batch::slerp(fromBatch, toBatch, t, quatBatch);
+        batch::compose(translationBatch, quatBatch, scaleBatch, matrixBatch);
+        bench::keep(matrixBatch.e[0][0]);
+    });
+    report("slerp + compose", count, glmMs, batchMs, maxDifference(matrices, matrixBatch));
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::printf("SIMD level: %s\n", simd::levelName(simd::runtimeLevel()));
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i)
+            run(std::strtoul(argv[i], nullptr, 10));
+    } else {
+        for (size_t count : {1000, 10000, 100000})
+            run(count);
+    }
+    return 0;
+}
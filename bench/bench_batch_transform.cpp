@@ -0,0 +1,127 @@
+// Batched SoA matrix kernels against one glm::operator* per object.
+//
+//     bench_batch_transform [objects...]
+#include "bench.hpp"
+#include "include/batch_transform.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+float maxDifference(const glm::mat4 *a, const glm::mat4 *b, size_t count) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < count; ++i)
+        for (int c = 0; c < 4; ++c)
+            for (int r = 0; r < 4; ++r)
+                worst = std::max(worst, std::fabs(a[i][c][r] - b[i][c][r]));
+    return worst;
+}
+
+void report(const char *name, size_t count, double glmMs, double batchMs, float difference) {
+    std::printf("  %-28s %9.3f ms %9.3f ms %7.1f M/s %6.2fx   max diff %.2g\n", name, glmMs, batchMs,
+                count / batchMs / 1e3, glmMs / batchMs, difference);
+}
+
+void run(size_t count) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f), offset(-100.0f, 100.0f);
+    std::vector<glm::mat4> models(count), parents(count);
+    std::vector<glm::vec4> points(count);
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 axis = glm::normalize(glm::vec3(offset(rng), offset(rng), offset(rng)) + glm::vec3(0.01f));
+        models[i] = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(offset(rng), offset(rng), offset(rng))),
+                                angle(rng), axis);
+        parents[i] = glm::translate(glm::mat4(1.0f), glm::vec3(offset(rng), 0.0f, offset(rng)));
+        points[i] = glm::vec4(offset(rng), offset(rng), offset(rng), 1.0f);
+    }
+    glm::mat4 viewProjection = glm::perspective(1.0f, 16.0f / 9.0f, 0.1f, 500.0f) *
+                               glm::lookAt(glm::vec3(0, 50, 200), glm::vec3(0), glm::vec3(0, 1, 0));
+
+    batch::Mat4Batch soaModels(models.data(), count), soaParents(parents.data(), count), soaOut(count);
+    batch::Vec4Batch soaPoints(points.data(), count), soaTransformed(count);
+    std::vector<glm::mat4> glmOut(count), batchOut(count);
+    std::vector<glm::vec4> glmPoints(count);
+
+    std::printf("%zu objects\n  %-28s %12s %12s %11s %7s\n", count, "", "glm", "batch", "batch rate", "speedup");
+
+    double glmMs = bench::bestMs([&] {
+        for (size_t i = 0; i < count; ++i)
+            glmOut[i] = parents[i] * models[i];
+        bench::keep(glmOut[0]);
+    });
+    double batchMs = bench::bestMs([&] {
+        batch::multiply(soaParents, soaModels, soaOut);
+        bench::keep(soaOut.e[0][0]);
+    });
+    soaOut.copyTo(batchOut.data());
+    report("parent * model", count, glmMs, batchMs, maxDifference(glmOut.data(), batchOut.data(), count));
+
+    glmMs = bench::bestMs([&] {
+        for (size_t i = 0; i < count; ++i)
+            glmOut[i] = viewProjection * models[i];
+        bench::keep(glmOut[0]);
+    });
+    batchMs = bench::bestMs([&] {
+        batch::multiply(viewProjection, soaModels, soaOut);
+        bench::keep(soaOut.e[0][0]);
+    });
+    soaOut.copyTo(batchOut.data());
+    report("viewProjection * model", count, glmMs, batchMs, maxDifference(glmOut.data(), batchOut.data(), count));
+
+    glmMs = bench::bestMs([&] {
+        for (size_t i = 0; i < count; ++i)
+            glmPoints[i] = models[i] * points[i];
+        bench::keep(glmPoints[0]);
+    });
+    batchMs = bench::bestMs([&] {
+        batch::transform(soaModels, soaPoints, soaTransformed);
+        bench::keep(soaTransformed.e[0][0]);
+    });
+    float pointDifference = 0.0f;
+    for (size_t i = 0; i < count; ++i)
+        for (int c = 0; c < 4; ++c)
+            pointDifference = std::max(pointDifference, std::fabs(glmPoints[i][c] - soaTransformed.e[c][i]));
+    report("model * point", count, glmMs, batchMs, pointDifference);
+
+    glmMs = bench::bestMs([&] {
+        for (size_t i = 0; i < count; ++i)
+            glmOut[i] = glm::inverse(models[i]);
+        bench::keep(glmOut[0]);
+    });
+    batchMs = bench::bestMs([&] {
+        batch::inverse(soaModels, soaOut);
+        bench::keep(soaOut.e[0][0]);
+    });
+    soaOut.copyTo(batchOut.data());
+    report("inverse(model)", count, glmMs, batchMs, maxDifference(glmOut.data(), batchOut.data(), count));
+
+    // The AoS wrapper pays for converting in and out of SoA every call.
+    glmMs = bench::bestMs([&] {
+        for (size_t i = 0; i < count; ++i)
+            glmOut[i] = parents[i] * models[i];
+        bench::keep(glmOut[0]);
+    });
+    batchMs = bench::bestMs([&] {
+        batch::multiply(parents.data(), models.data(), batchOut.data(), count);
+        bench::keep(batchOut[0]);
+    });
+    report("parent * model (AoS wrapper)", count, glmMs, batchMs, maxDifference(glmOut.data(), batchOut.data(), count));
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::printf("SIMD level: %s\n", simd::levelName(simd::runtimeLevel()));
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i)
+            run(std::strtoul(argv[i], nullptr, 10));
+    } else {
+        for (size_t count : {1000, 10000, 100000})
+            run(count);
+    }
+    return 0;
+}
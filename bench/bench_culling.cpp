@@ -0,0 +1,117 @@
+// SIMD frustum culling against a per-object plane loop, in objects tested per
+// microsecond.
+//
+//     bench_culling_level<N> [objects...]
+#include "bench.hpp"
+#include "include/culling.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct Sphere {
+    glm::vec3 center;
+    float radius;
+};
+
+struct Box {
+    glm::vec3 center, extent;
+};
+
+// What a renderer without culling.hpp would write.
+size_t cullLoop(const culling::Frustum &frustum, const std::vector<Sphere> &spheres, std::vector<uint32_t> &visible) {
+    visible.clear();
+    for (size_t i = 0; i < spheres.size(); ++i) {
+        bool inside = true;
+        for (const glm::vec4 &p : frustum.planes)
+            inside = inside && glm::dot(glm::vec3(p), spheres[i].center) + p.w >= -spheres[i].radius;
+        if (inside)
+            visible.push_back(uint32_t(i));
+    }
+    return visible.size();
+}
+
+size_t cullLoop(const culling::Frustum &frustum, const std::vector<Box> &boxes, std::vector<uint32_t> &visible) {
+    visible.clear();
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        bool inside = true;
+        for (const glm::vec4 &p : frustum.planes) {
+            float radius = glm::dot(glm::abs(glm::vec3(p)), boxes[i].extent);
+            inside = inside && glm::dot(glm::vec3(p), boxes[i].center) + p.w >= -radius;
+        }
+        if (inside)
+            visible.push_back(uint32_t(i));
+    }
+    return visible.size();
+}
+
+void report(const char *name, size_t count, double loopMs, double simdMs, size_t loopVisible, size_t simdVisible) {
+    std::printf("  %-8s %9.1f %9.1f %7.2fx   %zu visible%s\n", name, count / loopMs / 1e3, count / simdMs / 1e3,
+                loopMs / simdMs, simdVisible, loopVisible == simdVisible ? "" : " (MISMATCH)");
+}
+
+void run(size_t count) {
+    // Objects scattered around a camera with a 60 degree field of view, so
+    // roughly a tenth of them survive.
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> offset(-500.0f, 500.0f), size(0.5f, 5.0f);
+    std::vector<Sphere> sphereList(count);
+    std::vector<Box> boxList(count);
+    culling::SphereBatch spheres;
+    culling::AabbBatch boxes;
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 center(offset(rng), offset(rng), offset(rng));
+        glm::vec3 extent(size(rng), size(rng), size(rng));
+        sphereList[i] = { center, glm::length(extent) };
+        boxList[i] = { center, extent };
+        spheres.push(center, glm::length(extent));
+        boxes.push(center - extent, center + extent);
+    }
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 600.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.3f, 0.1f, -1.0f), glm::vec3(0, 1, 0));
+    culling::Frustum frustum = culling::Frustum::fromViewProjection(projection * view);
+
+    std::vector<uint32_t> visible;
+    visible.reserve(count);
+    size_t loopVisible = 0, simdVisible = 0;
+
+    std::printf("%zu objects, tested per microsecond\n  %-8s %9s %9s %8s\n", count, "", "loop", "culling",
+                "speedup");
+    double loopMs = bench::bestMs([&] {
+        loopVisible = cullLoop(frustum, sphereList, visible);
+        bench::keep(visible[0]);
+    });
+    double simdMs = bench::bestMs([&] {
+        simdVisible = culling::cull(frustum, spheres, visible);
+        bench::keep(visible[0]);
+    });
+    report("spheres", count, loopMs, simdMs, loopVisible, simdVisible);
+
+    loopMs = bench::bestMs([&] {
+        loopVisible = cullLoop(frustum, boxList, visible);
+        bench::keep(visible[0]);
+    });
+    simdMs = bench::bestMs([&] {
+        simdVisible = culling::cull(frustum, boxes, visible);
+        bench::keep(visible[0]);
+    });
+    report("boxes", count, loopMs, simdMs, loopVisible, simdVisible);
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::printf("SIMD level: %s\n", simd::levelName(simd::runtimeLevel()));
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i)
+            run(std::strtoul(argv[i], nullptr, 10));
+    } else {
+        for (size_t count : {10000, 100000, 1000000})
+            run(count);
+    }
+    return 0;
+}
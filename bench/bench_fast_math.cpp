@@ -0,0 +1,110 @@
+// fastmath::Fast against fastmath::Exact and a plain libm loop: time per
+// million inputs and the largest error against double.
+//
+//     bench_fast_math_level<N> [inputs]
+#include "bench.hpp"
+#include "include/fast_math.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+enum class Error { Absolute, Relative };
+
+struct Function {
+    const char *name;
+    float low, high;
+    Error error;
+    float (*libm)(float);
+    double (*reference)(double);
+    void (*exact)(const float *, float *, size_t);
+    void (*fast)(const float *, float *, size_t);
+};
+
+float rsqrtf(float x) { return 1.0f / std::sqrt(x); }
+double rsqrtd(double x) { return 1.0 / std::sqrt(x); }
+float sinf(float x) { return std::sin(x); }
+double sind(double x) { return std::sin(x); }
+float cosf(float x) { return std::cos(x); }
+double cosd(double x) { return std::cos(x); }
+float expf(float x) { return std::exp(x); }
+double expd(double x) { return std::exp(x); }
+
+// The ranges fast_math.hpp documents its bounds over.
+const Function functions[] = {
+    { "sin", -1e4f, 1e4f, Error::Absolute, sinf, sind, fastmath::sin<fastmath::Exact>, fastmath::sin<fastmath::Fast> },
+    { "cos", -1e4f, 1e4f, Error::Absolute, cosf, cosd, fastmath::cos<fastmath::Exact>, fastmath::cos<fastmath::Fast> },
+    { "rsqrt", 1e-30f, 1e30f, Error::Relative, rsqrtf, rsqrtd, fastmath::rsqrt<fastmath::Exact>,
+      fastmath::rsqrt<fastmath::Fast> },
+    { "exp", -87.0f, 88.0f, Error::Relative, expf, expd, fastmath::exp<fastmath::Exact>, fastmath::exp<fastmath::Fast> },
+};
+
+std::vector<float> inputs(const Function &f, size_t count) {
+    std::mt19937 rng(5);
+    std::vector<float> in(count);
+    if (f.error == Error::Relative && f.low > 0.0f) {
+        // Spread over the exponents rather than piling up near the top.
+        std::uniform_real_distribution<float> exponent(std::log2(f.low), std::log2(f.high));
+        for (float &x : in)
+            x = std::exp2(exponent(rng));
+    } else {
+        std::uniform_real_distribution<float> value(f.low, f.high);
+        for (float &x : in)
+            x = value(rng);
+    }
+    return in;
+}
+
+double maxError(const Function &f, const std::vector<float> &in, const std::vector<float> &out) {
+    double worst = 0.0;
+    for (size_t i = 0; i < in.size(); ++i) {
+        double expected = f.reference(in[i]), difference = std::fabs(out[i] - expected);
+        worst = std::max(worst, f.error == Error::Relative ? difference / std::fabs(expected) : difference);
+    }
+    return worst;
+}
+
+void run(size_t count) {
+    std::printf("%zu inputs, ms per million and max error against double\n  %-6s %-4s %8s %8s %8s %8s   %9s %9s\n",
+                count, "", "", "libm", "Exact", "Fast", "speedup", "Exact", "Fast");
+    for (const Function &f : functions) {
+        std::vector<float> in = inputs(f, count), out(count);
+        double libmMs = bench::bestMs([&] {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = f.libm(in[i]);
+            bench::keep(out[0]);
+        });
+        double exactMs = bench::bestMs([&] {
+            f.exact(in.data(), out.data(), count);
+            bench::keep(out[0]);
+        });
+        double exactError = maxError(f, in, out);
+        double fastMs = bench::bestMs([&] {
+            f.fast(in.data(), out.data(), count);
+            bench::keep(out[0]);
+        });
+        double fastError = maxError(f, in, out);
+        double perMillion = 1e6 / count;
+        std::printf("  %-6s %-4s %8.3f %8.3f %8.3f %7.1fx   %9.2g %9.2g\n", f.name,
+                    f.error == Error::Relative ? "rel" : "abs", libmMs * perMillion, exactMs * perMillion,
+                    fastMs * perMillion, exactMs / fastMs, exactError, fastError);
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::printf("SIMD level: %s\n", simd::levelName(simd::runtimeLevel()));
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i)
+            run(std::strtoul(argv[i], nullptr, 10));
+    } else {
+        // 16K inputs stay in L1; 4M don't.
+        for (size_t count : {16384, 4194304})
+            run(count);
+    }
+    return 0;
+}
@@ -0,0 +1,185 @@
+// One glDrawElementsInstanced call through InstanceBuffer against one
+// glDrawElements call per object, with its uniforms set each time. Opens a
+// hidden window, so it needs a display and a GL 3.3 driver.
+//
+//     bench_instancing [instances...]
+#include "glad/glad.h" // glad must go b4 glfw
+#include "bench.hpp"
+#include "include/instancing.hpp"
+#include "include/shader.hpp"
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+const int frames = 30;
+
+struct FrameTimes {
+    double cpuMs = 0.0;   // filling the data and issuing GL calls
+    double frameMs = 0.0; // until glFinish returns
+    double gpuMs = 0.0;   // GL_TIME_ELAPSED
+};
+
+/// Averages `frames` calls of drawFrame() after one warm-up call.
+template <class Fn>
+FrameTimes measure(Fn drawFrame) {
+    using clock = std::chrono::steady_clock;
+    GLuint query;
+    glGenQueries(1, &query);
+    drawFrame();
+    glFinish();
+
+    FrameTimes total;
+    for (int frame = 0; frame < frames; ++frame) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        auto start = clock::now();
+        drawFrame();
+        auto issued = clock::now();
+        glEndQuery(GL_TIME_ELAPSED);
+        glFinish();
+        auto finished = clock::now();
+
+        GLuint64 gpuNs = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpuNs);
+        total.cpuMs += std::chrono::duration<double, std::milli>(issued - start).count();
+        total.frameMs += std::chrono::duration<double, std::milli>(finished - start).count();
+        total.gpuMs += gpuNs / 1e6;
+    }
+    glDeleteQueries(1, &query);
+    return { total.cpuMs / frames, total.frameMs / frames, total.gpuMs / frames };
+}
+
+void report(const char *name, size_t drawCalls, const FrameTimes &t) {
+    std::printf("  %-10s %10zu %9.3f %9.3f %9.3f\n", name, drawCalls, t.cpuMs, t.gpuMs, t.frameMs);
+}
+
+// The objects move every frame, so both paths rebuild their matrices.
+void fillInstances(std::vector<InstanceData> &instances, float time) {
+    size_t side = 1;
+    while (side * side < instances.size())
+        ++side;
+    float cell = 2.0f / side;
+    for (size_t i = 0; i < instances.size(); ++i) {
+        glm::vec3 position(-1.0f + cell * (i % side + 0.5f), -1.0f + cell * (i / side + 0.5f), 0.0f);
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+        model = glm::rotate(model, time + i * 0.01f, glm::vec3(0.0f, 0.0f, 1.0f));
+        instances[i].model = glm::scale(model, glm::vec3(cell * 0.8f));
+        instances[i].color = glm::vec4(1.0f);
+        instances[i].layer = 0.0f;
+    }
+}
+
+void run(size_t count, unsigned int vao, const Shader &perObject, const Shader &instanced) {
+    std::vector<InstanceData> instances(count);
+    InstanceBuffer buffer(vao);
+    float time = 0.0f;
+
+    std::printf("%zu instances, ms per frame (%d frames)\n  %-10s %10s %9s %9s %9s\n", count, frames, "",
+                "draw calls", "CPU", "GPU", "frame");
+
+    // Uniform locations are looked up once, which flatters this path: the
+    // Shader setters look them up on every call.
+    perObject.use();
+    GLint modelLocation = glGetUniformLocation(perObject.ID, "model");
+    GLint colorLocation = glGetUniformLocation(perObject.ID, "instanceColor");
+    GLint layerLocation = glGetUniformLocation(perObject.ID, "layer");
+    FrameTimes naive = measure([&] {
+        fillInstances(instances, time += 0.01f);
+        perObject.use();
+        glBindVertexArray(vao);
+        for (const InstanceData &instance : instances) {
+            glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(instance.model));
+            glUniform4fv(colorLocation, 1, glm::value_ptr(instance.color));
+            glUniform1f(layerLocation, instance.layer);
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+        }
+    });
+    report("per object", count, naive);
+
+    FrameTimes batched = measure([&] {
+        fillInstances(instances, time += 0.01f);
+        instanced.use();
+        buffer.update(instances);
+        buffer.draw(6);
+    });
+    report("instanced", 1, batched);
+}
+
+}
+
+int main(int argc, char **argv) {
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *window = glfwCreateWindow(800, 600, "bench_instancing", NULL, NULL);
+    if (window == NULL) {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    std::printf("%s\n", reinterpret_cast<const char *>(glGetString(GL_RENDERER)));
+
+    Shader perObject(SHADER_DIR "uniformModel.vert", SHADER_DIR "instanced.frag");
+    Shader instanced(SHADER_DIR "instanced.vert", SHADER_DIR "instanced.frag");
+    for (const Shader *shader : { &perObject, &instanced }) {
+        shader->use();
+        glUniformMatrix4fv(glGetUniformLocation(shader->ID, "viewProjection"), 1, GL_FALSE,
+                           glm::value_ptr(glm::mat4(1.0f)));
+        shader->setUniformInt("textures", 0);
+    }
+
+    // One quad: position, colour, texture coordinates.
+    float vertices[] = {
+        0.5f,  0.5f, 0.0f,   1.0f, 1.0f, 1.0f,   1.0f, 1.0f,
+        0.5f, -0.5f, 0.0f,   1.0f, 1.0f, 1.0f,   1.0f, 0.0f,
+       -0.5f, -0.5f, 0.0f,   1.0f, 1.0f, 1.0f,   0.0f, 0.0f,
+       -0.5f,  0.5f, 0.0f,   1.0f, 1.0f, 1.0f,   0.0f, 1.0f,
+    };
+    unsigned int indices[] = { 0, 1, 3, 1, 2, 3 };
+    unsigned int vao, vbo, ebo;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i)
+            run(std::strtoul(argv[i], nullptr, 10), vao, perObject, instanced);
+    } else {
+        for (size_t count : {10000, 50000, 100000})
+            run(count, vao, perObject, instanced);
+    }
+
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ebo);
+    glDeleteVertexArrays(1, &vao);
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Throughput per core of the two-at-a-time AVX2/FMA mat4 kernels against glm,
+// on camera and skinning workloads.
+//
+//     bench_mat4_pair [matrices...]
+#include "bench.hpp"
+#include "include/mat4_pair.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+void report(const char *name, size_t count, double glmMs, double pairMs) {
+    std::printf("  %-34s %9.1f %9.1f %7.2fx\n", name, count / glmMs / 1e3, count / pairMs / 1e3, glmMs / pairMs);
+}
+
+void run(size_t count) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f), offset(-50.0f, 50.0f);
+    std::vector<glm::mat4> projections(count), views(count), bones(count), inverseBinds(count);
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 eye(offset(rng), offset(rng), offset(rng));
+        projections[i] = glm::perspective(0.8f, 16.0f / 9.0f, 0.1f, 500.0f);
+        views[i] = glm::lookAt(eye, eye + glm::vec3(unit(rng), unit(rng), 1.0f), glm::vec3(0, 1, 0));
+        glm::quat rotation = glm::normalize(glm::quat(unit(rng), unit(rng), unit(rng), unit(rng)));
+        bones[i] = glm::translate(glm::mat4(1.0f), glm::vec3(offset(rng), offset(rng), offset(rng))) *
+                   glm::mat4_cast(rotation);
+        inverseBinds[i] = glm::inverse(glm::translate(glm::mat4(1.0f), glm::vec3(unit(rng), unit(rng), unit(rng))));
+    }
+    std::vector<glm::mat4> a(count), b(count);
+    std::vector<float> determinants(count);
+
+    std::printf("%zu matrices, M matrices/s on one core\n  %-34s %9s %9s %8s\n", count, "", "glm", "mat4pair",
+                "speedup");
+
+    // Camera: combine projection and view, then invert for unprojection.
+    double glmMs = bench::bestMs([&] {
+        for (size_t i = 0; i < count; ++i)
+            a[i] = projections[i] * views[i];
+        bench::keep(a[0]);
+    });
+    double pairMs = bench::bestMs([&] {
+        mat4pair::multiply(projections.data(), views.data(), b.data(), count);
+        bench::keep(b[0]);
+    });
+    report("camera: projection * view", count, glmMs, pairMs);
+
+    glmMs = bench::bestMs([&] {
+        for (size_t i = 0; i < count; ++i)
+            b[i] = glm::inverse(a[i]);
+        bench::keep(b[0]);
+    });
+    pairMs = bench::bestMs([&] {
+        mat4pair::inverse(a.data(), b.data(), count);
+        bench::keep(b[0]);
+    });
+    report("camera: inverse(viewProjection)", count, glmMs, pairMs);
+
+    // Skinning: bone * inverse bind, then the normal matrix.
+    glmMs = bench::bestMs([&] {
+        for (size_t i = 0; i < count; ++i)
+            a[i] = bones[i] * inverseBinds[i];
+        bench::keep(a[0]);
+    });
+    pairMs = bench::bestMs([&] {
+        mat4pair::multiply(bones.data(), inverseBinds.data(), a.data(), count);
+        bench::keep(a[0]);
+    });
+    report("skinning: bone * inverseBind", count, glmMs, pairMs);
+
+    glmMs = bench::bestMs([&] {
+        for (size_t i = 0; i < count; ++i)
+            b[i] = glm::transpose(glm::inverse(a[i]));
+        bench::keep(b[0]);
+    });
+    pairMs = bench::bestMs([&] {
+        mat4pair::inverse(a.data(), b.data(), count);
+        mat4pair::transpose(b.data(), b.data(), count);
+        bench::keep(b[0]);
+    });
+    report("skinning: transpose(inverse(skin))", count, glmMs, pairMs);
+
+    glmMs = bench::bestMs([&] {
+        for (size_t i = 0; i < count; ++i)
+            determinants[i] = glm::determinant(a[i]);
+        bench::keep(determinants[0]);
+    });
+    pairMs = bench::bestMs([&] {
+        mat4pair::determinant(a.data(), determinants.data(), count);
+        bench::keep(determinants[0]);
+    });
+    report("skinning: determinant (mirroring)", count, glmMs, pairMs);
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (simd::runtimeLevel() < simd::Level::Avx2)
+        std::printf("No AVX2 on this CPU: mat4pair falls back to glm.\n");
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i)
+            run(std::strtoul(argv[i], nullptr, 10));
+    } else {
+        // 4096 matrices stay in L2; 262144 don't.
+        for (size_t count : {4096, 262144})
+            run(count);
+    }
+    return 0;
+}
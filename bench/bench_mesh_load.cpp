@@ -0,0 +1,84 @@
+// Loading a mesh from OBJ text against opening the cooked file obj2mesh
+// writes, up to the point where vertex and index bytes are ready for
+// glBufferData. The files are read from the page cache, so this is the
+// parsing cost, not the disk. Only LOD 0 of the cooked file is taken, which
+// is what the OBJ holds.
+//
+//     bench_mesh_load [model.obj model.mesh]
+#include "bench.hpp"
+#include "include/mesh_format.hpp"
+#include "include/obj_import.hpp"
+#include "include/vertex_pack.hpp"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Where the bytes would go: glBufferData copies them out in the same way.
+struct Upload {
+    size_t vertexCount = 0;
+    std::vector<unsigned char> vertices;
+    std::vector<uint32_t> indices;
+};
+
+Upload loadObj(const std::string &path) {
+    obj::Mesh mesh = obj::load(path);
+    // The attributes obj2mesh cooks with, so both paths end with the same
+    // vertex format.
+    vertexpack::PackedVertices packed = vertexpack::pack(mesh.vertices.data(), mesh.vertexCount(),
+                                                         obj::Mesh::floatsPerVertex, {
+        { 0, 3, vertexpack::Format::Float, 0 },
+        { 1, 3, vertexpack::Format::Snorm10x3_2, 3 },
+        { 2, 2, vertexpack::Format::Half, 6 },
+    });
+    return { packed.count, std::move(packed.data), std::move(mesh.indices) };
+}
+
+Upload loadMesh(const std::string &path) {
+    meshfile::MeshFile file(path);
+    Upload upload;
+    if (!file)
+        return upload;
+    const auto *vertices = static_cast<const unsigned char *>(file.vertices());
+    upload.vertexCount = file.vertexCount();
+    upload.vertices.assign(vertices, vertices + file.vertexBytes());
+    const meshfile::LodRecord &lod = file.lod(0);
+    upload.indices.assign(file.indices() + lod.firstIndex, file.indices() + lod.firstIndex + lod.indexCount);
+    return upload;
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::string objPath = MESH_DIR "torus.obj", meshPath = MESH_DIR "torus.mesh";
+    if (argc == 3) {
+        objPath = argv[1];
+        meshPath = argv[2];
+    } else if (argc != 1) {
+        std::printf("Usage: bench_mesh_load [model.obj model.mesh]\n");
+        return 1;
+    }
+
+    Upload fromObj, fromMesh;
+    double objMs = bench::bestMs([&] {
+        fromObj = loadObj(objPath);
+        bench::keep(fromObj);
+    });
+    double meshMs = bench::bestMs([&] {
+        fromMesh = loadMesh(meshPath);
+        bench::keep(fromMesh);
+    });
+    if (fromObj.indices.empty() || fromMesh.indices.empty())
+        return 1;
+
+    // The cooked file has been reordered, so only sizes are comparable.
+    std::printf("%-36s %10s %10s %10s\n", "", "ms", "vertices", "indices");
+    std::printf("%-36s %10.3f %10zu %10zu\n", objPath.c_str(), objMs, fromObj.vertexCount,
+                fromObj.indices.size());
+    std::printf("%-36s %10.3f %10zu %10zu\n", meshPath.c_str(), meshMs, fromMesh.vertexCount,
+                fromMesh.indices.size());
+    std::printf("cooked file loads %.0fx faster\n", objMs / meshMs);
+    return 0;
+}
@@ -0,0 +1,97 @@
+// SceneGraph::update() over a wide hierarchy, on the calling thread and split
+// across defaultJobPool(). Unlike the other benchmarks this one is meant to
+// use every core; the aim is 100k nodes in under a millisecond.
+//
+//     bench_scene_graph [nodes...]
+#include "bench.hpp"
+#include "include/scene_graph.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+void run(size_t count) {
+    // 100 roots and eight children per node, so about six levels whose
+    // widths grow until they are big enough to split.
+    constexpr size_t roots = 100, fanout = 8;
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> offset(-2.0f, 2.0f), angle(-3.14159f, 3.14159f);
+    auto randomTransform = [&] {
+        Transform t;
+        t.translation = glm::vec3(offset(rng), offset(rng), offset(rng));
+        t.rotation = glm::angleAxis(angle(rng), glm::normalize(glm::vec3(offset(rng), offset(rng), 1.0f)));
+        t.scale = glm::vec3(0.9f);
+        return t;
+    };
+
+    SceneGraph graph;
+    for (size_t i = 0; i < count; ++i) {
+        SceneGraph::NodeId parent = i < roots ? SceneGraph::none : SceneGraph::NodeId((i - roots) / fanout);
+        graph.addNode(parent, randomTransform());
+    }
+    graph.update(nullptr);
+
+    // A hundredth of the nodes moving, as in a scene where most things stand
+    // still. Touching a root instead dirties its whole subtree.
+    std::vector<SceneGraph::NodeId> moving;
+    std::vector<Transform> movingTransforms;
+    for (size_t i = 0; i < count / 100; ++i) {
+        moving.push_back(SceneGraph::NodeId(rng() % count));
+        movingTransforms.push_back(randomTransform());
+    }
+    std::vector<Transform> rootTransforms;
+    for (size_t i = 0; i < roots && i < count; ++i)
+        rootTransforms.push_back(graph.local(SceneGraph::NodeId(i)));
+
+    auto touchRoots = [&] {
+        for (size_t i = 0; i < rootTransforms.size(); ++i)
+            graph.setLocal(SceneGraph::NodeId(i), rootTransforms[i]);
+    };
+    auto touchSome = [&] {
+        for (size_t i = 0; i < moving.size(); ++i)
+            graph.setLocal(moving[i], movingTransforms[i]);
+    };
+    JobPool &pool = defaultJobPool();
+
+    std::printf("%zu nodes, ms per update\n  %-12s %9s %9s %8s\n", count, "", "1 thread",
+                "pool", "speedup");
+    double serialMs = bench::bestMs([&] {
+        touchRoots();
+        graph.update(nullptr);
+        bench::keep(graph.world(SceneGraph::NodeId(count - 1)));
+    });
+    double poolMs = bench::bestMs([&] {
+        touchRoots();
+        graph.update(&pool);
+        bench::keep(graph.world(SceneGraph::NodeId(count - 1)));
+    });
+    std::printf("  %-12s %9.3f %9.3f %7.2fx\n", "all dirty", serialMs, poolMs, serialMs / poolMs);
+
+    serialMs = bench::bestMs([&] {
+        touchSome();
+        graph.update(nullptr);
+        bench::keep(graph.world(SceneGraph::NodeId(count - 1)));
+    });
+    poolMs = bench::bestMs([&] {
+        touchSome();
+        graph.update(&pool);
+        bench::keep(graph.world(SceneGraph::NodeId(count - 1)));
+    });
+    std::printf("  %-12s %9.3f %9.3f %7.2fx\n", "1% dirty", serialMs, poolMs, serialMs / poolMs);
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::printf("Threads: %u\n", defaultJobPool().threadCount());
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i)
+            run(std::strtoul(argv[i], nullptr, 10));
+    } else {
+        for (size_t count : {10000, 100000, 1000000})
+            run(count);
+    }
+    return 0;
+}
@@ -0,0 +1,319 @@
+#ifndef BATCH_QUAT_HPP
+#define BATCH_QUAT_HPP
+
+#include "batch_transform.hpp"
+#include <glm/gtc/quaternion.hpp>
+
+/**
+ * Many-quaternion kernels for skeletal animation: blending keyframes
+ * (nlerp/slerp), converting to rotation matrices and composing full TRS
+ * matrices, all in structure-of-arrays form and dispatched per ISA like the
+ * rest of batch_transform.hpp.
+ */
+namespace batch {
+
+/// N quaternions stored component-major: e[0..3] are x, y, z, w.
+struct QuatBatch {
+    std::array<std::vector<float>, 4> e;
+
+    QuatBatch() = default;
+    explicit QuatBatch(size_t count) { resize(count); }
+
+    size_t size() const { return e[0].size(); }
+
+    void resize(size_t count) {
+        for (std::vector<float> &v : e)
+            v.resize(count);
+    }
+
+    void set(size_t i, const glm::quat &q) {
+        e[0][i] = q.x;
+        e[1][i] = q.y;
+        e[2][i] = q.z;
+        e[3][i] = q.w;
+    }
+
+    glm::quat get(size_t i) const {
+        return glm::quat(e[3][i], e[0][i], e[1][i], e[2][i]);
+    }
+};
+
+struct Vec3Batch {
+    std::array<std::vector<float>, 3> e;
+
+    Vec3Batch() = default;
+    explicit Vec3Batch(size_t count) { resize(count); }
+
+    size_t size() const { return e[0].size(); }
+
+    void resize(size_t count) {
+        for (std::vector<float> &v : e)
+            v.resize(count);
+    }
+
+    void set(size_t i, const glm::vec3 &v) {
+        for (int c = 0; c < 3; ++c)
+            e[c][i] = v[c];
+    }
+
+    glm::vec3 get(size_t i) const {
+        return glm::vec3(e[0][i], e[1][i], e[2][i]);
+    }
+};
+
+/// Like Mat4Batch: e[column * 3 + row][i].
+struct Mat3Batch {
+    std::array<std::vector<float>, 9> e;
+
+    size_t size() const { return e[0].size(); }
+
+    void resize(size_t count) {
+        for (std::vector<float> &v : e)
+            v.resize(count);
+    }
+
+    glm::mat3 get(size_t i) const {
+        glm::mat3 m;
+        for (int c = 0; c < 3; ++c)
+            for (int r = 0; r < 3; ++r)
+                m[c][r] = e[c * 3 + r][i];
+        return m;
+    }
+};
+
+namespace detail {
+
+// Blend factor for element i: one shared value when stride is 0, otherwise
+// one per element.
+template <class O>
+inline typename O::Float loadBlend(const float *t, size_t stride, size_t i) {
+    return stride ? O::load(t + i) : O::set1(*t);
+}
+
+template <class Ops, class Math>
+struct NlerpKernel {
+    static void run(size_t count, const float *const *a, const float *const *b,
+                    const float *t, size_t tStride, float *const *out) {
+        simd::forEachBlock<Ops>(count, [&](auto ops, size_t i) {
+            using O = decltype(ops);
+            using F = typename O::Float;
+            F qa[4], qb[4];
+            for (int c = 0; c < 4; ++c) {
+                qa[c] = O::load(a[c] + i);
+                qb[c] = O::load(b[c] + i);
+            }
+            F dot = O::mul(qa[0], qb[0]);
+            for (int c = 1; c < 4; ++c)
+                dot = O::fmadd(qa[c], qb[c], dot);
+
+            // Blend towards -b when it's closer, so the shortest arc is taken.
+            F tb = O::flipSign(loadBlend<O>(t, tStride, i), dot);
+            F ta = O::sub(O::set1(1.0f), loadBlend<O>(t, tStride, i));
+            F r[4];
+            F lengthSq = O::set1(0.0f);
+            for (int c = 0; c < 4; ++c) {
+                r[c] = O::fmadd(qa[c], ta, O::mul(qb[c], tb));
+                lengthSq = O::fmadd(r[c], r[c], lengthSq);
+            }
+            F invLength = Math::template rsqrt<O>(lengthSq);
+            for (int c = 0; c < 4; ++c)
+                O::store(out[c] + i, O::mul(r[c], invLength));
+        });
+    }
+};
+
+/**
+ * Slerp without acos or sin, using Eberly's polynomial approximation ("A Fast
+ * and Accurate Algorithm for Computing SLERP", 2011). With eight terms the
+ * error stays under 2e-5 across all angles and shrinks quickly as the
+ * inputs get closer, which is the usual case between keyframes.
+ */
+template <class Ops>
+struct SlerpKernel {
+    static void run(size_t count, const float *const *a, const float *const *b,
+                    const float *t, size_t tStride, float *const *out) {
+        const float mu = 1.85298109240830f;
+        const float u[8] = {
+            1.0f / (1 * 3), 1.0f / (2 * 5), 1.0f / (3 * 7), 1.0f / (4 * 9),
+            1.0f / (5 * 11), 1.0f / (6 * 13), 1.0f / (7 * 15), mu / (8 * 17),
+        };
+        const float v[8] = {
+            1.0f / 3, 2.0f / 5, 3.0f / 7, 4.0f / 9,
+            5.0f / 11, 6.0f / 13, 7.0f / 15, mu * 8 / 17,
+        };
+
+        simd::forEachBlock<Ops>(count, [&](auto ops, size_t i) {
+            using O = decltype(ops);
+            using F = typename O::Float;
+            F qa[4], qb[4];
+            for (int c = 0; c < 4; ++c) {
+                qa[c] = O::load(a[c] + i);
+                qb[c] = O::load(b[c] + i);
+            }
+            F dot = O::mul(qa[0], qb[0]);
+            for (int c = 1; c < 4; ++c)
+                dot = O::fmadd(qa[c], qb[c], dot);
+
+            F ts = loadBlend<O>(t, tStride, i);
+            F ds = O::sub(O::set1(1.0f), ts);
+            F xm1 = O::sub(O::abs(dot), O::set1(1.0f));
+            F sqrT = O::mul(ts, ts);
+            F sqrD = O::mul(ds, ds);
+
+            // Horner evaluation from the innermost term outwards.
+            F cT = O::set1(1.0f), cD = O::set1(1.0f);
+            for (int k = 7; k >= 0; --k) {
+                F bT = O::mul(O::sub(O::mul(O::set1(u[k]), sqrT), O::set1(v[k])), xm1);
+                F bD = O::mul(O::sub(O::mul(O::set1(u[k]), sqrD), O::set1(v[k])), xm1);
+                cT = O::fmadd(bT, cT, O::set1(1.0f));
+                cD = O::fmadd(bD, cD, O::set1(1.0f));
+            }
+            cT = O::flipSign(O::mul(ts, cT), dot);
+            cD = O::mul(ds, cD);
+
+            for (int c = 0; c < 4; ++c)
+                O::store(out[c] + i, O::fmadd(qa[c], cD, O::mul(qb[c], cT)));
+        });
+    }
+};
+
+// Rotation part of glm::mat3_cast, written to a 3x3 or the upper 3x3 of a
+// 4x4 (stride is the column length, 3 or 4). With scale and translation set
+// it builds the whole TRS matrix.
+template <class O>
+inline void storeRotation(const float *const *q, float *const *out, int stride, size_t i,
+                          const float *const *scale, const float *const *translation) {
+    using F = typename O::Float;
+    F x = O::load(q[0] + i), y = O::load(q[1] + i), z = O::load(q[2] + i), w = O::load(q[3] + i);
+    F two = O::set1(2.0f), one = O::set1(1.0f);
+    F xx = O::mul(x, x), yy = O::mul(y, y), zz = O::mul(z, z);
+    F xy = O::mul(x, y), xz = O::mul(x, z), yz = O::mul(y, z);
+    F wx = O::mul(w, x), wy = O::mul(w, y), wz = O::mul(w, z);
+
+    F m[9];
+    m[0] = O::sub(one, O::mul(two, O::add(yy, zz)));
+    m[1] = O::mul(two, O::add(xy, wz));
+    m[2] = O::mul(two, O::sub(xz, wy));
+    m[3] = O::mul(two, O::sub(xy, wz));
+    m[4] = O::sub(one, O::mul(two, O::add(xx, zz)));
+    m[5] = O::mul(two, O::add(yz, wx));
+    m[6] = O::mul(two, O::add(xz, wy));
+    m[7] = O::mul(two, O::sub(yz, wx));
+    m[8] = O::sub(one, O::mul(two, O::add(xx, yy)));
+
+    for (int c = 0; c < 3; ++c) {
+        F s = scale ? O::load(scale[c] + i) : one;
+        for (int r = 0; r < 3; ++r)
+            O::store(out[c * stride + r] + i, O::mul(m[c * 3 + r], s));
+    }
+    if (stride == 4) {
+        F zero = O::set1(0.0f);
+        for (int c = 0; c < 3; ++c)
+            O::store(out[c * 4 + 3] + i, zero);
+        for (int r = 0; r < 3; ++r)
+            O::store(out[12 + r] + i, translation ? O::load(translation[r] + i) : zero);
+        O::store(out[15] + i, one);
+    }
+}
+
+template <class Ops>
+struct RotationKernel {
+    static void run(size_t count, const float *const *q, float *const *out, int stride) {
+        simd::forEachBlock<Ops>(count, [&](auto ops, size_t i) {
+            storeRotation<decltype(ops)>(q, out, stride, i, nullptr, nullptr);
+        });
+    }
+};
+
+template <class Ops>
+struct ComposeKernel {
+    static void run(size_t count, const float *const *t, const float *const *q,
+                    const float *const *s, float *const *out) {
+        simd::forEachBlock<Ops>(count, [&](auto ops, size_t i) {
+            storeRotation<decltype(ops)>(q, out, 4, i, s, t);
+        });
+    }
+};
+
+}
+
+/**
+ * @brief Normalized lerp from a[i] to b[i] by t[i] along the shortest arc.
+ *
+ * Cheaper than slerp and fine for the small angles between neighbouring
+ * keyframes, though its speed along the arc isn't constant. With
+ * fastmath::Fast the renormalization uses the reciprocal square root
+ * estimate.
+ */
+template <class Math = fastmath::Default>
+inline void nlerp(const QuatBatch &a, const QuatBatch &b, const std::vector<float> &t, QuatBatch &out) {
+    size_t count = std::min({a.size(), b.size(), t.size()});
+    out.resize(count);
+    auto pa = detail::pointers<4>(a.e), pb = detail::pointers<4>(b.e);
+    auto po = detail::pointers<4>(out.e);
+    simd::dispatch<fastmath::WithMath<detail::NlerpKernel, Math>::template Kernel>(count, pa.data(), pb.data(), t.data(), size_t(1), po.data());
+}
+
+/// nlerp with one blend factor for every element.
+template <class Math = fastmath::Default>
+inline void nlerp(const QuatBatch &a, const QuatBatch &b, float t, QuatBatch &out) {
+    size_t count = std::min(a.size(), b.size());
+    out.resize(count);
+    auto pa = detail::pointers<4>(a.e), pb = detail::pointers<4>(b.e);
+    auto po = detail::pointers<4>(out.e);
+    simd::dispatch<fastmath::WithMath<detail::NlerpKernel, Math>::template Kernel>(count, pa.data(), pb.data(), &t, size_t(0), po.data());
+}
+
+/**
+ * @brief Spherical interpolation from a[i] to b[i] by t[i] along the shortest
+ *        arc. Inputs must be unit quaternions.
+ */
+inline void slerp(const QuatBatch &a, const QuatBatch &b, const std::vector<float> &t, QuatBatch &out) {
+    size_t count = std::min({a.size(), b.size(), t.size()});
+    out.resize(count);
+    auto pa = detail::pointers<4>(a.e), pb = detail::pointers<4>(b.e);
+    auto po = detail::pointers<4>(out.e);
+    simd::dispatch<detail::SlerpKernel>(count, pa.data(), pb.data(), t.data(), size_t(1), po.data());
+}
+
+/// slerp with one blend factor for every element.
+inline void slerp(const QuatBatch &a, const QuatBatch &b, float t, QuatBatch &out) {
+    size_t count = std::min(a.size(), b.size());
+    out.resize(count);
+    auto pa = detail::pointers<4>(a.e), pb = detail::pointers<4>(b.e);
+    auto po = detail::pointers<4>(out.e);
+    simd::dispatch<detail::SlerpKernel>(count, pa.data(), pb.data(), &t, size_t(0), po.data());
+}
+
+/// out[i] = glm::mat3_cast(q[i])
+inline void toMat3(const QuatBatch &q, Mat3Batch &out) {
+    out.resize(q.size());
+    auto pq = detail::pointers<4>(q.e);
+    auto po = detail::pointers<9>(out.e);
+    simd::dispatch<detail::RotationKernel>(q.size(), pq.data(), po.data(), 3);
+}
+
+/// out[i] = glm::mat4_cast(q[i])
+inline void toMat4(const QuatBatch &q, Mat4Batch &out) {
+    out.resize(q.size());
+    auto pq = detail::pointers<4>(q.e);
+    auto po = detail::pointers<16>(out.e);
+    simd::dispatch<detail::RotationKernel>(q.size(), pq.data(), po.data(), 4);
+}
+
+/**
+ * @brief out[i] = translate(t[i]) * mat4_cast(r[i]) * scale(s[i]), the same
+ *        order as Transform::matrix().
+ */
+inline void compose(const Vec3Batch &t, const QuatBatch &r, const Vec3Batch &s, Mat4Batch &out) {
+    size_t count = std::min({t.size(), r.size(), s.size()});
+    out.resize(count);
+    auto pt = detail::pointers<3>(t.e), ps = detail::pointers<3>(s.e);
+    auto pr = detail::pointers<4>(r.e);
+    auto po = detail::pointers<16>(out.e);
+    simd::dispatch<detail::ComposeKernel>(count, pt.data(), pr.data(), ps.data(), po.data());
+}
+
+}
+
+#endif
@@ -0,0 +1,393 @@
+#ifndef BATCH_TRANSFORM_HPP
+#define BATCH_TRANSFORM_HPP
+
+#include "fast_math.hpp"
+#include "simd.hpp"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Many-object matrix math in structure-of-arrays form.
+ *
+ * glm multiplies one matrix at a time, which leaves most of a SIMD register
+ * idle. Here element j of every matrix in a batch is stored contiguously, so
+ * one register holds the same element of 4, 8 or 16 matrices (SSE, AVX2,
+ * AVX-512) and each instruction advances that many objects at once.
+ *
+ * Every kernel is compiled for each ISA level and picked at runtime through
+ * simd::dispatch, so a baseline x86-64 build still runs AVX2 or AVX-512 code
+ * on machines that have it.
+ */
+namespace batch {
+
+/**
+ * N matrices stored element-major: e[column * 4 + row][i] is element
+ * (column, row) of matrix i, matching glm's column-major layout.
+ */
+struct Mat4Batch {
+    std::array<std::vector<float>, 16> e;
+
+    Mat4Batch() = default;
+    explicit Mat4Batch(size_t count) { resize(count); }
+
+    Mat4Batch(const glm::mat4 *matrices, size_t count) {
+        resize(count);
+        for (size_t i = 0; i < count; ++i)
+            set(i, matrices[i]);
+    }
+
+    size_t size() const { return e[0].size(); }
+
+    void resize(size_t count) {
+        for (std::vector<float> &v : e)
+            v.resize(count);
+    }
+
+    void set(size_t i, const glm::mat4 &m) {
+        for (int c = 0; c < 4; ++c)
+            for (int r = 0; r < 4; ++r)
+                e[c * 4 + r][i] = m[c][r];
+    }
+
+    glm::mat4 get(size_t i) const {
+        glm::mat4 m;
+        for (int c = 0; c < 4; ++c)
+            for (int r = 0; r < 4; ++r)
+                m[c][r] = e[c * 4 + r][i];
+        return m;
+    }
+
+    void copyTo(glm::mat4 *matrices) const {
+        for (size_t i = 0; i < size(); ++i)
+            matrices[i] = get(i);
+    }
+};
+
+/**
+ * N vectors stored component-major: e[component][i].
+ */
+struct Vec4Batch {
+    std::array<std::vector<float>, 4> e;
+
+    Vec4Batch() = default;
+    explicit Vec4Batch(size_t count) { resize(count); }
+
+    Vec4Batch(const glm::vec4 *vectors, size_t count) {
+        resize(count);
+        for (size_t i = 0; i < count; ++i)
+            set(i, vectors[i]);
+    }
+
+    size_t size() const { return e[0].size(); }
+
+    void resize(size_t count) {
+        for (std::vector<float> &v : e)
+            v.resize(count);
+    }
+
+    void set(size_t i, const glm::vec4 &v) {
+        for (int c = 0; c < 4; ++c)
+            e[c][i] = v[c];
+    }
+
+    glm::vec4 get(size_t i) const {
+        return glm::vec4(e[0][i], e[1][i], e[2][i], e[3][i]);
+    }
+
+    void copyTo(glm::vec4 *vectors) const {
+        for (size_t i = 0; i < size(); ++i)
+            vectors[i] = get(i);
+    }
+};
+
+namespace detail {
+
+// Every column of `a` is loaded before anything is stored, so out may alias
+// either input.
+template <class Ops>
+struct MultiplyKernel {
+    static void run(size_t count, const float *const *a, const float *const *b, float *const *out) {
+        simd::forEachBlock<Ops>(count, [&](auto ops, size_t i) {
+            using O = decltype(ops);
+            using F = typename O::Float;
+            F ar[16];
+            for (int j = 0; j < 16; ++j)
+                ar[j] = O::load(a[j] + i);
+
+            for (int c = 0; c < 4; ++c) {
+                F b0 = O::load(b[c * 4 + 0] + i);
+                F b1 = O::load(b[c * 4 + 1] + i);
+                F b2 = O::load(b[c * 4 + 2] + i);
+                F b3 = O::load(b[c * 4 + 3] + i);
+                for (int r = 0; r < 4; ++r) {
+                    F sum = O::mul(ar[r], b0);
+                    sum = O::fmadd(ar[4 + r], b1, sum);
+                    sum = O::fmadd(ar[8 + r], b2, sum);
+                    sum = O::fmadd(ar[12 + r], b3, sum);
+                    O::store(out[c * 4 + r] + i, sum);
+                }
+            }
+        });
+    }
+};
+
+// Same as MultiplyKernel with the left matrix shared by every element.
+template <class Ops>
+struct MultiplySharedKernel {
+    static void run(size_t count, const float *a, const float *const *b, float *const *out) {
+        simd::forEachBlock<Ops>(count, [&](auto ops, size_t i) {
+            using O = decltype(ops);
+            using F = typename O::Float;
+            for (int c = 0; c < 4; ++c) {
+                F b0 = O::load(b[c * 4 + 0] + i);
+                F b1 = O::load(b[c * 4 + 1] + i);
+                F b2 = O::load(b[c * 4 + 2] + i);
+                F b3 = O::load(b[c * 4 + 3] + i);
+                for (int r = 0; r < 4; ++r) {
+                    F sum = O::mul(O::set1(a[r]), b0);
+                    sum = O::fmadd(O::set1(a[4 + r]), b1, sum);
+                    sum = O::fmadd(O::set1(a[8 + r]), b2, sum);
+                    sum = O::fmadd(O::set1(a[12 + r]), b3, sum);
+                    O::store(out[c * 4 + r] + i, sum);
+                }
+            }
+        });
+    }
+};
+
+template <class Ops>
+struct TransformKernel {
+    static void run(size_t count, const float *const *m, const float *const *v, float *const *out) {
+        simd::forEachBlock<Ops>(count, [&](auto ops, size_t i) {
+            using O = decltype(ops);
+            using F = typename O::Float;
+            F v0 = O::load(v[0] + i);
+            F v1 = O::load(v[1] + i);
+            F v2 = O::load(v[2] + i);
+            F v3 = O::load(v[3] + i);
+            for (int r = 0; r < 4; ++r) {
+                F sum = O::mul(O::load(m[r] + i), v0);
+                sum = O::fmadd(O::load(m[4 + r] + i), v1, sum);
+                sum = O::fmadd(O::load(m[8 + r] + i), v2, sum);
+                sum = O::fmadd(O::load(m[12 + r] + i), v3, sum);
+                O::store(out[r] + i, sum);
+            }
+        });
+    }
+};
+
+// Cofactor inverse built from twelve 2x2 sub-determinants. It works on glm's
+// column-major storage unchanged because inverse(transpose(M)) is
+// transpose(inverse(M)).
+template <class Ops>
+struct InverseKernel {
+    static void run(size_t count, const float *const *m, float *const *out) {
+        simd::forEachBlock<Ops>(count, [&](auto ops, size_t i) {
+            using O = decltype(ops);
+            using F = typename O::Float;
+            F a[16];
+            for (int j = 0; j < 16; ++j)
+                a[j] = O::load(m[j] + i);
+            auto det2 = [](const F &p, const F &q, const F &r, const F &s) { return O::sub(O::mul(p, q), O::mul(r, s)); };
+
+            F s0 = det2(a[0], a[5], a[4], a[1]);
+            F s1 = det2(a[0], a[6], a[4], a[2]);
+            F s2 = det2(a[0], a[7], a[4], a[3]);
+            F s3 = det2(a[1], a[6], a[5], a[2]);
+            F s4 = det2(a[1], a[7], a[5], a[3]);
+            F s5 = det2(a[2], a[7], a[6], a[3]);
+            F c5 = det2(a[10], a[15], a[14], a[11]);
+            F c4 = det2(a[9], a[15], a[13], a[11]);
+            F c3 = det2(a[9], a[14], a[13], a[10]);
+            F c2 = det2(a[8], a[15], a[12], a[11]);
+            F c1 = det2(a[8], a[14], a[12], a[10]);
+            F c0 = det2(a[8], a[13], a[12], a[9]);
+
+            F det = O::sub(O::mul(s0, c5), O::mul(s1, c4));
+            det = O::fmadd(s2, c3, det);
+            det = O::fmadd(s3, c2, det);
+            det = O::sub(det, O::mul(s4, c1));
+            det = O::fmadd(s5, c0, det);
+            F invDet = O::div(O::set1(1.0f), det);
+
+            // x * p - y * q + z * r, scaled by invDet and optionally negated.
+            auto term = [&](const F &x, const F &p, const F &y, const F &q, const F &z, const F &r, bool negate) {
+                F t = O::fmadd(z, r, O::sub(O::mul(x, p), O::mul(y, q)));
+                return O::mul(t, negate ? O::sub(O::set1(0.0f), invDet) : invDet);
+            };
+
+            F b[16];
+            b[0]  = term(a[5], c5, a[6], c4, a[7], c3, false);
+            b[1]  = term(a[1], c5, a[2], c4, a[3], c3, true);
+            b[2]  = term(a[13], s5, a[14], s4, a[15], s3, false);
+            b[3]  = term(a[9], s5, a[10], s4, a[11], s3, true);
+            b[4]  = term(a[4], c5, a[6], c2, a[7], c1, true);
+            b[5]  = term(a[0], c5, a[2], c2, a[3], c1, false);
+            b[6]  = term(a[12], s5, a[14], s2, a[15], s1, true);
+            b[7]  = term(a[8], s5, a[10], s2, a[11], s1, false);
+            b[8]  = term(a[4], c4, a[5], c2, a[7], c0, false);
+            b[9]  = term(a[0], c4, a[1], c2, a[3], c0, true);
+            b[10] = term(a[12], s4, a[13], s2, a[15], s0, false);
+            b[11] = term(a[8], s4, a[9], s2, a[11], s0, true);
+            b[12] = term(a[4], c3, a[5], c1, a[6], c0, true);
+            b[13] = term(a[0], c3, a[1], c1, a[2], c0, false);
+            b[14] = term(a[12], s3, a[13], s1, a[14], s0, true);
+            b[15] = term(a[8], s3, a[9], s1, a[10], s0, false);
+
+            for (int j = 0; j < 16; ++j)
+                O::store(out[j] + i, b[j]);
+        });
+    }
+};
+
+template <class Ops, class Math>
+struct NormalizeKernel {
+    static void run(size_t count, const float *const *v, float *const *out) {
+        simd::forEachBlock<Ops>(count, [&](auto ops, size_t i) {
+            using O = decltype(ops);
+            using F = typename O::Float;
+            F x = O::load(v[0] + i);
+            F y = O::load(v[1] + i);
+            F z = O::load(v[2] + i);
+            F w = O::load(v[3] + i);
+            F lengthSq = O::mul(x, x);
+            lengthSq = O::fmadd(y, y, lengthSq);
+            lengthSq = O::fmadd(z, z, lengthSq);
+            lengthSq = O::fmadd(w, w, lengthSq);
+            F invLength = Math::template rsqrt<O>(lengthSq);
+            O::store(out[0] + i, O::mul(x, invLength));
+            O::store(out[1] + i, O::mul(y, invLength));
+            O::store(out[2] + i, O::mul(z, invLength));
+            O::store(out[3] + i, O::mul(w, invLength));
+        });
+    }
+};
+
+template <size_t N, size_t M>
+inline std::array<const float *, N> pointers(const std::array<std::vector<float>, M> &e) {
+    std::array<const float *, N> p;
+    for (size_t j = 0; j < N; ++j)
+        p[j] = e[j].data();
+    return p;
+}
+
+template <size_t N, size_t M>
+inline std::array<float *, N> pointers(std::array<std::vector<float>, M> &e) {
+    std::array<float *, N> p;
+    for (size_t j = 0; j < N; ++j)
+        p[j] = e[j].data();
+    return p;
+}
+
+}
+
+/**
+ * @brief out[i] = a[i] * b[i] for every i. out may alias a or b.
+ */
+inline void multiply(const Mat4Batch &a, const Mat4Batch &b, Mat4Batch &out) {
+    size_t count = std::min(a.size(), b.size());
+    out.resize(count);
+    auto pa = detail::pointers<16>(a.e);
+    auto pb = detail::pointers<16>(b.e);
+    auto po = detail::pointers<16>(out.e);
+    simd::dispatch<detail::MultiplyKernel>(count, pa.data(), pb.data(), po.data());
+}
+
+/**
+ * @brief out[i] = a * b[i] for every i, e.g. view-projection times every
+ *        model-to-world matrix. out may alias b.
+ */
+inline void multiply(const glm::mat4 &a, const Mat4Batch &b, Mat4Batch &out) {
+    size_t count = b.size();
+    out.resize(count);
+    auto pb = detail::pointers<16>(b.e);
+    auto po = detail::pointers<16>(out.e);
+    simd::dispatch<detail::MultiplySharedKernel>(count, &a[0][0], pb.data(), po.data());
+}
+
+/**
+ * @brief out[i] = m[i] * v[i] for every i. out may alias v.
+ */
+inline void transform(const Mat4Batch &m, const Vec4Batch &v, Vec4Batch &out) {
+    size_t count = std::min(m.size(), v.size());
+    out.resize(count);
+    auto pm = detail::pointers<16>(m.e);
+    auto pv = detail::pointers<4>(v.e);
+    auto po = detail::pointers<4>(out.e);
+    simd::dispatch<detail::TransformKernel>(count, pm.data(), pv.data(), po.data());
+}
+
+/**
+ * @brief out[i] = inverse(m[i]) for every i. out may alias m.
+ *
+ * Singular matrices come out as inf/NaN, the same as glm::inverse.
+ */
+inline void inverse(const Mat4Batch &m, Mat4Batch &out) {
+    out.resize(m.size());
+    auto pm = detail::pointers<16>(m.e);
+    auto po = detail::pointers<16>(out.e);
+    simd::dispatch<detail::InverseKernel>(m.size(), pm.data(), po.data());
+}
+
+/**
+ * @brief out[i] = normalize(v[i]) for every i. out may alias v.
+ *
+ * @tparam Math fastmath::Fast trades about 2.5e-7 relative error for the
+ * square root and divide.
+ */
+template <class Math = fastmath::Default>
+inline void normalize(const Vec4Batch &v, Vec4Batch &out) {
+    out.resize(v.size());
+    auto pv = detail::pointers<4>(v.e);
+    auto po = detail::pointers<4>(out.e);
+    simd::dispatch<fastmath::WithMath<detail::NormalizeKernel, Math>::template Kernel>(v.size(), pv.data(), po.data());
+}
+
+/**
+ * @brief AoS convenience: out[i] = a[i] * b[i] over plain glm::mat4 arrays.
+ *
+ * Converts through SoA scratch in fixed-size chunks, so it pays a transpose
+ * on the way in and out. Keep data in Mat4Batch when it's used every frame.
+ */
+inline void multiply(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *out, size_t count) {
+    const size_t chunk = 256;
+    Mat4Batch sa(chunk), sb(chunk);
+    for (size_t begin = 0; begin < count; begin += chunk) {
+        size_t n = std::min(chunk, count - begin);
+        sa.resize(n);
+        sb.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            sa.set(i, a[begin + i]);
+            sb.set(i, b[begin + i]);
+        }
+        multiply(sa, sb, sa);
+        sa.copyTo(out + begin);
+    }
+}
+
+/**
+ * @brief AoS convenience: out[i] = m[i] * v[i] over plain glm arrays.
+ */
+inline void transform(const glm::mat4 *m, const glm::vec4 *v, glm::vec4 *out, size_t count) {
+    const size_t chunk = 256;
+    Mat4Batch sm(chunk);
+    Vec4Batch sv(chunk);
+    for (size_t begin = 0; begin < count; begin += chunk) {
+        size_t n = std::min(chunk, count - begin);
+        sm.resize(n);
+        sv.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            sm.set(i, m[begin + i]);
+            sv.set(i, v[begin + i]);
+        }
+        transform(sm, sv, sv);
+        sv.copyTo(out + begin);
+    }
+}
+
+}
+
+#endif
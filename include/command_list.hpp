@@ -0,0 +1,228 @@
+#ifndef COMMAND_LIST_HPP
+#define COMMAND_LIST_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief GL calls recorded now, on any thread, and issued later on the thread
+ *        that owns the context.
+ *
+ * Only the context thread may call GL, but working out what to draw doesn't
+ * need GL at all. Give each worker its own CommandList, have it record what it
+ * would have called, then run the lists on the context thread:
+ *
+ *     std::vector<CommandList> lists(chunkCount);
+ *     pool.parallelFor(0, objects.size(), grain, [&](size_t begin, size_t end) {
+ *         CommandList &list = lists[begin / grain];
+ *         for (size_t i = begin; i < end; ++i) {
+ *             list.setMat4(modelLocation, objects[i].world);
+ *             list.drawElements(GL_TRIANGLES, objects[i].indexCount, GL_UNSIGNED_INT, 0);
+ *         }
+ *     });
+ *     for (CommandList &list : lists) {
+ *         list.execute();
+ *         list.reset();
+ *     }
+ *
+ * Commands are packed one after another into a byte stream as an opcode and a
+ * fixed-size payload. Anything variable-sized, like a uniform array, is copied
+ * into the list's arena and the command points at it. reset() rewinds both
+ * without freeing, so after the first few frames recording allocates nothing.
+ *
+ * @note A list is not thread safe; one writer at a time. Uniform locations
+ * must be looked up on the context thread beforehand.
+ */
+class CommandList {
+public:
+    CommandList() = default;
+    CommandList(CommandList &&) = default;
+    CommandList &operator=(CommandList &&) = default;
+
+    void useProgram(GLuint program) { record(Op::UseProgram, program); }
+    void bindVertexArray(GLuint vao) { record(Op::BindVertexArray, vao); }
+
+    void bindTexture(GLuint unit, GLenum target, GLuint texture) {
+        record(Op::BindTexture, BindTextureArgs{unit, target, texture});
+    }
+
+    void setInt(GLint location, int value) { record(Op::SetInt, SetIntArgs{location, value}); }
+    void setFloat(GLint location, float value) { record(Op::SetFloat, SetFloatArgs{location, value}); }
+    void setVec4(GLint location, const glm::vec4 &value) { record(Op::SetVec4, SetVec4Args{location, value}); }
+    void setMat4(GLint location, const glm::mat4 &value) { record(Op::SetMat4, SetMat4Args{location, value}); }
+
+    /// Copies `count` matrices into the arena.
+    void setMat4Array(GLint location, const glm::mat4 *values, GLsizei count) {
+        void *copy = allocate(count * sizeof(glm::mat4), alignof(glm::mat4));
+        std::memcpy(copy, values, count * sizeof(glm::mat4));
+        record(Op::SetMat4Array, SetArrayArgs{location, count, static_cast<const float *>(copy)});
+    }
+
+    void drawArrays(GLenum mode, GLint first, GLsizei count) {
+        record(Op::DrawArrays, DrawArraysArgs{mode, first, count});
+    }
+
+    /**
+     * @param offset Byte offset into the bound element buffer.
+     */
+    void drawElements(GLenum mode, GLsizei count, GLenum type, size_t offset, GLint baseVertex = 0, GLsizei instances = 1) {
+        record(Op::DrawElements, DrawElementsArgs{mode, count, type, instances, baseVertex, offset});
+    }
+
+    /**
+     * @brief Memory that stays valid until reset(), for data commands point
+     *        at.
+     */
+    void *allocate(size_t bytes, size_t align = 16) {
+        for (; current < blocks.size(); ++current) {
+            Block &block = blocks[current];
+            size_t start = (block.used + align - 1) & ~(align - 1);
+            if (start + bytes <= block.size) {
+                block.used = start + bytes;
+                return block.data.get() + start;
+            }
+        }
+        // new[] storage is 16-byte aligned, which covers everything recorded
+        // here; larger alignments aren't supported.
+        size_t size = std::max(blockSize, bytes);
+        blocks.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[size]), size, bytes});
+        current = blocks.size() - 1;
+        return blocks.back().data.get();
+    }
+
+    size_t commandCount() const { return commands; }
+    bool empty() const { return commands == 0; }
+
+    /// Issues every recorded call in order. Context thread only.
+    void execute() const {
+        const unsigned char *p = stream.data();
+        const unsigned char *end = p + stream.size();
+        while (p < end) {
+            Op op = read<Op>(p);
+            switch (op) {
+            case Op::UseProgram:
+                glUseProgram(read<GLuint>(p));
+                break;
+            case Op::BindVertexArray:
+                glBindVertexArray(read<GLuint>(p));
+                break;
+            case Op::BindTexture: {
+                auto a = read<BindTextureArgs>(p);
+                glActiveTexture(GL_TEXTURE0 + a.unit);
+                glBindTexture(a.target, a.texture);
+                break;
+            }
+            case Op::SetInt: {
+                auto a = read<SetIntArgs>(p);
+                glUniform1i(a.location, a.value);
+                break;
+            }
+            case Op::SetFloat: {
+                auto a = read<SetFloatArgs>(p);
+                glUniform1f(a.location, a.value);
+                break;
+            }
+            case Op::SetVec4: {
+                auto a = read<SetVec4Args>(p);
+                glUniform4fv(a.location, 1, &a.value[0]);
+                break;
+            }
+            case Op::SetMat4: {
+                auto a = read<SetMat4Args>(p);
+                glUniformMatrix4fv(a.location, 1, GL_FALSE, &a.value[0][0]);
+                break;
+            }
+            case Op::SetMat4Array: {
+                auto a = read<SetArrayArgs>(p);
+                glUniformMatrix4fv(a.location, a.count, GL_FALSE, a.data);
+                break;
+            }
+            case Op::DrawArrays: {
+                auto a = read<DrawArraysArgs>(p);
+                glDrawArrays(a.mode, a.first, a.count);
+                break;
+            }
+            case Op::DrawElements: {
+                auto a = read<DrawElementsArgs>(p);
+                const void *offset = reinterpret_cast<const void *>(a.offset);
+                if (a.instances == 1)
+                    glDrawElementsBaseVertex(a.mode, a.count, a.type, offset, a.baseVertex);
+                else
+                    glDrawElementsInstancedBaseVertex(a.mode, a.count, a.type, offset, a.instances, a.baseVertex);
+                break;
+            }
+            }
+        }
+    }
+
+    /// Forgets every command and arena allocation, keeping the memory.
+    void reset() {
+        stream.clear();
+        commands = 0;
+        for (Block &block : blocks)
+            block.used = 0;
+        current = 0;
+    }
+
+private:
+    enum class Op : uint32_t {
+        UseProgram,
+        BindVertexArray,
+        BindTexture,
+        SetInt,
+        SetFloat,
+        SetVec4,
+        SetMat4,
+        SetMat4Array,
+        DrawArrays,
+        DrawElements,
+    };
+
+    struct BindTextureArgs { GLuint unit; GLenum target; GLuint texture; };
+    struct SetIntArgs { GLint location; int value; };
+    struct SetFloatArgs { GLint location; float value; };
+    struct SetVec4Args { GLint location; glm::vec4 value; };
+    struct SetMat4Args { GLint location; glm::mat4 value; };
+    struct SetArrayArgs { GLint location; GLsizei count; const float *data; };
+    struct DrawArraysArgs { GLenum mode; GLint first; GLsizei count; };
+    struct DrawElementsArgs { GLenum mode; GLsizei count; GLenum type; GLsizei instances; GLint baseVertex; size_t offset; };
+
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+        size_t used;
+    };
+
+    static constexpr size_t blockSize = 64 * 1024;
+
+    std::vector<unsigned char> stream;
+    size_t commands = 0;
+    std::vector<Block> blocks;
+    size_t current = 0;
+
+    template <class Args>
+    void record(Op op, const Args &args) {
+        size_t at = stream.size();
+        stream.resize(at + sizeof(Op) + sizeof(Args));
+        std::memcpy(stream.data() + at, &op, sizeof(Op));
+        std::memcpy(stream.data() + at + sizeof(Op), &args, sizeof(Args));
+        ++commands;
+    }
+
+    // Payloads sit unaligned in the stream, so they are copied out.
+    template <class T>
+    static T read(const unsigned char *&p) {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return value;
+    }
+};
+
+#endif
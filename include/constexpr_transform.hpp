@@ -0,0 +1,309 @@
+#ifndef CONSTEXPR_TRANSFORM_HPP
+#define CONSTEXPR_TRANSFORM_HPP
+
+#include <glm/glm.hpp>
+
+/**
+ * Matrix builders that run at compile time, for transforms that never change:
+ * static geometry, fixed cameras, UI projections.
+ *
+ * glm's own translate/rotate/perspective can't be used in constant
+ * expressions once glm is built with SIMD (setup.hpp turns GLM_CONSTEXPR
+ * off), so these work on a plain column-major Mat4 instead and convert to
+ * glm::mat4 where needed:
+ *
+ *     static constexpr cx::Mat4 model =
+ *         cx::scale(cx::translate(cx::identity(), {0.0f, 1.0f, 0.0f}), {2.0f, 2.0f, 2.0f});
+ *     glUniformMatrix4fv(loc, 1, GL_FALSE, model.data());
+ *
+ * Every builder follows the glm function of the same name step for step in
+ * float, including the clip-space convention glm is configured for, so the
+ * results are the same as calling glm at runtime. The only source of
+ * difference is sin/cos/tan, which are evaluated in double here and rounded
+ * once to float; they can differ from the C library by one ulp.
+ */
+namespace cx {
+
+struct Vec3 {
+    float x, y, z;
+};
+
+struct Mat4 {
+    float m[4][4];    // m[column][row], the same layout as glm::mat4
+
+    constexpr const float *operator[](int column) const { return m[column]; }
+    constexpr float *operator[](int column) { return m[column]; }
+
+    const float *data() const { return &m[0][0]; }
+
+    operator glm::mat4() const {
+        glm::mat4 result;
+        for (int c = 0; c < 4; ++c)
+            for (int r = 0; r < 4; ++r)
+                result[c][r] = m[c][r];
+        return result;
+    }
+};
+
+namespace detail {
+
+constexpr double pi = 3.14159265358979323846;
+// pi / 2 split so that k * halfPiHi is exact for the k we reduce by.
+constexpr double halfPiHi = 1.57079632673412561417e+00;
+constexpr double halfPiLo = 6.07710050650619224932e-11;
+
+// Taylor series on [-pi/4, pi/4], summed until the terms stop mattering.
+constexpr double sinSeries(double x) {
+    double term = x, sum = x;
+    for (int n = 1; n < 16; ++n) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double cosSeries(double x) {
+    double term = 1.0, sum = 1.0;
+    for (int n = 1; n < 16; ++n) {
+        term *= -x * x / ((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+// Reduces x to r in [-pi/4, pi/4] and the quadrant k (mod 4).
+constexpr double reduce(double x, int &quadrant) {
+    double q = x / (pi / 2);
+    long long k = static_cast<long long>(q < 0 ? q - 0.5 : q + 0.5);
+    quadrant = static_cast<int>(k & 3);
+    return (x - static_cast<double>(k) * halfPiHi) - static_cast<double>(k) * halfPiLo;
+}
+
+constexpr double sin(double x) {
+    int quadrant = 0;
+    double r = reduce(x, quadrant);
+    switch (quadrant) {
+    case 0: return sinSeries(r);
+    case 1: return cosSeries(r);
+    case 2: return -sinSeries(r);
+    default: return -cosSeries(r);
+    }
+}
+
+constexpr double cos(double x) {
+    int quadrant = 0;
+    double r = reduce(x, quadrant);
+    switch (quadrant) {
+    case 0: return cosSeries(r);
+    case 1: return -sinSeries(r);
+    case 2: return -cosSeries(r);
+    default: return sinSeries(r);
+    }
+}
+
+// Newton's method until the estimate stops moving.
+constexpr double sqrt(double x) {
+    if (!(x > 0.0))
+        return 0.0;
+    double y = x < 1.0 ? 1.0 : x;
+    for (int i = 0; i < 128; ++i) {
+        double next = 0.5 * (y + x / y);
+        if (next >= y)
+            break;
+        y = next;
+    }
+    return y;
+}
+
+constexpr float dot(const Vec3 &a, const Vec3 &b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+constexpr Vec3 cross(const Vec3 &a, const Vec3 &b) {
+    return {a.y * b.z - b.y * a.z, a.z * b.x - b.z * a.x, a.x * b.y - b.x * a.y};
+}
+
+constexpr Vec3 normalize(const Vec3 &v) {
+    float inv = 1.0f / static_cast<float>(sqrt(dot(v, v)));
+    return {v.x * inv, v.y * inv, v.z * inv};
+}
+
+constexpr Vec3 sub(const Vec3 &a, const Vec3 &b) {
+    return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+constexpr Mat4 zero() {
+    return {{{0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}}};
+}
+
+}
+
+/// Float results, correctly rounded from a double evaluation.
+constexpr float sin(float x) { return static_cast<float>(detail::sin(x)); }
+constexpr float cos(float x) { return static_cast<float>(detail::cos(x)); }
+constexpr float tan(float x) { return static_cast<float>(detail::sin(x) / detail::cos(x)); }
+
+constexpr float radians(float degrees) {
+    return degrees * static_cast<float>(0.01745329251994329576923690768489);
+}
+
+constexpr Mat4 identity() {
+    return {{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}}};
+}
+
+constexpr Mat4 operator*(const Mat4 &a, const Mat4 &b) {
+    Mat4 result = detail::zero();
+    for (int c = 0; c < 4; ++c)
+        for (int r = 0; r < 4; ++r)
+            result.m[c][r] = a.m[0][r] * b.m[c][0] + a.m[1][r] * b.m[c][1]
+                           + a.m[2][r] * b.m[c][2] + a.m[3][r] * b.m[c][3];
+    return result;
+}
+
+/**
+ * @brief m * a translation by v, like glm::translate.
+ */
+constexpr Mat4 translate(const Mat4 &m, const Vec3 &v) {
+    Mat4 result = m;
+    for (int r = 0; r < 4; ++r)
+        result.m[3][r] = m.m[0][r] * v.x + m.m[1][r] * v.y + m.m[2][r] * v.z + m.m[3][r];
+    return result;
+}
+
+/**
+ * @brief m * a rotation of `angle` radians about `axis`, like glm::rotate.
+ */
+constexpr Mat4 rotate(const Mat4 &m, float angle, const Vec3 &axis) {
+    float c = cos(angle);
+    float s = sin(angle);
+    Vec3 a = detail::normalize(axis);
+    Vec3 t = {(1.0f - c) * a.x, (1.0f - c) * a.y, (1.0f - c) * a.z};
+
+    float rot[3][3] = {
+        {c + t.x * a.x, t.x * a.y + s * a.z, t.x * a.z - s * a.y},
+        {t.y * a.x - s * a.z, c + t.y * a.y, t.y * a.z + s * a.x},
+        {t.z * a.x + s * a.y, t.z * a.y - s * a.x, c + t.z * a.z},
+    };
+
+    Mat4 result = m;
+    for (int c2 = 0; c2 < 3; ++c2)
+        for (int r = 0; r < 4; ++r)
+            result.m[c2][r] = m.m[0][r] * rot[c2][0] + m.m[1][r] * rot[c2][1] + m.m[2][r] * rot[c2][2];
+    return result;
+}
+
+/**
+ * @brief m * a scale by v, like glm::scale.
+ */
+constexpr Mat4 scale(const Mat4 &m, const Vec3 &v) {
+    Mat4 result = m;
+    for (int r = 0; r < 4; ++r) {
+        result.m[0][r] = m.m[0][r] * v.x;
+        result.m[1][r] = m.m[1][r] * v.y;
+        result.m[2][r] = m.m[2][r] * v.z;
+    }
+    return result;
+}
+
+/**
+ * @brief A view matrix looking from eye towards center, like glm::lookAt.
+ */
+constexpr Mat4 lookAt(const Vec3 &eye, const Vec3 &center, const Vec3 &up) {
+    Vec3 f = detail::normalize(detail::sub(center, eye));
+#if GLM_CONFIG_CLIP_CONTROL & GLM_CLIP_CONTROL_LH_BIT
+    Vec3 s = detail::normalize(detail::cross(up, f));
+    Vec3 u = detail::cross(f, s);
+    float fSign = 1.0f;
+#else
+    Vec3 s = detail::normalize(detail::cross(f, up));
+    Vec3 u = detail::cross(s, f);
+    float fSign = -1.0f;
+#endif
+    Mat4 result = identity();
+    result.m[0][0] = s.x;
+    result.m[1][0] = s.y;
+    result.m[2][0] = s.z;
+    result.m[0][1] = u.x;
+    result.m[1][1] = u.y;
+    result.m[2][1] = u.z;
+    result.m[0][2] = fSign * f.x;
+    result.m[1][2] = fSign * f.y;
+    result.m[2][2] = fSign * f.z;
+    result.m[3][0] = -detail::dot(s, eye);
+    result.m[3][1] = -detail::dot(u, eye);
+    result.m[3][2] = -fSign * detail::dot(f, eye);
+    return result;
+}
+
+/**
+ * @brief An orthographic projection, like glm::ortho.
+ */
+constexpr Mat4 ortho(float left, float right, float bottom, float top, float zNear, float zFar) {
+    Mat4 result = identity();
+    result.m[0][0] = 2.0f / (right - left);
+    result.m[1][1] = 2.0f / (top - bottom);
+    result.m[3][0] = -(right + left) / (right - left);
+    result.m[3][1] = -(top + bottom) / (top - bottom);
+#if GLM_CONFIG_CLIP_CONTROL & GLM_CLIP_CONTROL_ZO_BIT
+    result.m[2][2] = 1.0f / (zFar - zNear);
+    result.m[3][2] = -zNear / (zFar - zNear);
+#else
+    result.m[2][2] = 2.0f / (zFar - zNear);
+    result.m[3][2] = -(zFar + zNear) / (zFar - zNear);
+#endif
+#if !(GLM_CONFIG_CLIP_CONTROL & GLM_CLIP_CONTROL_LH_BIT)
+    result.m[2][2] = -result.m[2][2];
+#endif
+    return result;
+}
+
+/**
+ * @brief A perspective projection, like glm::perspective.
+ *
+ * @param fovy Vertical field of view in radians.
+ */
+constexpr Mat4 perspective(float fovy, float aspect, float zNear, float zFar) {
+    float tanHalfFovy = tan(fovy / 2.0f);
+
+    Mat4 result = detail::zero();
+    result.m[0][0] = 1.0f / (aspect * tanHalfFovy);
+    result.m[1][1] = 1.0f / tanHalfFovy;
+#if GLM_CONFIG_CLIP_CONTROL & GLM_CLIP_CONTROL_LH_BIT
+    result.m[2][3] = 1.0f;
+#  if GLM_CONFIG_CLIP_CONTROL & GLM_CLIP_CONTROL_ZO_BIT
+    result.m[2][2] = zFar / (zFar - zNear);
+    result.m[3][2] = -(zFar * zNear) / (zFar - zNear);
+#  else
+    result.m[2][2] = (zFar + zNear) / (zFar - zNear);
+    result.m[3][2] = -(2.0f * zFar * zNear) / (zFar - zNear);
+#  endif
+#else
+    result.m[2][3] = -1.0f;
+#  if GLM_CONFIG_CLIP_CONTROL & GLM_CLIP_CONTROL_ZO_BIT
+    result.m[2][2] = zFar / (zNear - zFar);
+    result.m[3][2] = -(zFar * zNear) / (zFar - zNear);
+#  else
+    result.m[2][2] = -(zFar + zNear) / (zFar - zNear);
+    result.m[3][2] = -(2.0f * zFar * zNear) / (zFar - zNear);
+#  endif
+#endif
+    return result;
+}
+
+// Built at compile time here, so a change that stops any builder being a
+// constant expression breaks the build rather than the first caller.
+static_assert(detail::sqrt(2.25) == 1.5, "cx::detail::sqrt");
+static_assert(sin(0.0f) == 0.0f && cos(0.0f) == 1.0f && sin(radians(90.0f)) == 1.0f, "cx::sin, cx::cos");
+static_assert(tan(radians(45.0f)) == 1.0f, "cx::tan");
+static_assert(translate(identity(), {1.0f, 2.0f, 3.0f})[3][1] == 2.0f, "cx::translate");
+static_assert(scale(identity(), {2.0f, 3.0f, 4.0f})[2][2] == 4.0f, "cx::scale");
+static_assert(rotate(identity(), radians(90.0f), {0.0f, 0.0f, 2.0f})[0][1] == 1.0f, "cx::rotate");
+static_assert((scale(identity(), {2.0f, 2.0f, 2.0f}) * translate(identity(), {1.0f, 0.0f, 0.0f}))[3][0] == 2.0f,
+              "cx::operator*");
+static_assert(lookAt({0.0f, 0.0f, 5.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f})[1][1] == 1.0f, "cx::lookAt");
+static_assert(ortho(-2.0f, 2.0f, -1.0f, 1.0f, 0.1f, 10.0f)[0][0] == 0.5f, "cx::ortho");
+static_assert(perspective(radians(90.0f), 2.0f, 0.1f, 10.0f)[0][0] == 0.5f, "cx::perspective");
+
+}
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef CULLING_HPP
+#define CULLING_HPP
+
+#include "simd.hpp"
+#include <glm/glm.hpp>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * View-frustum culling for large numbers of objects.
+ *
+ * Bounds are kept in structure-of-arrays form so each SIMD register tests the
+ * same plane against 4, 8 or 16 objects. The output is a compact list of the
+ * indices that survived, ready to drive draw calls, so culled objects cost no
+ * further CPU or GPU work.
+ */
+namespace culling {
+
+/**
+ * Six normalized planes (a, b, c, d) with ax + by + cz + d >= 0 meaning
+ * inside. Order: left, right, bottom, top, near, far.
+ */
+struct Frustum {
+    glm::vec4 planes[6];
+
+    /**
+     * @brief Extracts the planes from a combined view-projection matrix
+     *        (Gribb/Hartmann). Bounds tested against it must be in the space
+     *        the matrix transforms from, usually world space.
+     */
+    static Frustum fromViewProjection(const glm::mat4 &viewProjection) {
+        glm::mat4 t = glm::transpose(viewProjection);
+        Frustum f;
+        f.planes[0] = t[3] + t[0];
+        f.planes[1] = t[3] - t[0];
+        f.planes[2] = t[3] + t[1];
+        f.planes[3] = t[3] - t[1];
+        f.planes[4] = t[3] + t[2];
+        f.planes[5] = t[3] - t[2];
+        for (glm::vec4 &p : f.planes)
+            p /= glm::length(glm::vec3(p));
+        return f;
+    }
+};
+
+struct SphereBatch {
+    std::vector<float> x, y, z, radius;
+
+    size_t size() const { return x.size(); }
+
+    void push(const glm::vec3 &center, float r) {
+        x.push_back(center.x);
+        y.push_back(center.y);
+        z.push_back(center.z);
+        radius.push_back(r);
+    }
+};
+
+/**
+ * Axis-aligned boxes stored as center and half-extents, which turns the box
+ * test into a sphere-like test with a per-plane radius.
+ */
+struct AabbBatch {
+    std::vector<float> x, y, z;
+    std::vector<float> extentX, extentY, extentZ;
+
+    size_t size() const { return x.size(); }
+
+    void push(const glm::vec3 &min, const glm::vec3 &max) {
+        glm::vec3 center = (min + max) * 0.5f;
+        glm::vec3 extent = (max - min) * 0.5f;
+        x.push_back(center.x);
+        y.push_back(center.y);
+        z.push_back(center.z);
+        extentX.push_back(extent.x);
+        extentY.push_back(extent.y);
+        extentZ.push_back(extent.z);
+    }
+};
+
+namespace detail {
+
+inline int lowestBit(unsigned bits) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(bits);
+#endif
+}
+
+// Appends index + lane for each lane whose bit is clear in culledMask.
+inline void appendVisible(unsigned culledMask, int width, size_t index, uint32_t *&out) {
+    unsigned visible = ~culledMask & ((1u << width) - 1);
+    while (visible) {
+        int lane = lowestBit(visible);
+        *out++ = static_cast<uint32_t>(index + lane);
+        visible &= visible - 1;
+    }
+}
+
+// An object is culled once it lies entirely behind any plane:
+// dot(n, center) + d < -radius.
+template <class Ops>
+struct SphereKernel {
+    static void run(size_t count, const float *x, const float *y, const float *z, const float *r,
+                    const glm::vec4 *planes, uint32_t *out, size_t *visibleCount) {
+        uint32_t *begin = out;
+        simd::forEachBlock<Ops>(count, [&](auto ops, size_t i) {
+            using O = decltype(ops);
+            using F = typename O::Float;
+            F cx = O::load(x + i), cy = O::load(y + i), cz = O::load(z + i);
+            F negR = O::sub(O::set1(0.0f), O::load(r + i));
+            unsigned culled = 0;
+            for (int p = 0; p < 6; ++p) {
+                F d = O::fmadd(O::set1(planes[p].x), cx, O::set1(planes[p].w));
+                d = O::fmadd(O::set1(planes[p].y), cy, d);
+                d = O::fmadd(O::set1(planes[p].z), cz, d);
+                culled |= O::lessMask(d, negR);
+            }
+            appendVisible(culled, O::width, i, out);
+        });
+        *visibleCount = static_cast<size_t>(out - begin);
+    }
+};
+
+// Same test with the box's projected radius |n.x| ex + |n.y| ey + |n.z| ez.
+template <class Ops>
+struct AabbKernel {
+    static void run(size_t count, const float *x, const float *y, const float *z,
+                    const float *ex, const float *ey, const float *ez,
+                    const glm::vec4 *planes, uint32_t *out, size_t *visibleCount) {
+        uint32_t *begin = out;
+        simd::forEachBlock<Ops>(count, [&](auto ops, size_t i) {
+            using O = decltype(ops);
+            using F = typename O::Float;
+            F cx = O::load(x + i), cy = O::load(y + i), cz = O::load(z + i);
+            F hx = O::load(ex + i), hy = O::load(ey + i), hz = O::load(ez + i);
+            unsigned culled = 0;
+            for (int p = 0; p < 6; ++p) {
+                F d = O::fmadd(O::set1(planes[p].x), cx, O::set1(planes[p].w));
+                d = O::fmadd(O::set1(planes[p].y), cy, d);
+                d = O::fmadd(O::set1(planes[p].z), cz, d);
+                F r = O::mul(O::set1(std::fabs(planes[p].x)), hx);
+                r = O::fmadd(O::set1(std::fabs(planes[p].y)), hy, r);
+                r = O::fmadd(O::set1(std::fabs(planes[p].z)), hz, r);
+                culled |= O::lessMask(O::add(d, r), O::set1(0.0f));
+            }
+            appendVisible(culled, O::width, i, out);
+        });
+        *visibleCount = static_cast<size_t>(out - begin);
+    }
+};
+
+}
+
+/**
+ * @brief Writes the indices of spheres that touch the frustum to `visible`,
+ *        in ascending order.
+ *
+ * @return The number of visible spheres (also visible.size()).
+ */
+inline size_t cull(const Frustum &frustum, const SphereBatch &spheres, std::vector<uint32_t> &visible) {
+    visible.resize(spheres.size());
+    size_t count = 0;
+    simd::dispatch<detail::SphereKernel>(
+        spheres.size(), spheres.x.data(), spheres.y.data(), spheres.z.data(), spheres.radius.data(),
+        frustum.planes, visible.data(), &count
+    );
+    visible.resize(count);
+    return count;
+}
+
+/**
+ * @brief Writes the indices of boxes that touch the frustum to `visible`, in
+ *        ascending order.
+ *
+ * Conservative like any plane test: a box near a frustum corner can be kept
+ * even though it is outside.
+ *
+ * @return The number of visible boxes (also visible.size()).
+ */
+inline size_t cull(const Frustum &frustum, const AabbBatch &boxes, std::vector<uint32_t> &visible) {
+    visible.resize(boxes.size());
+    size_t count = 0;
+    simd::dispatch<detail::AabbKernel>(
+        boxes.size(), boxes.x.data(), boxes.y.data(), boxes.z.data(),
+        boxes.extentX.data(), boxes.extentY.data(), boxes.extentZ.data(),
+        frustum.planes, visible.data(), &count
+    );
+    visible.resize(count);
+    return count;
+}
+
+}
+
+#endif
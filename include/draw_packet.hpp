@@ -0,0 +1,92 @@
+#ifndef DRAW_PACKET_HPP
+#define DRAW_PACKET_HPP
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Everything needed to issue one indexed draw, for use as a
+ *        RenderQueue payload.
+ *
+ * Per-draw uniforms don't fit in a packet this small; set them per program
+ * before replaying, or move them into instance attributes (see
+ * InstanceBuffer).
+ */
+struct DrawPacket {
+    static constexpr int maxTextures = 4;
+
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLuint textures[maxTextures] = {};    // bound to units 0..3 as GL_TEXTURE_2D; 0 leaves the unit alone
+    GLsizei indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    uint32_t firstIndexByte = 0;          // offset into the element buffer
+    GLint baseVertex = 0;
+    GLsizei instances = 1;
+};
+
+/**
+ * @brief Replays DrawPackets on the GL thread, skipping binds that wouldn't
+ *        change anything.
+ *
+ * Pass it straight to RenderQueue::replay. It assumes nothing else changes
+ * program, VAO or texture bindings while it runs; call reset() if something
+ * might have.
+ */
+class DrawPacketExecutor {
+public:
+    struct Stats {
+        size_t draws = 0;
+        size_t programBinds = 0;
+        size_t vaoBinds = 0;
+        size_t textureBinds = 0;
+    };
+
+    void operator()(uint64_t, const DrawPacket &p) {
+        if (p.program != program) {
+            glUseProgram(p.program);
+            program = p.program;
+            ++stats.programBinds;
+        }
+        if (p.vao != vao) {
+            glBindVertexArray(p.vao);
+            vao = p.vao;
+            ++stats.vaoBinds;
+        }
+        for (int unit = 0; unit < DrawPacket::maxTextures; ++unit) {
+            if (p.textures[unit] == 0 || p.textures[unit] == textures[unit])
+                continue;
+            glActiveTexture(GL_TEXTURE0 + unit);
+            glBindTexture(GL_TEXTURE_2D, p.textures[unit]);
+            textures[unit] = p.textures[unit];
+            ++stats.textureBinds;
+        }
+
+        const void *offset = reinterpret_cast<const void *>(static_cast<uintptr_t>(p.firstIndexByte));
+        if (p.instances == 1)
+            glDrawElementsBaseVertex(GL_TRIANGLES, p.indexCount, p.indexType, offset, p.baseVertex);
+        else
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, p.indexCount, p.indexType, offset, p.instances, p.baseVertex);
+        ++stats.draws;
+    }
+
+    /// Forgets the cached bindings and counters.
+    void reset() {
+        program = 0;
+        vao = 0;
+        for (GLuint &t : textures)
+            t = 0;
+        stats = Stats();
+    }
+
+    const Stats &getStats() const { return stats; }
+
+private:
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLuint textures[DrawPacket::maxTextures] = {};
+    Stats stats;
+};
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef DYNAMIC_BUFFER_HPP
+#define DYNAMIC_BUFFER_HPP
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// ARB_buffer_storage / GL 4.4. Not in our glad, which stops at 3.3.
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+/**
+ * @brief A ring of GPU memory for data rewritten every frame: streamed
+ *        vertices, per-frame uniforms.
+ *
+ * The buffer is split into one region per frame in flight. Each frame writes
+ * into its own region and drops a fence at endFrame(); beginFrame() waits on
+ * the fence of the region it's about to reuse, which has normally signalled
+ * long before. The GPU never reads memory that's being written, and the CPU
+ * doesn't wait for the GPU unless it gets `regions` frames ahead.
+ *
+ * Where glBufferStorage is available (GL 4.4 or ARB_buffer_storage, after
+ * loadBufferStorage()), the buffer is mapped once, persistent and coherent,
+ * and writes go straight to it. Otherwise each write maps its range with
+ * GL_MAP_UNSYNCHRONIZED_BIT, which the fences make safe, and unmaps it before
+ * returning, since GL 3.3 can't draw from a mapped buffer.
+ *
+ *     ring.beginFrame();
+ *     size_t offset = ring.upload(vertices, bytes, sizeof(float));
+ *     glDrawArrays(..., offset / stride, ...);   // with the VAO reading ring.ID
+ *     ring.endFrame();
+ */
+class DynamicBuffer {
+public:
+    struct Stats {
+        size_t fenceWaits = 0;      // beginFrame() calls that had to block
+        double fenceWaitMs = 0.0;   // total time spent blocked
+        size_t failedUploads = 0;   // uploads that didn't fit in their region
+    };
+
+    unsigned int ID = 0;
+
+    /**
+     * @brief Fetches glBufferStorage if the context has it. Call once after
+     *        gladLoadGLLoader, with the same loader.
+     */
+    static bool loadBufferStorage(GLADloadproc load) {
+        bufferStorage() = nullptr;
+        bool available = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4);
+        GLint extensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+        for (GLint i = 0; i < extensions && !available; ++i)
+            available = std::strcmp(reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i)), "GL_ARB_buffer_storage") == 0;
+        if (available)
+            bufferStorage() = reinterpret_cast<BufferStorageProc>(load("glBufferStorage"));
+        return bufferStorage() != nullptr;
+    }
+
+    /**
+     * @param target Where the buffer is bound while writing, e.g.
+     * GL_ARRAY_BUFFER or GL_UNIFORM_BUFFER.
+     * @param regionBytes Space for one frame's data. Rounded up to 256 so
+     * every region starts suitably aligned for uniform blocks.
+     * @param regions Frames that can be in flight at once; at least 1.
+     */
+    DynamicBuffer(GLenum target, size_t regionBytes, unsigned regions = 3)
+        : target(target), regionBytes((regionBytes + 255) & ~size_t(255)), fences(std::max(regions, 1u), nullptr) {
+        size_t total = this->regionBytes * fences.size();
+        glGenBuffers(1, &ID);
+        glBindBuffer(target, ID);
+        if (bufferStorage()) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            bufferStorage()(target, total, nullptr, flags);
+            persistent = static_cast<unsigned char *>(glMapBufferRange(target, 0, total, flags));
+            if (persistent)
+                return;
+            // Immutable storage can't be respecified; start over with a
+            // plain buffer.
+            std::cout << "Failed to map persistent buffer, using unsynchronized mapping" << std::endl;
+            glDeleteBuffers(1, &ID);
+            glGenBuffers(1, &ID);
+            glBindBuffer(target, ID);
+        }
+        glBufferData(target, total, nullptr, GL_STREAM_DRAW);
+    }
+
+    ~DynamicBuffer() {
+        for (GLsync fence : fences)
+            if (fence)
+                glDeleteSync(fence);
+        if (persistent) {
+            glBindBuffer(target, ID);
+            glUnmapBuffer(target);
+        }
+        glDeleteBuffers(1, &ID);
+    }
+
+    DynamicBuffer(const DynamicBuffer &) = delete;
+    DynamicBuffer &operator=(const DynamicBuffer &) = delete;
+
+    bool isPersistent() const { return persistent != nullptr; }
+
+    /// Moves to the next region, waiting for the GPU to be done with it.
+    void beginFrame() {
+        region = (region + 1) % fences.size();
+        used = 0;
+        GLsync &fence = fences[region];
+        if (!fence)
+            return;
+
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED) {
+            auto start = std::chrono::steady_clock::now();
+            do
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            while (result == GL_TIMEOUT_EXPIRED);
+            ++stats.fenceWaits;
+            stats.fenceWaitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    /// Marks the end of this frame's commands reading the current region.
+    void endFrame() {
+        // Only set twice without a beginFrame() between; the newer fence
+        // covers everything the older one did.
+        if (fences[region])
+            glDeleteSync(fences[region]);
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    /**
+     * @brief Copies data into this frame's region.
+     *
+     * @param align Alignment of the returned offset; for uniform blocks use
+     * GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+     * @return The byte offset into the buffer, or SIZE_MAX when the region is
+     * full.
+     */
+    size_t upload(const void *data, size_t bytes, size_t align = 16) {
+        size_t offset = reserve(bytes, align);
+        if (offset == SIZE_MAX)
+            return offset;
+        if (persistent) {
+            std::memcpy(persistent + offset, data, bytes);
+            return offset;
+        }
+        glBindBuffer(target, ID);
+        void *mapped = glMapBufferRange(target, offset, bytes,
+                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!mapped) {
+            std::cout << "Failed to map dynamic buffer range" << std::endl;
+            return SIZE_MAX;
+        }
+        std::memcpy(mapped, data, bytes);
+        glUnmapBuffer(target);
+        return offset;
+    }
+
+    /// Bytes left in this frame's region.
+    size_t remaining() const { return regionBytes - used; }
+
+    const Stats &getStats() const { return stats; }
+
+private:
+    using BufferStorageProc = void (APIENTRYP)(GLenum, GLsizeiptr, const void *, GLbitfield);
+
+    static BufferStorageProc &bufferStorage() {
+        static BufferStorageProc proc = nullptr;
+        return proc;
+    }
+
+    size_t reserve(size_t bytes, size_t align) {
+        size_t start = (used + align - 1) / align * align;
+        if (start + bytes > regionBytes) {
+            ++stats.failedUploads;
+            return SIZE_MAX;
+        }
+        used = start + bytes;
+        return region * regionBytes + start;
+    }
+
+    GLenum target;
+    size_t regionBytes;
+    std::vector<GLsync> fences;    // one per region, set by endFrame
+    size_t region = 0;
+    size_t used = 0;
+    unsigned char *persistent = nullptr;
+    Stats stats;
+};
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef FLIPBOOK_HPP
+#define FLIPBOOK_HPP
+
+#include "texture.hpp"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief An animated GIF played back from a small ring of texture array
+ *        layers.
+ *
+ * The GIF is decoded on a worker thread. Once it is ready, `update()` on the
+ * GL thread keeps only the current frame and the next few in a
+ * GL_TEXTURE_2D_ARRAY of `ringLayers` layers, uploading each frame just before
+ * it is shown. Video memory stays the same no matter how long the animation
+ * is.
+ *
+ * Sample it with a sampler2DArray and `currentLayer()` as the layer index.
+ *
+ * @note stb_image decodes every GIF frame in one call, so the decoded frames
+ * of an animation longer than the ring stay in CPU memory until the Flipbook
+ * is destroyed. Only the GPU side is bounded. An animation that fits in the
+ * ring is uploaded once and its CPU copy freed.
+ */
+class Flipbook {
+public:
+    unsigned int ID = 0;
+
+    /**
+     * @param desc flipVertically, premultiplyAlpha and srgb apply. Frames are
+     * always decoded to 8-bit RGBA, so the other fields are ignored.
+     */
+    Flipbook(const std::string &path, int ringLayers = 4, const TextureDesc &desc = {})
+        : path(path), ringLayers(std::max(ringLayers, 1)) {
+        worker = std::thread([this, desc] { decode(desc); });
+    }
+
+    ~Flipbook() {
+        if (worker.joinable())
+            worker.join();
+        stbi_image_free(frames);
+        if (ID)
+            glDeleteTextures(1, &ID);
+    }
+
+    Flipbook(const Flipbook &) = delete;
+    Flipbook &operator=(const Flipbook &) = delete;
+
+    bool ready() const { return ID != 0; }
+    bool failed() const { return decodeFailed.load(); }
+
+    /// Size and length of the animation; 0 until the worker has decoded it.
+    int getWidth() const { return decoded.load() ? width : 0; }
+    int getHeight() const { return decoded.load() ? height : 0; }
+    int getFrameCount() const { return decoded.load() ? frameCount : 0; }
+
+    /**
+     * @brief Advances playback and uploads frames entering the ring. Call once
+     *        per frame on the GL thread.
+     *
+     * @param deltaSeconds Time since the last call.
+     */
+    void update(double deltaSeconds) {
+        if (!ready()) {
+            if (!decoded.load())
+                return;
+            // A failed decode stays not ready, so later calls get here too.
+            if (worker.joinable())
+                worker.join();
+            if (failed())
+                return;
+            createRing();
+        }
+
+        elapsedMs += deltaSeconds * 1000.0;
+        while (elapsedMs >= delaysMs[playhead % frameCount]) {
+            elapsedMs -= delaysMs[playhead % frameCount];
+            ++playhead;
+        }
+        fillRing();
+    }
+
+    /// Layer of the ring that holds the frame being shown.
+    int currentLayer() const { return ready() ? static_cast<int>(playhead % layers) : 0; }
+
+    void bind() const {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+    }
+
+private:
+    std::string path;
+    int ringLayers;
+    int layers = 0;
+
+    std::thread worker;
+    std::atomic<bool> decoded{false};
+    std::atomic<bool> decodeFailed{false};
+
+    // Written only by the worker before `decoded` is set.
+    int width = 0, height = 0, frameCount = 0;
+    GLint internalFormat = GL_RGBA8;
+    unsigned char *frames = nullptr;
+    std::vector<int> delaysMs;
+
+    // Frames are counted across loops, so frame n lives in layer n % layers
+    // and comes from source frame n % frameCount.
+    long long playhead = 0;
+    long long residentEnd = 0;  // one past the last frame uploaded
+    double elapsedMs = 0.0;
+
+    void decode(const TextureDesc &desc) {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<unsigned char> bytes(
+            (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()
+        );
+
+        int *delays = nullptr;
+        int channels = 0;
+        frames = stbi_load_gif_from_memory(
+            bytes.data(), static_cast<int>(bytes.size()), &delays,
+            &width, &height, &frameCount, &channels, 4
+        );
+        if (frames) {
+            size_t rowBytes = static_cast<size_t>(width) * 4;
+            if (desc.premultiplyAlpha)
+                Image::premultiplyPixels(frames, static_cast<size_t>(width) * height * frameCount, 4,
+                                         Image::PixelType::UInt8);
+            internalFormat = Image::glInternalFormat(Image::PixelType::UInt8, 4, desc.srgb);
+            for (int i = 0; i < frameCount; ++i) {
+                if (desc.flipVertically)
+                    flipRowsInPlace(frames + i * rowBytes * height, rowBytes, height);
+                // Browsers treat a zero delay as 100 ms; do the same.
+                delaysMs.push_back(delays && delays[i] > 0 ? delays[i] : 100);
+            }
+            stbi_image_free(delays);
+        } else {
+            std::cout << "Failed to load flipbook: " << path << std::endl;
+            decodeFailed = true;
+        }
+        decoded = true;
+    }
+
+    void createRing() {
+        layers = std::min(ringLayers, frameCount);
+
+        glGenTextures(1, &ID);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage3D(
+            GL_TEXTURE_2D_ARRAY, 0, internalFormat, width, height, layers,
+            0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr
+        );
+        fillRing();
+    }
+
+    // Keeps frames [playhead, playhead + layers) resident. Frames skipped
+    // over by a long update are never uploaded.
+    void fillRing() {
+        // A short animation was uploaded whole and its frames freed.
+        if (!frames)
+            return;
+
+        bind();
+        size_t frameBytes = static_cast<size_t>(width) * height * 4;
+        for (residentEnd = std::max(residentEnd, playhead); residentEnd < playhead + layers; ++residentEnd) {
+            int source = static_cast<int>(residentEnd % frameCount);
+            int layer = static_cast<int>(residentEnd % layers);
+            glTexSubImage3D(
+                GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1,
+                GL_RGBA, GL_UNSIGNED_BYTE, frames + source * frameBytes
+            );
+        }
+        if (layers == frameCount) {
+            stbi_image_free(frames);
+            frames = nullptr;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef FRAME_PIPELINE_HPP
+#define FRAME_PIPELINE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+/**
+ * Frame timings, as exponential moving averages over roughly the last 30
+ * frames. All in milliseconds.
+ */
+struct FramePacing {
+    uint64_t frames = 0;        // frames rendered so far
+    double updateMs = 0.0;      // beginUpdate to publish
+    double renderMs = 0.0;      // acquire to release
+    double latencyMs = 0.0;     // beginUpdate to release: how old a frame is when it's done
+    double updateWaitMs = 0.0;  // update thread blocked on a free slot
+    double renderWaitMs = 0.0;  // render thread blocked on a new frame
+    double intervalMs = 0.0;    // release to release
+    double jitterMs = 0.0;      // average distance of intervalMs from its mean
+};
+
+/**
+ * @brief Hands immutable frame snapshots from an update thread to the render
+ *        thread, so that frame N+1 is simulated while frame N is drawn.
+ *
+ * There are two or three slots. The update thread fills one while the render
+ * thread draws another; with three, one more finished frame can wait in
+ * between to absorb an uneven update. Frames are rendered in the order they
+ * were published and none are dropped. When every slot is busy, beginUpdate()
+ * blocks, so the render thread is never more than `slots - 1` frames behind
+ * the simulation.
+ *
+ *     // update thread
+ *     while (Snapshot *next = pipeline.beginUpdate()) {
+ *         simulate(*next);
+ *         pipeline.publish();
+ *     }
+ *
+ *     // render (GL) thread
+ *     while (const Snapshot *frame = pipeline.acquire()) {
+ *         draw(*frame);
+ *         pipeline.release();
+ *     }
+ *
+ * Slots are reused, not reconstructed: beginUpdate() returns whatever the slot
+ * held a couple of frames ago, so overwrite everything that changes.
+ */
+template <class Snapshot>
+class FramePipeline {
+public:
+    explicit FramePipeline(unsigned slotCount = 3) : slots(std::min(std::max(slotCount, 2u), 3u)) {
+        for (unsigned i = 0; i < slots.size(); ++i)
+            freeSlots.push_back(i);
+    }
+
+    FramePipeline(const FramePipeline &) = delete;
+    FramePipeline &operator=(const FramePipeline &) = delete;
+
+    /**
+     * @brief Waits for a free slot and returns it for writing, or nullptr once
+     *        stop() has been called.
+     */
+    Snapshot *beginUpdate() {
+        auto waitStart = Clock::now();
+        std::unique_lock<std::mutex> lock(mutex);
+        slotFreed.wait(lock, [&] { return stopping || !freeSlots.empty(); });
+        if (stopping)
+            return nullptr;
+
+        writing = freeSlots.front();
+        freeSlots.pop_front();
+        Slot &slot = slots[writing];
+        slot.started = Clock::now();
+        slot.frame = nextFrame++;
+        average(pacing.updateWaitMs, millis(waitStart, slot.started));
+        return &slot.snapshot;
+    }
+
+    /// Hands the slot from the last beginUpdate() to the render thread.
+    void publish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Slot &slot = slots[writing];
+            slot.published = Clock::now();
+            average(pacing.updateMs, millis(slot.started, slot.published));
+            ready.push_back(writing);
+        }
+        frameReady.notify_one();
+    }
+
+    /**
+     * @brief Waits for the oldest published frame, or returns nullptr once
+     *        stop() has been called and every published frame was rendered.
+     */
+    const Snapshot *acquire() {
+        auto waitStart = Clock::now();
+        std::unique_lock<std::mutex> lock(mutex);
+        frameReady.wait(lock, [&] { return stopping || !ready.empty(); });
+        if (ready.empty())
+            return nullptr;
+
+        reading = ready.front();
+        ready.pop_front();
+        Slot &slot = slots[reading];
+        slot.acquired = Clock::now();
+        average(pacing.renderWaitMs, millis(waitStart, slot.acquired));
+        return &slot.snapshot;
+    }
+
+    /// Returns the slot from the last acquire() to the update thread.
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Slot &slot = slots[reading];
+            auto now = Clock::now();
+            average(pacing.renderMs, millis(slot.acquired, now));
+            average(pacing.latencyMs, millis(slot.started, now));
+            if (pacing.frames > 0) {
+                double interval = millis(lastRelease, now);
+                average(pacing.intervalMs, interval);
+                average(pacing.jitterMs, std::abs(interval - pacing.intervalMs));
+            }
+            lastRelease = now;
+            ++pacing.frames;
+            freeSlots.push_back(reading);
+        }
+        slotFreed.notify_one();
+    }
+
+    /// The frame number of the snapshot acquire() last returned, from 0.
+    uint64_t acquiredFrame() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return slots[reading].frame;
+    }
+
+    /// Wakes both threads and makes beginUpdate() return nullptr from now on.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        slotFreed.notify_all();
+        frameReady.notify_all();
+    }
+
+    FramePacing stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pacing;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Slot {
+        Snapshot snapshot{};
+        uint64_t frame = 0;
+        Clock::time_point started, published, acquired;
+    };
+
+    static double millis(Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+
+    // Starts from the first sample rather than creeping up from zero.
+    static void average(double &value, double sample) {
+        value = value == 0.0 ? sample : value + (sample - value) / 32.0;
+    }
+
+    std::vector<Slot> slots;
+    std::deque<unsigned> freeSlots, ready;    // slot indices; ready is oldest first
+    unsigned writing = 0, reading = 0;
+    uint64_t nextFrame = 0;
+    bool stopping = false;
+
+    mutable std::mutex mutex;
+    std::condition_variable slotFreed, frameReady;
+
+    FramePacing pacing;
+    Clock::time_point lastRelease;
+};
+
+#endif
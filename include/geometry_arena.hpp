@@ -0,0 +1,257 @@
+#ifndef GEOMETRY_ARENA_HPP
+#define GEOMETRY_ARENA_HPP
+
+#include "draw_packet.hpp"
+#include "vertex_pack.hpp"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Hands out ranges of a fixed-size space: best fit, with neighbouring
+ *        free ranges merged on free.
+ *
+ * Free ranges are indexed both by offset, for merging, and by size, for the
+ * best-fit lookup, so both operations are O(log n) in the number of free
+ * ranges. Units are up to the caller (vertices, indices, bytes).
+ */
+class RangeAllocator {
+public:
+    static constexpr size_t none = SIZE_MAX;
+
+    explicit RangeAllocator(size_t capacity) : capacity(capacity) {
+        if (capacity > 0)
+            insert(0, capacity);
+    }
+
+    /// The offset of a free range of `size` units, or `none`.
+    size_t allocate(size_t size) {
+        if (size == 0)
+            return none;
+        auto fit = bySize.lower_bound(size);
+        if (fit == bySize.end())
+            return none;
+        size_t blockSize = fit->first, offset = fit->second;
+        erase(offset, blockSize);
+        if (blockSize > size)
+            insert(offset + size, blockSize - size);
+        return offset;
+    }
+
+    /// Returns a range from allocate() with the size it was allocated with.
+    void free(size_t offset, size_t size) {
+        if (size == 0)
+            return;
+        auto next = byOffset.lower_bound(offset);
+        if (next != byOffset.end() && next->first == offset + size) {
+            size += next->second;
+            erase(next->first, next->second);
+        }
+        auto previous = byOffset.lower_bound(offset);
+        if (previous != byOffset.begin()) {
+            --previous;
+            if (previous->first + previous->second == offset) {
+                offset = previous->first;
+                size += previous->second;
+                erase(previous->first, previous->second);
+            }
+        }
+        insert(offset, size);
+    }
+
+    size_t freeSpace() const {
+        size_t total = 0;
+        for (const auto &range : byOffset)
+            total += range.second;
+        return total;
+    }
+
+    size_t largestFree() const { return bySize.empty() ? 0 : bySize.rbegin()->first; }
+    size_t freeRanges() const { return byOffset.size(); }
+    size_t size() const { return capacity; }
+
+private:
+    size_t capacity;
+    std::map<size_t, size_t> byOffset;         // offset -> size
+    std::multimap<size_t, size_t> bySize;      // size -> offset
+
+    void insert(size_t offset, size_t size) {
+        byOffset.emplace(offset, size);
+        bySize.emplace(size, offset);
+    }
+
+    void erase(size_t offset, size_t size) {
+        byOffset.erase(offset);
+        auto range = bySize.equal_range(size);
+        for (auto it = range.first; it != range.second; ++it)
+            if (it->second == offset) {
+                bySize.erase(it);
+                return;
+            }
+    }
+};
+
+/// Where a mesh lives in a GeometryArena.
+struct MeshRange {
+    uint32_t page = 0;
+    uint32_t baseVertex = 0;
+    uint32_t vertexCount = 0;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;    // 0 when the mesh couldn't be added
+
+    explicit operator bool() const { return indexCount != 0; }
+};
+
+/**
+ * @brief Keeps many meshes with the same vertex layout in a few large vertex
+ *        and index buffers, sharing one VAO per buffer pair.
+ *
+ * Each mesh is a range of vertices and a range of 32-bit indices, which stay
+ * relative to the mesh's first vertex and are drawn with
+ * glDrawElementsBaseVertex. Switching meshes is then just a different offset,
+ * not a VAO change, and a RenderQueue sorting by key can run through many
+ * meshes with no binds between them.
+ *
+ * When a page is full another is created, so a bad size estimate costs a VAO
+ * switch, not a failure. Meshes larger than a page get a page of their own.
+ */
+class GeometryArena {
+public:
+    /**
+     * @param layout Vertex format, e.g. from vertexpack::pack().layout.
+     * @param pageVertices, pageIndices Capacity of each buffer pair.
+     */
+    GeometryArena(const vertexpack::Layout &layout, size_t pageVertices = 1 << 20, size_t pageIndices = 3 << 20)
+        : layout(layout), pageVertices(pageVertices), pageIndices(pageIndices) {}
+
+    GeometryArena(const GeometryArena &) = delete;
+    GeometryArena &operator=(const GeometryArena &) = delete;
+
+    /**
+     * @brief Copies a mesh in. `vertices` are in the arena's layout; indices
+     *        count from 0 for this mesh. Returns an empty range for an empty
+     *        mesh.
+     */
+    MeshRange add(const void *vertices, size_t vertexCount, const uint32_t *indices, size_t indexCount) {
+        // Nothing can place an empty range, so don't make a page trying.
+        if (vertexCount == 0 || indexCount == 0)
+            return {};
+        for (size_t p = 0; p < pages.size(); ++p)
+            if (MeshRange range = place(p, vertices, vertexCount, indices, indexCount))
+                return range;
+        pages.push_back(std::make_unique<Page>(layout, std::max(pageVertices, vertexCount),
+                                               std::max(pageIndices, indexCount)));
+        return place(pages.size() - 1, vertices, vertexCount, indices, indexCount);
+    }
+
+    MeshRange add(const vertexpack::PackedVertices &vertices, const std::vector<uint32_t> &indices) {
+        return add(vertices.data.data(), vertices.count, indices.data(), indices.size());
+    }
+
+    /// Frees a mesh's ranges for reuse. Draws already issued are unaffected.
+    void remove(const MeshRange &range) {
+        if (!range)
+            return;
+        Page &page = *pages[range.page];
+        page.vertices.free(range.baseVertex, range.vertexCount);
+        page.indices.free(range.firstIndex, range.indexCount);
+    }
+
+    GLuint vao(const MeshRange &range) const { return pages[range.page]->VAO; }
+
+    /// Binds the mesh's VAO (if needed) and draws it.
+    void draw(const MeshRange &range, GLsizei instances = 1) {
+        GLuint wanted = vao(range);
+        if (wanted != boundVAO) {
+            glBindVertexArray(wanted);
+            boundVAO = wanted;
+        }
+        const void *offset = reinterpret_cast<const void *>(size_t(range.firstIndex) * sizeof(uint32_t));
+        if (instances == 1)
+            glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT, offset, range.baseVertex);
+        else
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT, offset, instances,
+                                              range.baseVertex);
+    }
+
+    /// Forget which VAO draw() last bound, after binding another elsewhere.
+    void invalidateBinding() { boundVAO = 0; }
+
+    /// A DrawPacket for a RenderQueue; fill in the textures.
+    DrawPacket packet(const MeshRange &range, GLuint program) const {
+        DrawPacket p;
+        p.program = program;
+        p.vao = vao(range);
+        p.indexCount = range.indexCount;
+        p.indexType = GL_UNSIGNED_INT;
+        p.firstIndexByte = range.firstIndex * sizeof(uint32_t);
+        p.baseVertex = range.baseVertex;
+        return p;
+    }
+
+    size_t pageCount() const { return pages.size(); }
+
+private:
+    struct Page {
+        GLuint VAO = 0, VBO = 0, EBO = 0;
+        RangeAllocator vertices, indices;
+
+        Page(const vertexpack::Layout &layout, size_t vertexCapacity, size_t indexCapacity)
+            : vertices(vertexCapacity), indices(indexCapacity) {
+            glGenVertexArrays(1, &VAO);
+            glBindVertexArray(VAO);
+            glGenBuffers(1, &VBO);
+            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+            glBufferData(GL_ARRAY_BUFFER, vertexCapacity * layout.stride, nullptr, GL_STATIC_DRAW);
+            layout.apply();
+            glGenBuffers(1, &EBO);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCapacity * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+            glBindVertexArray(0);
+        }
+
+        ~Page() {
+            glDeleteBuffers(1, &EBO);
+            glDeleteBuffers(1, &VBO);
+            glDeleteVertexArrays(1, &VAO);
+        }
+    };
+
+    vertexpack::Layout layout;
+    size_t pageVertices, pageIndices;
+    std::vector<std::unique_ptr<Page>> pages;
+    GLuint boundVAO = 0;
+
+    MeshRange place(size_t p, const void *vertices, size_t vertexCount, const uint32_t *indices, size_t indexCount) {
+        Page &page = *pages[p];
+        size_t baseVertex = page.vertices.allocate(vertexCount);
+        if (baseVertex == RangeAllocator::none)
+            return {};
+        size_t firstIndex = page.indices.allocate(indexCount);
+        if (firstIndex == RangeAllocator::none) {
+            page.vertices.free(baseVertex, vertexCount);
+            return {};
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, page.VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, baseVertex * layout.stride, vertexCount * layout.stride, vertices);
+        // The element buffer binding belongs to the VAO, so go through it.
+        glBindVertexArray(page.VAO);
+        boundVAO = page.VAO;
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, firstIndex * sizeof(uint32_t), indexCount * sizeof(uint32_t), indices);
+
+        MeshRange range;
+        range.page = static_cast<uint32_t>(p);
+        range.baseVertex = static_cast<uint32_t>(baseVertex);
+        range.vertexCount = static_cast<uint32_t>(vertexCount);
+        range.firstIndex = static_cast<uint32_t>(firstIndex);
+        range.indexCount = static_cast<uint32_t>(indexCount);
+        return range;
+    }
+};
+
+#endif
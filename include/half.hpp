@@ -0,0 +1,39 @@
+#ifndef HALF_HPP
+#define HALF_HPP
+
+#include "simd.hpp"
+#include <glm/gtc/packing.hpp>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(SIMD_X86)
+// Every CPU with AVX2 also has F16C, so the AVX2 level stands in for it.
+SIMD_TARGET("avx2,f16c") inline size_t floatToHalfF16c(const float *src, uint16_t *dst, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_loadu_ps(src + i);
+        __m128i h = _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), h);
+    }
+    return i;
+}
+#endif
+
+/**
+ * Converts floats to IEEE half floats. Uses F16C eight at a time when the CPU
+ * has it, otherwise glm's packHalf1x16.
+ *
+ * @note dst may alias src, since each half is written no later than the float
+ * it came from is read.
+ */
+inline void floatToHalf(const float *src, uint16_t *dst, size_t count) {
+    size_t i = 0;
+#if defined(SIMD_X86)
+    if (simd::runtimeLevel() >= simd::Level::Avx2)
+        i = floatToHalfF16c(src, dst, count);
+#endif
+    for (; i < count; ++i)
+        dst[i] = glm::packHalf1x16(src[i]);
+}
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef IMAGE_INFO_HPP
+#define IMAGE_INFO_HPP
+
+#include "texture.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief What an image will look like once decoded, read from its header
+ *        alone.
+ *
+ * Only the first few kilobytes of the file are read and handed to
+ * stbi_info_from_memory, so scanning a whole asset set costs a fraction of
+ * decoding it. The result accounts for the TextureDesc the image will later
+ * be loaded with (desired channels, 16-bit, HDR, sRGB).
+ */
+struct ImageInfo {
+    std::string path;
+    int width = 0, height = 0, nrChannels = 0;
+    Image::PixelType type = Image::PixelType::UInt8;
+    bool fileIs16Bit = false;  // without load16Bit, stbi_load narrows it to 8 bits
+    bool srgb = false;
+    bool valid = false;
+
+    ImageInfo() = default;
+
+    ImageInfo(const std::string &path, const TextureDesc &desc = {}) : path(path), srgb(desc.srgb) {
+        // Enough for every format's header except JPEGs with huge EXIF blocks,
+        // which fall through to stbi_info below.
+        const size_t headerBytes = 64 * 1024;
+
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return;
+        std::vector<unsigned char> head(headerBytes);
+        file.read(reinterpret_cast<char *>(head.data()), head.size());
+        int len = static_cast<int>(file.gcount());
+
+        int fileChannels = 0;
+        bool isHdr = false;
+        if (stbi_info_from_memory(head.data(), len, &width, &height, &fileChannels)) {
+            fileIs16Bit = stbi_is_16_bit_from_memory(head.data(), len);
+            isHdr = stbi_is_hdr_from_memory(head.data(), len);
+        } else if (stbi_info(path.c_str(), &width, &height, &fileChannels)) {
+            fileIs16Bit = stbi_is_16_bit(path.c_str());
+            isHdr = stbi_is_hdr(path.c_str());
+        } else {
+            return;
+        }
+
+        nrChannels = desc.desiredChannels ? desc.desiredChannels : fileChannels;
+        if (desc.loadHdr || isHdr)
+            type = Image::PixelType::Half;
+        else if (desc.load16Bit)
+            type = Image::PixelType::UInt16;
+        valid = true;
+    }
+
+    size_t bytesPerPixel() const {
+        return static_cast<size_t>(nrChannels) * (type == Image::PixelType::UInt8 ? 1 : 2);
+    }
+
+    /// Size of the pixel buffer Image will hold after decoding.
+    size_t decodedBytes() const {
+        return static_cast<size_t>(width) * height * bytesPerPixel();
+    }
+
+    /// Video memory for the full mip chain.
+    size_t gpuBytes() const {
+        size_t total = 0;
+        for (int w = width, h = height; ; w = std::max(w / 2, 1), h = std::max(h / 2, 1)) {
+            total += static_cast<size_t>(w) * h * bytesPerPixel();
+            if (w == 1 && h == 1)
+                break;
+        }
+        return total;
+    }
+
+    int mipLevels() const {
+        int levels = 1;
+        for (int size = std::max(width, height); size > 1; size /= 2)
+            ++levels;
+        return levels;
+    }
+};
+
+/**
+ * @brief The result of scanning a set of images before decoding any of them.
+ *
+ * decodeOrder lists indices into images from largest to smallest decoded
+ * size. Starting the big decodes first keeps one huge image from being the
+ * last thing every worker waits on.
+ */
+struct ImagePlan {
+    std::vector<ImageInfo> images;
+    std::vector<size_t> decodeOrder;
+    size_t totalGpuBytes = 0;
+    size_t largestDecodeBytes = 0;
+
+    bool fitsBudget(size_t vramBytes) const {
+        return totalGpuBytes <= vramBytes;
+    }
+};
+
+inline ImagePlan planImages(const std::vector<std::string> &paths, const TextureDesc &desc = {}) {
+    ImagePlan plan;
+    plan.images.reserve(paths.size());
+    for (const std::string &path : paths) {
+        plan.images.emplace_back(path, desc);
+        const ImageInfo &info = plan.images.back();
+        if (!info.valid) {
+            std::cout << "Failed to read image header: " << path << std::endl;
+            continue;
+        }
+        plan.decodeOrder.push_back(plan.images.size() - 1);
+        plan.totalGpuBytes += info.gpuBytes();
+        plan.largestDecodeBytes = std::max(plan.largestDecodeBytes, info.decodedBytes());
+    }
+
+    std::stable_sort(plan.decodeOrder.begin(), plan.decodeOrder.end(), [&](size_t a, size_t b) {
+        return plan.images[a].decodedBytes() > plan.images[b].decodedBytes();
+    });
+    return plan;
+}
+
+/**
+ * @brief Creates a texture with every mip level allocated but no pixels, so
+ *        GL storage exists before the decode finishes.
+ *
+ * Fill it later with uploadToStorage(). Returns 0 for an invalid ImageInfo.
+ */
+inline unsigned int allocateTextureStorage(const ImageInfo &info) {
+    if (!info.valid || info.nrChannels < 1 || info.nrChannels > 4) {
+        std::cout << "Cannot allocate storage for invalid image: " << info.path << std::endl;
+        return 0;
+    }
+
+    unsigned int ID;
+    glGenTextures(1, &ID);
+    glBindTexture(GL_TEXTURE_2D, ID);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    GLint internalFormat = Image::glInternalFormat(info.type, info.nrChannels, info.srgb);
+    GLenum format = Image::glFormat(info.nrChannels);
+    GLenum type = Image::glType(info.type);
+    int w = info.width, h = info.height;
+    for (int level = 0; level < info.mipLevels(); ++level) {
+        glTexImage2D(GL_TEXTURE_2D, level, internalFormat, w, h, 0, format, type, nullptr);
+        w = std::max(w / 2, 1);
+        h = std::max(h / 2, 1);
+    }
+    setChannelSwizzle(GL_TEXTURE_2D, info.nrChannels);
+    return ID;
+}
+
+/**
+ * @brief Uploads a decoded image into storage from allocateTextureStorage()
+ *        and rebuilds its mipmaps.
+ *
+ * @return false if the image doesn't match the storage it was planned for.
+ */
+inline bool uploadToStorage(unsigned int textureID, const ImageInfo &info, const Image &image) {
+    if (textureID == 0 || !image || image.width != info.width || image.height != info.height ||
+        image.nrChannels != info.nrChannels || image.type != info.type) {
+        std::cout << "Image does not match planned storage: " << info.path << std::endl;
+        return false;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(
+        GL_TEXTURE_2D, 0, 0, 0, image.width, image.height,
+        Image::glFormat(image.nrChannels), Image::glType(image.type), image.pixels
+    );
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    return true;
+}
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef INSTANCING_HPP
+#define INSTANCING_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Per-instance attributes. With the default first location of 3 the shader
+ * sees them as
+ *
+ *     layout (location = 3) in mat4 aModel;    // 3-6
+ *     layout (location = 7) in vec4 aInstanceColor;
+ *     layout (location = 8) in float aLayer;  // texture array layer
+ *
+ * See shaders/instanced.vert.
+ */
+struct InstanceData {
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::vec4 color = glm::vec4(1.0f);
+    float layer = 0.0f;
+};
+
+/**
+ * @brief Draws many copies of one indexed mesh with a single
+ *        glDrawElementsInstanced call.
+ *
+ * The instance data lives in its own VBO, attached to the mesh's VAO with a
+ * divisor of 1, so the mesh's vertex buffer and index buffer are untouched.
+ * Call `update()` with the instances for the frame, then `draw()`; instead of
+ * one draw call and a round of uniform updates per copy, it's one upload and
+ * one draw call in total.
+ *
+ * @note Uses six attribute locations starting at firstLocation; GL 3.3
+ * guarantees at least 16.
+ */
+class InstanceBuffer {
+public:
+    unsigned int ID = 0;
+
+    /**
+     * @param vao The mesh's VAO, with its vertex attributes and element
+     * buffer already set up.
+     */
+    explicit InstanceBuffer(unsigned int vao, GLuint firstLocation = 3) : vao(vao) {
+        glBindVertexArray(vao);
+        glGenBuffers(1, &ID);
+        glBindBuffer(GL_ARRAY_BUFFER, ID);
+
+        GLsizei stride = sizeof(InstanceData);
+        for (GLuint column = 0; column < 4; ++column) {
+            GLuint location = firstLocation + column;
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride,
+                                  (void *)(offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+        glVertexAttribPointer(firstLocation + 4, 4, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(InstanceData, color));
+        glEnableVertexAttribArray(firstLocation + 4);
+        glVertexAttribDivisor(firstLocation + 4, 1);
+        glVertexAttribPointer(firstLocation + 5, 1, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(InstanceData, layer));
+        glEnableVertexAttribArray(firstLocation + 5);
+        glVertexAttribDivisor(firstLocation + 5, 1);
+
+        glBindVertexArray(0);
+    }
+
+    ~InstanceBuffer() {
+        if (ID)
+            glDeleteBuffers(1, &ID);
+    }
+
+    InstanceBuffer(const InstanceBuffer &) = delete;
+    InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+
+    size_t size() const { return count; }
+
+    /**
+     * @brief Replaces the instance data.
+     *
+     * The old storage is orphaned rather than overwritten, so the driver
+     * doesn't have to wait for last frame's draw to finish reading it. The
+     * buffer grows geometrically and never shrinks.
+     */
+    void update(const InstanceData *instances, size_t instanceCount) {
+        glBindBuffer(GL_ARRAY_BUFFER, ID);
+        if (instanceCount > capacity)
+            capacity = std::max(instanceCount, capacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount * sizeof(InstanceData), instances);
+        count = instanceCount;
+    }
+
+    void update(const std::vector<InstanceData> &instances) {
+        update(instances.data(), instances.size());
+    }
+
+    /**
+     * @brief Draws every instance from the last update(). The caller binds
+     *        the shader and textures.
+     */
+    void draw(GLsizei indexCount, GLenum indexType = GL_UNSIGNED_INT, GLenum mode = GL_TRIANGLES) const {
+        if (count == 0)
+            return;
+        glBindVertexArray(vao);
+        glDrawElementsInstanced(mode, indexCount, indexType, nullptr, static_cast<GLsizei>(count));
+    }
+
+private:
+    unsigned int vao;
+    size_t capacity = 0;
+    size_t count = 0;
+};
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef JOB_POOL_HPP
+#define JOB_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A fixed set of worker threads for splitting loops across cores.
+ *
+ * `parallelFor` hands out chunks of an index range to the workers and the
+ * calling thread, and returns once every chunk has run. The workers sleep
+ * between calls, so keeping a pool around costs nothing while idle.
+ *
+ * @note One parallelFor runs at a time: calls from other threads, say two
+ * systems sharing defaultJobPool(), wait for it to finish. Calling it from
+ * inside a chunk runs the nested range on the calling thread instead.
+ */
+class JobPool {
+public:
+    /**
+     * @param workerCount Threads to start in addition to the caller. Defaults
+     * to one per remaining hardware thread.
+     */
+    explicit JobPool(unsigned workerCount = defaultWorkerCount()) {
+        for (unsigned i = 0; i < workerCount; ++i)
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~JobPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+    JobPool(const JobPool &) = delete;
+    JobPool &operator=(const JobPool &) = delete;
+
+    /// Threads that take part in a parallelFor, counting the caller.
+    unsigned threadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    /**
+     * @brief Calls fn(chunkBegin, chunkEnd) over [begin, end) in chunks of at
+     *        most `grain` indices and waits for all of them.
+     */
+    void parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)> &fn) {
+        if (end <= begin)
+            return;
+        grain = std::max<size_t>(grain, 1);
+        size_t chunks = (end - begin + grain - 1) / grain;
+        if (workers.empty() || chunks == 1 || insideJob) {
+            fn(begin, end);
+            return;
+        }
+
+        std::lock_guard<std::mutex> exclusive(callMutex);
+        Job job{&fn, begin, end, grain, chunks};
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // Workers that woke up late for the previous job may still be
+            // leaving it; don't reset the counters under them.
+            idle.wait(lock, [&] { return active == 0; });
+            current = job;
+            nextChunk = 0;
+            remaining = chunks;
+            ++generation;
+        }
+        wake.notify_all();
+
+        runChunks(job);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [&] { return remaining == 0 && active == 0; });
+    }
+
+    static unsigned defaultWorkerCount() {
+        unsigned hardware = std::thread::hardware_concurrency();
+        return hardware > 1 ? hardware - 1 : 0;
+    }
+
+private:
+    struct Job {
+        const std::function<void(size_t, size_t)> *fn = nullptr;
+        size_t begin = 0, end = 0, grain = 1, chunks = 0;
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex callMutex;   // held for a whole parallelFor
+    std::mutex mutex;
+    std::condition_variable wake, idle;
+
+    Job current;
+    unsigned long long generation = 0;
+    unsigned active = 0;
+    bool stopping = false;
+    std::atomic<size_t> nextChunk{0};
+    std::atomic<size_t> remaining{0};
+
+    static inline thread_local bool insideJob = false;
+
+    void runChunks(const Job &job) {
+        insideJob = true;
+        for (;;) {
+            size_t chunk = nextChunk.fetch_add(1);
+            if (chunk >= job.chunks)
+                break;
+            size_t chunkBegin = job.begin + chunk * job.grain;
+            (*job.fn)(chunkBegin, std::min(chunkBegin + job.grain, job.end));
+            remaining.fetch_sub(1);
+        }
+        insideJob = false;
+    }
+
+    void workerLoop() {
+        unsigned long long seen = 0;
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+                job = current;
+                ++active;
+            }
+
+            runChunks(job);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --active;
+            }
+            idle.notify_all();
+        }
+    }
+};
+
+/**
+ * @brief A process-wide pool, started on first use.
+ */
+inline JobPool &defaultJobPool() {
+    static JobPool pool;
+    return pool;
+}
+
+#endif
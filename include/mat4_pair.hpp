@@ -0,0 +1,235 @@
+#ifndef MAT4_PAIR_HPP
+#define MAT4_PAIR_HPP
+
+#include "simd.hpp"
+#include <glm/glm.hpp>
+#include <cstddef>
+
+/**
+ * AVX2/FMA kernels for ordinary glm::mat4 arrays that work on two matrices
+ * per instruction: the low 128-bit lane holds a column of one matrix and the
+ * high lane the same column of the next. Every shuffle used stays within its
+ * lane, so each half is exactly the SSE algorithm.
+ *
+ * Unlike batch::Mat4Batch, the data stays in glm's layout; use this for
+ * camera or skinning matrices that are already stored as glm::mat4.
+ *
+ * The array functions pick the AVX2 path at runtime and fall back to glm for
+ * older CPUs and the odd matrix at the end.
+ */
+namespace mat4pair {
+
+#if defined(SIMD_X86)
+namespace detail {
+
+SIMD_TARGET("avx2,fma") inline __m256 loadColumns(const glm::mat4 *m, int c) {
+    return _mm256_loadu2_m128(&m[1][c][0], &m[0][c][0]);
+}
+
+SIMD_TARGET("avx2,fma") inline void storeColumns(glm::mat4 *m, int c, __m256 v) {
+    _mm256_storeu2_m128(&m[1][c][0], &m[0][c][0], v);
+}
+
+#define MAT4PAIR_SHUFFLE(x, y, z, w) ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+
+// 2x2 matrices packed as (m00, m01, m10, m11) per lane.
+SIMD_TARGET("avx2,fma") inline __m256 mat2Mul(__m256 a, __m256 b) {
+    return _mm256_fmadd_ps(
+        a, _mm256_permute_ps(b, MAT4PAIR_SHUFFLE(0, 3, 0, 3)),
+        _mm256_mul_ps(
+            _mm256_permute_ps(a, MAT4PAIR_SHUFFLE(1, 0, 3, 2)),
+            _mm256_permute_ps(b, MAT4PAIR_SHUFFLE(2, 1, 2, 1))));
+}
+
+// adjugate(a) * b
+SIMD_TARGET("avx2,fma") inline __m256 mat2AdjMul(__m256 a, __m256 b) {
+    return _mm256_fmsub_ps(
+        _mm256_permute_ps(a, MAT4PAIR_SHUFFLE(3, 3, 0, 0)), b,
+        _mm256_mul_ps(
+            _mm256_permute_ps(a, MAT4PAIR_SHUFFLE(1, 1, 2, 2)),
+            _mm256_permute_ps(b, MAT4PAIR_SHUFFLE(2, 3, 0, 1))));
+}
+
+// a * adjugate(b)
+SIMD_TARGET("avx2,fma") inline __m256 mat2MulAdj(__m256 a, __m256 b) {
+    return _mm256_fmsub_ps(
+        a, _mm256_permute_ps(b, MAT4PAIR_SHUFFLE(3, 0, 3, 0)),
+        _mm256_mul_ps(
+            _mm256_permute_ps(a, MAT4PAIR_SHUFFLE(1, 0, 3, 2)),
+            _mm256_permute_ps(b, MAT4PAIR_SHUFFLE(2, 1, 2, 1))));
+}
+
+/**
+ * Block-matrix inverse: split M into 2x2 blocks A B / C D and build the
+ * inverse from their determinants and adjugates. Since inverse and transpose
+ * commute, the row-major derivation applies to glm's columns unchanged.
+ * Writes the determinant of each matrix (broadcast) to *det.
+ */
+SIMD_TARGET("avx2,fma") inline void inverseAndDeterminant(const __m256 m[4], __m256 out[4], __m256 *det) {
+    __m256 A = _mm256_shuffle_ps(m[0], m[1], MAT4PAIR_SHUFFLE(0, 1, 0, 1));
+    __m256 B = _mm256_shuffle_ps(m[0], m[1], MAT4PAIR_SHUFFLE(2, 3, 2, 3));
+    __m256 C = _mm256_shuffle_ps(m[2], m[3], MAT4PAIR_SHUFFLE(0, 1, 0, 1));
+    __m256 D = _mm256_shuffle_ps(m[2], m[3], MAT4PAIR_SHUFFLE(2, 3, 2, 3));
+
+    // (|A|, |B|, |C|, |D|)
+    __m256 detSub = _mm256_fmsub_ps(
+        _mm256_shuffle_ps(m[0], m[2], MAT4PAIR_SHUFFLE(0, 2, 0, 2)),
+        _mm256_shuffle_ps(m[1], m[3], MAT4PAIR_SHUFFLE(1, 3, 1, 3)),
+        _mm256_mul_ps(
+            _mm256_shuffle_ps(m[0], m[2], MAT4PAIR_SHUFFLE(1, 3, 1, 3)),
+            _mm256_shuffle_ps(m[1], m[3], MAT4PAIR_SHUFFLE(0, 2, 0, 2))));
+    __m256 detA = _mm256_permute_ps(detSub, MAT4PAIR_SHUFFLE(0, 0, 0, 0));
+    __m256 detB = _mm256_permute_ps(detSub, MAT4PAIR_SHUFFLE(1, 1, 1, 1));
+    __m256 detC = _mm256_permute_ps(detSub, MAT4PAIR_SHUFFLE(2, 2, 2, 2));
+    __m256 detD = _mm256_permute_ps(detSub, MAT4PAIR_SHUFFLE(3, 3, 3, 3));
+
+    __m256 DC = mat2AdjMul(D, C);
+    __m256 AB = mat2AdjMul(A, B);
+    __m256 X = _mm256_fmsub_ps(detD, A, mat2Mul(B, DC));
+    __m256 W = _mm256_fmsub_ps(detA, D, mat2Mul(C, AB));
+    __m256 Y = _mm256_fmsub_ps(detB, C, mat2MulAdj(D, AB));
+    __m256 Z = _mm256_fmsub_ps(detC, B, mat2MulAdj(A, DC));
+
+    // |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+    __m256 tr = _mm256_mul_ps(AB, _mm256_permute_ps(DC, MAT4PAIR_SHUFFLE(0, 2, 1, 3)));
+    tr = _mm256_hadd_ps(tr, tr);
+    tr = _mm256_hadd_ps(tr, tr);
+    __m256 detM = _mm256_fmadd_ps(detA, detD, _mm256_fmsub_ps(detB, detC, tr));
+    *det = detM;
+
+    __m256 rDetM = _mm256_div_ps(_mm256_setr_ps(1.f, -1.f, -1.f, 1.f, 1.f, -1.f, -1.f, 1.f), detM);
+    X = _mm256_mul_ps(X, rDetM);
+    Y = _mm256_mul_ps(Y, rDetM);
+    Z = _mm256_mul_ps(Z, rDetM);
+    W = _mm256_mul_ps(W, rDetM);
+
+    out[0] = _mm256_shuffle_ps(X, Y, MAT4PAIR_SHUFFLE(3, 1, 3, 1));
+    out[1] = _mm256_shuffle_ps(X, Y, MAT4PAIR_SHUFFLE(2, 0, 2, 0));
+    out[2] = _mm256_shuffle_ps(Z, W, MAT4PAIR_SHUFFLE(3, 1, 3, 1));
+    out[3] = _mm256_shuffle_ps(Z, W, MAT4PAIR_SHUFFLE(2, 0, 2, 0));
+}
+
+#undef MAT4PAIR_SHUFFLE
+
+SIMD_TARGET("avx2,fma") inline void multiply2(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *out) {
+    __m256 ac[4];
+    for (int k = 0; k < 4; ++k)
+        ac[k] = loadColumns(a, k);
+
+    __m256 r[4];
+    for (int c = 0; c < 4; ++c) {
+        __m256 bc = loadColumns(b, c);
+        __m256 sum = _mm256_mul_ps(ac[0], _mm256_permute_ps(bc, 0x00));
+        sum = _mm256_fmadd_ps(ac[1], _mm256_permute_ps(bc, 0x55), sum);
+        sum = _mm256_fmadd_ps(ac[2], _mm256_permute_ps(bc, 0xAA), sum);
+        r[c] = _mm256_fmadd_ps(ac[3], _mm256_permute_ps(bc, 0xFF), sum);
+    }
+    for (int c = 0; c < 4; ++c)
+        storeColumns(out, c, r[c]);
+}
+
+SIMD_TARGET("avx2,fma") inline void transpose2(const glm::mat4 *m, glm::mat4 *out) {
+    __m256 c0 = loadColumns(m, 0), c1 = loadColumns(m, 1);
+    __m256 c2 = loadColumns(m, 2), c3 = loadColumns(m, 3);
+    __m256 t0 = _mm256_unpacklo_ps(c0, c1);
+    __m256 t1 = _mm256_unpacklo_ps(c2, c3);
+    __m256 t2 = _mm256_unpackhi_ps(c0, c1);
+    __m256 t3 = _mm256_unpackhi_ps(c2, c3);
+    storeColumns(out, 0, _mm256_shuffle_ps(t0, t1, 0x44));
+    storeColumns(out, 1, _mm256_shuffle_ps(t0, t1, 0xEE));
+    storeColumns(out, 2, _mm256_shuffle_ps(t2, t3, 0x44));
+    storeColumns(out, 3, _mm256_shuffle_ps(t2, t3, 0xEE));
+}
+
+SIMD_TARGET("avx2,fma") inline void inverse2(const glm::mat4 *m, glm::mat4 *out) {
+    __m256 in[4], r[4], det;
+    for (int c = 0; c < 4; ++c)
+        in[c] = loadColumns(m, c);
+    inverseAndDeterminant(in, r, &det);
+    for (int c = 0; c < 4; ++c)
+        storeColumns(out, c, r[c]);
+}
+
+SIMD_TARGET("avx2,fma") inline void determinant2(const glm::mat4 *m, float *out) {
+    __m256 in[4], r[4], det;
+    for (int c = 0; c < 4; ++c)
+        in[c] = loadColumns(m, c);
+    inverseAndDeterminant(in, r, &det);
+    out[0] = _mm256_cvtss_f32(det);
+    out[1] = _mm256_cvtss_f32(_mm256_permute2f128_ps(det, det, 0x01));
+}
+
+// Runs pair(i) over every full pair when AVX2 is available and single(i)
+// over whatever is left.
+template <class Pair, class Single>
+inline void forEachPair(size_t count, Pair pair, Single single) {
+    size_t i = 0;
+    if (simd::runtimeLevel() >= simd::Level::Avx2)
+        for (; i + 2 <= count; i += 2)
+            pair(i);
+    for (; i < count; ++i)
+        single(i);
+}
+
+}
+#endif
+
+/**
+ * @brief out[i] = a[i] * b[i]. out may alias a or b.
+ */
+inline void multiply(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *out, size_t count) {
+#if defined(SIMD_X86)
+    detail::forEachPair(count,
+        [&](size_t i) { detail::multiply2(a + i, b + i, out + i); },
+        [&](size_t i) { out[i] = a[i] * b[i]; });
+#else
+    for (size_t i = 0; i < count; ++i)
+        out[i] = a[i] * b[i];
+#endif
+}
+
+/**
+ * @brief out[i] = inverse(m[i]). out may alias m.
+ */
+inline void inverse(const glm::mat4 *m, glm::mat4 *out, size_t count) {
+#if defined(SIMD_X86)
+    detail::forEachPair(count,
+        [&](size_t i) { detail::inverse2(m + i, out + i); },
+        [&](size_t i) { out[i] = glm::inverse(m[i]); });
+#else
+    for (size_t i = 0; i < count; ++i)
+        out[i] = glm::inverse(m[i]);
+#endif
+}
+
+/**
+ * @brief out[i] = transpose(m[i]). out may alias m.
+ */
+inline void transpose(const glm::mat4 *m, glm::mat4 *out, size_t count) {
+#if defined(SIMD_X86)
+    detail::forEachPair(count,
+        [&](size_t i) { detail::transpose2(m + i, out + i); },
+        [&](size_t i) { out[i] = glm::transpose(m[i]); });
+#else
+    for (size_t i = 0; i < count; ++i)
+        out[i] = glm::transpose(m[i]);
+#endif
+}
+
+/**
+ * @brief out[i] = determinant(m[i]).
+ */
+inline void determinant(const glm::mat4 *m, float *out, size_t count) {
+#if defined(SIMD_X86)
+    detail::forEachPair(count,
+        [&](size_t i) { detail::determinant2(m + i, out + i); },
+        [&](size_t i) { out[i] = glm::determinant(m[i]); });
+#else
+    for (size_t i = 0; i < count; ++i)
+        out[i] = glm::determinant(m[i]);
+#endif
+}
+
+}
+
+#endif
@@ -0,0 +1,345 @@
+#ifndef MESH_FORMAT_HPP
+#define MESH_FORMAT_HPP
+
+#include "vertex_pack.hpp"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * The cooked mesh format: everything a mesh needs at runtime, already in the
+ * shape the GPU wants, so loading is a map and an upload with no parsing.
+ *
+ *     Header
+ *     AttributeRecord[attributeCount]   vertexpack attributes of the vertex data
+ *     LodRecord[lodCount]               index ranges, most detailed first
+ *     vertex data                       vertexCount * vertexStride bytes
+ *     index data                        indexCount uint32_t
+ *
+ * Every section starts on a 16-byte boundary, so the vertex and index blobs
+ * can be handed to glBufferData straight from the mapping. Files are written
+ * by tools/obj2mesh and are little-endian.
+ */
+namespace meshfile {
+
+constexpr uint32_t magic = 0x4853454D;    // "MESH"
+constexpr uint32_t version = 1;
+constexpr size_t sectionAlignment = 16;
+
+struct AttributeRecord {
+    uint32_t location;
+    uint32_t components;
+    uint32_t format;    // vertexpack::Format
+    uint32_t reserved;
+};
+
+struct LodRecord {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;        // simplification error in object-space units, 0 for the original
+    uint32_t reserved;
+};
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t vertexStride;
+    uint32_t attributeCount;
+    uint32_t lodCount;
+    uint32_t reserved;
+    float boundsMin[3];
+    float boundsMax[3];
+    float sphereCenter[3];
+    float sphereRadius;
+    uint64_t attributesOffset;
+    uint64_t lodsOffset;
+    uint64_t verticesOffset;
+    uint64_t indicesOffset;
+    uint64_t fileSize;
+};
+
+/// A mesh ready to write out.
+struct CookedMesh {
+    std::vector<vertexpack::Attribute> attributes;
+    vertexpack::PackedVertices vertices;
+    std::vector<uint32_t> indices;
+    std::vector<LodRecord> lods;    // empty means one LOD covering every index
+    glm::vec3 boundsMin = glm::vec3(0.0f), boundsMax = glm::vec3(0.0f);
+    glm::vec3 sphereCenter = glm::vec3(0.0f);
+    float sphereRadius = 0.0f;
+};
+
+namespace detail {
+
+inline uint64_t alignUp(uint64_t offset) {
+    return (offset + sectionAlignment - 1) / sectionAlignment * sectionAlignment;
+}
+
+}
+
+/**
+ * @brief Writes a cooked mesh. Prints and returns false if the file can't be
+ *        written.
+ */
+inline bool write(const std::string &path, const CookedMesh &mesh) {
+    std::vector<LodRecord> lods = mesh.lods;
+    if (lods.empty())
+        lods.push_back({0, static_cast<uint32_t>(mesh.indices.size()), 0.0f, 0});
+
+    Header header = {};
+    header.magic = magic;
+    header.version = version;
+    header.vertexCount = static_cast<uint32_t>(mesh.vertices.count);
+    header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    header.vertexStride = static_cast<uint32_t>(mesh.vertices.layout.stride);
+    header.attributeCount = static_cast<uint32_t>(mesh.attributes.size());
+    header.lodCount = static_cast<uint32_t>(lods.size());
+    for (int i = 0; i < 3; ++i) {
+        header.boundsMin[i] = mesh.boundsMin[i];
+        header.boundsMax[i] = mesh.boundsMax[i];
+        header.sphereCenter[i] = mesh.sphereCenter[i];
+    }
+    header.sphereRadius = mesh.sphereRadius;
+    header.attributesOffset = detail::alignUp(sizeof(Header));
+    header.lodsOffset = detail::alignUp(header.attributesOffset + header.attributeCount * sizeof(AttributeRecord));
+    header.verticesOffset = detail::alignUp(header.lodsOffset + header.lodCount * sizeof(LodRecord));
+    header.indicesOffset = detail::alignUp(header.verticesOffset + mesh.vertices.bytes());
+    header.fileSize = header.indicesOffset + mesh.indices.size() * sizeof(uint32_t);
+
+    std::vector<unsigned char> file(header.fileSize, 0);
+    std::memcpy(file.data(), &header, sizeof(Header));
+    for (size_t i = 0; i < mesh.attributes.size(); ++i) {
+        const vertexpack::Attribute &a = mesh.attributes[i];
+        AttributeRecord record = {a.location, static_cast<uint32_t>(a.components), static_cast<uint32_t>(a.format), 0};
+        std::memcpy(file.data() + header.attributesOffset + i * sizeof(AttributeRecord), &record, sizeof(record));
+    }
+    std::memcpy(file.data() + header.lodsOffset, lods.data(), lods.size() * sizeof(LodRecord));
+    std::memcpy(file.data() + header.verticesOffset, mesh.vertices.data.data(), mesh.vertices.bytes());
+    std::memcpy(file.data() + header.indicesOffset, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+
+    std::FILE *out = std::fopen(path.c_str(), "wb");
+    bool ok = out && std::fwrite(file.data(), 1, file.size(), out) == file.size();
+    if (out)
+        ok = std::fclose(out) == 0 && ok;
+    if (!ok)
+        std::cout << "Failed to write mesh file: " << path << std::endl;
+    return ok;
+}
+
+/**
+ * @brief Picks the coarsest LOD whose error covers at most `maxPixelError`
+ *        pixels on screen.
+ *
+ * The bounding sphere is projected with `modelViewProjection`, and errors are
+ * scaled as if at the sphere's nearest point, so the choice errs towards
+ * detail. Objects whose sphere reaches the camera plane get LOD 0.
+ *
+ *     size_t level = meshfile::selectLod(lods, count, projection * view * model,
+ *                                        center, radius, viewportHeight);
+ *     MeshRange range = mesh;    // as added to a GeometryArena, all LODs together
+ *     range.firstIndex += lods[level].firstIndex;
+ *     range.indexCount = lods[level].indexCount;
+ *
+ * @param lods Most detailed first, errors increasing; at least one.
+ * @param sphereCenter, sphereRadius Object-space bounding sphere.
+ */
+inline size_t selectLod(const LodRecord *lods, size_t lodCount, const glm::mat4 &modelViewProjection,
+                        const glm::vec3 &sphereCenter, float sphereRadius, float viewportHeight,
+                        float maxPixelError = 1.0f) {
+    const glm::mat4 &m = modelViewProjection;
+    // With a rigid view, clip y changes by |row 1| per object-space unit and
+    // w by |row 3| (0 for orthographic), whichever way the unit points.
+    float yPerUnit = glm::length(glm::vec3(m[0][1], m[1][1], m[2][1]));
+    float wPerUnit = glm::length(glm::vec3(m[0][3], m[1][3], m[2][3]));
+    float nearest = (m * glm::vec4(sphereCenter, 1.0f)).w - sphereRadius * wPerUnit;
+    if (nearest <= 0.0f)
+        return 0;
+    float pixelsPerUnit = yPerUnit / nearest * viewportHeight * 0.5f;
+
+    size_t level = 0;
+    while (level + 1 < lodCount && lods[level + 1].error * pixelsPerUnit <= maxPixelError)
+        ++level;
+    return level;
+}
+
+/**
+ * @brief A cooked mesh file mapped into memory. Move-only; the pointers it
+ *        hands out live as long as it does.
+ *
+ *     meshfile::MeshFile file("../meshes/teapot.mesh");
+ *     GeometryArena arena(file.layout());
+ *     MeshRange range = arena.add(file.vertices(), file.vertexCount(), file.indices(), file.indexCount());
+ *
+ * Opening checks the header, the attribute and LOD tables, and that every
+ * section lies inside the file; the vertex and index data aren't read until
+ * they're used.
+ */
+class MeshFile {
+public:
+    MeshFile() = default;
+
+    explicit MeshFile(const std::string &path) {
+        if (!map(path) || !validate()) {
+            std::cout << "Failed to load mesh: " << path << std::endl;
+            unmap();
+        }
+    }
+
+    MeshFile(MeshFile &&other) noexcept { *this = std::move(other); }
+
+    MeshFile &operator=(MeshFile &&other) noexcept {
+        if (this != &other) {
+            unmap();
+            bytes = std::exchange(other.bytes, nullptr);
+            size = std::exchange(other.size, 0);
+#ifdef _WIN32
+            buffer = std::move(other.buffer);
+#endif
+        }
+        return *this;
+    }
+
+    MeshFile(const MeshFile &) = delete;
+    MeshFile &operator=(const MeshFile &) = delete;
+
+    ~MeshFile() { unmap(); }
+
+    explicit operator bool() const { return bytes != nullptr; }
+
+    const Header &header() const { return *reinterpret_cast<const Header *>(bytes); }
+
+    size_t vertexCount() const { return header().vertexCount; }
+    size_t indexCount() const { return header().indexCount; }
+    const void *vertices() const { return bytes + header().verticesOffset; }
+    const uint32_t *indices() const { return reinterpret_cast<const uint32_t *>(bytes + header().indicesOffset); }
+    size_t vertexBytes() const { return vertexCount() * header().vertexStride; }
+
+    size_t lodCount() const { return header().lodCount; }
+    const LodRecord &lod(size_t i) const {
+        return reinterpret_cast<const LodRecord *>(bytes + header().lodsOffset)[i];
+    }
+
+    /// selectLod() with the file's LOD table and bounding sphere.
+    size_t selectLod(const glm::mat4 &modelViewProjection, float viewportHeight, float maxPixelError = 1.0f) const {
+        const Header &h = header();
+        return meshfile::selectLod(&lod(0), lodCount(), modelViewProjection,
+                                   glm::vec3(h.sphereCenter[0], h.sphereCenter[1], h.sphereCenter[2]),
+                                   h.sphereRadius, viewportHeight, maxPixelError);
+    }
+
+    std::vector<vertexpack::Attribute> attributes() const {
+        std::vector<vertexpack::Attribute> result;
+        const auto *records = reinterpret_cast<const AttributeRecord *>(bytes + header().attributesOffset);
+        for (uint32_t i = 0; i < header().attributeCount; ++i)
+            result.push_back({records[i].location, static_cast<int>(records[i].components),
+                              static_cast<vertexpack::Format>(records[i].format), 0});
+        return result;
+    }
+
+    vertexpack::Layout layout() const { return vertexpack::Layout(attributes()); }
+
+private:
+    const unsigned char *bytes = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    std::vector<unsigned char> buffer;
+#endif
+
+    bool map(const std::string &path) {
+#ifdef _WIN32
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+            return false;
+        buffer.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char *>(buffer.data()), buffer.size()))
+            return false;
+        bytes = buffer.data();
+        size = buffer.size();
+        return size > 0;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void *mapped = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED)
+            return false;
+        bytes = static_cast<const unsigned char *>(mapped);
+        size = static_cast<size_t>(info.st_size);
+        return true;
+#endif
+    }
+
+    void unmap() {
+#ifdef _WIN32
+        buffer.clear();
+#else
+        if (bytes)
+            ::munmap(const_cast<unsigned char *>(bytes), size);
+#endif
+        bytes = nullptr;
+        size = 0;
+    }
+
+    bool validate() const {
+        if (size < sizeof(Header))
+            return false;
+        const Header &h = header();
+        if (h.magic != magic || h.version != version || h.fileSize != size)
+            return false;
+        auto inside = [&](uint64_t offset, uint64_t length) {
+            return offset % sectionAlignment == 0 && offset <= size && length <= size - offset;
+        };
+        if (!inside(h.attributesOffset, uint64_t(h.attributeCount) * sizeof(AttributeRecord))
+            || !inside(h.lodsOffset, uint64_t(h.lodCount) * sizeof(LodRecord))
+            || !inside(h.verticesOffset, uint64_t(h.vertexCount) * h.vertexStride)
+            || !inside(h.indicesOffset, uint64_t(h.indexCount) * sizeof(uint32_t)))
+            return false;
+
+        // Attribute records go straight to vertexpack::Layout and
+        // glVertexAttribPointer, so only accept what those understand. GL
+        // guarantees 16 attribute locations.
+        const auto *records = reinterpret_cast<const AttributeRecord *>(bytes + h.attributesOffset);
+        for (uint32_t i = 0; i < h.attributeCount; ++i)
+            if (records[i].location >= 16 || records[i].components < 1 || records[i].components > 4
+                || records[i].format > static_cast<uint32_t>(vertexpack::Format::Unorm10x3_2))
+                return false;
+        if (vertexpack::Layout(attributes()).stride != h.vertexStride)
+            return false;
+
+        // LOD 0 is the full mesh, and callers index it unconditionally.
+        if (h.lodCount == 0)
+            return false;
+        for (uint32_t i = 0; i < h.lodCount; ++i)
+            if (uint64_t(lod(i).firstIndex) + lod(i).indexCount > h.indexCount)
+                return false;
+        return true;
+    }
+};
+
+}
+
+#endif
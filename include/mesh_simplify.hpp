@@ -0,0 +1,394 @@
+#ifndef MESH_SIMPLIFY_HPP
+#define MESH_SIMPLIFY_HPP
+
+#include "mesh_optimize.hpp"
+#include "radix_sort.hpp"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/**
+ * Edge-collapse simplification driven by quadric error metrics (Garland and
+ * Heckbert, "Surface Simplification Using Quadric Error Metrics", 1997), for
+ * building LOD chains when a mesh is cooked.
+ *
+ * Every collapse moves a vertex onto one of its neighbours, so the result
+ * only indexes vertices the mesh already has: all LODs share one vertex
+ * buffer and differ only in their indices.
+ *
+ * Vertices are matched by position, so the split copies (wedges) along a UV
+ * or normal seam move together. Border and seam vertices only slide along
+ * their border or seam, each wedge onto the matching wedge at the other end;
+ * vertices where borders or seams meet or cross stay put. In a flat-shaded
+ * mesh nearly every vertex is such a meeting point, so little can be
+ * collapsed.
+ */
+namespace meshopt {
+
+namespace detail {
+
+// The sum of squared distances to a set of weighted planes, as
+// p'Ap + 2b.p + c, plus the total weight for turning it into a mean.
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+    double b0 = 0, b1 = 0, b2 = 0, c = 0, weight = 0;
+
+    void addPlane(const glm::dvec3 &n, double d, double w) {
+        a00 += w * n.x * n.x, a01 += w * n.x * n.y, a02 += w * n.x * n.z;
+        a11 += w * n.y * n.y, a12 += w * n.y * n.z, a22 += w * n.z * n.z;
+        b0 += w * n.x * d, b1 += w * n.y * d, b2 += w * n.z * d;
+        c += w * d * d;
+        weight += w;
+    }
+
+    void operator+=(const Quadric &q) {
+        a00 += q.a00, a01 += q.a01, a02 += q.a02, a11 += q.a11, a12 += q.a12, a22 += q.a22;
+        b0 += q.b0, b1 += q.b1, b2 += q.b2, c += q.c;
+        weight += q.weight;
+    }
+
+    double sum(const glm::dvec3 &p) const {
+        double r = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z
+                   + 2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z)
+                   + 2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+        return std::max(r, 0.0);
+    }
+};
+
+enum class VertexKind : uint8_t { Manifold, Border, Seam, Locked };
+
+// Each vertex's first vertex with the same position.
+inline std::vector<uint32_t> positionRemap(const float *positions, size_t vertexCount, int floatsPerVertex) {
+    struct Key {
+        float p[3];
+        bool operator==(const Key &o) const { return std::memcmp(p, o.p, sizeof(p)) == 0; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key &k) const {
+            uint32_t h[3];
+            std::memcpy(h, k.p, sizeof(h));
+            return (h[0] * 73856093u) ^ (h[1] * 19349663u) ^ (h[2] * 83492791u);
+        }
+    };
+    std::unordered_map<Key, uint32_t, KeyHash> first;
+    std::vector<uint32_t> remap(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        const float *p = positions + v * floatsPerVertex;
+        Key key{{p[0] + 0.0f, p[1] + 0.0f, p[2] + 0.0f}};    // +0 folds -0 into 0
+        remap[v] = first.emplace(key, static_cast<uint32_t>(v)).first->second;
+    }
+    return remap;
+}
+
+inline uint64_t edgeKey(uint32_t from, uint32_t to) { return uint64_t(from) << 32 | to; }
+
+// For each corner of the `from` position in the triangles around it, the
+// vertex at `to` in the same triangle. Fails if a wedge of `from` has no
+// neighbour at `to`, or two different ones: the collapse would mix up
+// attributes across a seam.
+inline bool matchWedges(const uint32_t *vertexIndices, const uint32_t *positionIndices, const Adjacency &adjacency,
+                        uint32_t from, uint32_t to, std::vector<std::pair<uint32_t, uint32_t>> &pairs) {
+    pairs.clear();
+    for (uint32_t k = adjacency.offsets[from]; k < adjacency.offsets[from + 1]; ++k) {
+        size_t t = size_t(adjacency.triangles[k]) * 3;
+        uint32_t wedge = UINT32_MAX, partner = UINT32_MAX;
+        for (int c = 0; c < 3; ++c) {
+            if (positionIndices[t + c] == from)
+                wedge = vertexIndices[t + c];
+            else if (positionIndices[t + c] == to)
+                partner = vertexIndices[t + c];
+        }
+        auto known = std::find_if(pairs.begin(), pairs.end(), [&](const auto &p) { return p.first == wedge; });
+        if (known == pairs.end())
+            pairs.push_back({wedge, partner});
+        else if (known->second == UINT32_MAX)
+            known->second = partner;
+        else if (partner != UINT32_MAX && partner != known->second)
+            return false;
+    }
+    for (const auto &p : pairs)
+        if (p.second == UINT32_MAX)
+            return false;
+    return true;
+}
+
+}
+
+/**
+ * @brief Simplifies a triangle list towards `targetIndexCount` indices,
+ *        writing the result to `destination`.
+ *
+ * @param destination Room for indexCount indices; may be `indices`.
+ * @param positions xyz at the start of each vertex, `floatsPerVertex` apart.
+ * @param targetError Largest error allowed for a collapse, in the units of
+ * the positions; simplification stops early rather than exceed it.
+ * @param resultError If given, receives the error of the worst collapse made:
+ * the RMS distance from the collapsed vertex's original neighbourhood to
+ * where it ended up. 0 if nothing was collapsed.
+ * @param resultLocked If given, receives how many of the vertices the
+ * indices use can't move at all, being where borders or seams meet.
+ * @return The number of indices written. It can stay above the target when
+ * the mesh runs out of collapses that keep its borders, seams and
+ * orientation.
+ */
+inline size_t simplify(uint32_t *destination, const uint32_t *indices, size_t indexCount, const float *positions,
+                       size_t vertexCount, int floatsPerVertex, size_t targetIndexCount,
+                       float targetError = FLT_MAX, float *resultError = nullptr,
+                       size_t *resultLocked = nullptr) {
+    using detail::VertexKind;
+    std::vector<uint32_t> result(indices, indices + indexCount);
+    std::vector<uint32_t> remap = detail::positionRemap(positions, vertexCount, floatsPerVertex);
+    auto position = [&](uint32_t v) {
+        const float *p = positions + size_t(v) * floatsPerVertex;
+        return glm::dvec3(p[0], p[1], p[2]);
+    };
+
+    // Borders: edges with no opposite half-edge. Seams: edges whose opposite
+    // half-edge joins other wedges of the same two positions. A vertex on
+    // exactly one border or seam can slide along it; others are locked.
+    std::unordered_set<uint64_t> halfEdges, wedgeHalfEdges, seamEdges;
+    halfEdges.reserve(indexCount);
+    wedgeHalfEdges.reserve(indexCount);
+    for (size_t t = 0; t < indexCount; t += 3)
+        for (int e = 0; e < 3; ++e) {
+            uint32_t a = result[t + e], b = result[t + (e + 1) % 3];
+            halfEdges.insert(detail::edgeKey(remap[a], remap[b]));
+            wedgeHalfEdges.insert(detail::edgeKey(a, b));
+        }
+    auto isBorder = [&](uint32_t a, uint32_t b) { return !halfEdges.count(detail::edgeKey(b, a)); };
+    // Both sides of a seam edge see it; it's stored once, lower position first.
+    auto isSeam = [&](uint32_t a, uint32_t b) {
+        return seamEdges.count(detail::edgeKey(std::min(a, b), std::max(a, b))) != 0;
+    };
+
+    std::vector<uint8_t> seamCount(vertexCount, 0);
+    for (size_t t = 0; t < indexCount; t += 3)
+        for (int e = 0; e < 3; ++e) {
+            uint32_t a = result[t + e], b = result[t + (e + 1) % 3];
+            uint32_t pa = remap[a], pb = remap[b];
+            if (pa == pb || isBorder(pa, pb) || wedgeHalfEdges.count(detail::edgeKey(b, a)))
+                continue;
+            if (seamEdges.insert(detail::edgeKey(std::min(pa, pb), std::max(pa, pb))).second) {
+                seamCount[pa] = uint8_t(std::min(seamCount[pa] + 1, 3));
+                seamCount[pb] = uint8_t(std::min(seamCount[pb] + 1, 3));
+            }
+        }
+
+    // Positions with more than one wedge are on a seam.
+    std::vector<uint32_t> wedge(vertexCount, UINT32_MAX);
+    std::vector<VertexKind> kind(vertexCount, VertexKind::Manifold);
+    for (uint32_t v : result) {
+        uint32_t &w = wedge[remap[v]];
+        if (w == UINT32_MAX)
+            w = v;
+        else if (w != v)
+            kind[remap[v]] = seamCount[remap[v]] == 2 ? VertexKind::Seam : VertexKind::Locked;
+    }
+
+    std::vector<detail::Quadric> quadrics(vertexCount);
+    std::vector<uint8_t> borderEdges(vertexCount, 0);
+    for (size_t t = 0; t < indexCount; t += 3) {
+        uint32_t v[3] = {remap[result[t]], remap[result[t + 1]], remap[result[t + 2]]};
+        glm::dvec3 p0 = position(v[0]), p1 = position(v[1]), p2 = position(v[2]);
+        glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+        double length = glm::length(normal);
+        if (length == 0.0)
+            continue;
+        normal /= length;
+        // Weighted by area, so a fine region doesn't outvote a coarse one.
+        for (uint32_t corner : v)
+            quadrics[corner].addPlane(normal, -glm::dot(normal, p0), length * 0.5);
+
+        for (int e = 0; e < 3; ++e) {
+            uint32_t a = v[e], b = v[(e + 1) % 3];
+            if (a == b)
+                continue;
+            if (isBorder(a, b)) {
+                borderEdges[a] = uint8_t(std::min(borderEdges[a] + 1, 3));
+                borderEdges[b] = uint8_t(std::min(borderEdges[b] + 1, 3));
+            } else if (!isSeam(a, b)) {
+                continue;
+            }
+            // A plane through the edge, perpendicular to the triangle, keeps
+            // the border or seam from pulling in.
+            glm::dvec3 edge = position(b) - position(a);
+            double edgeLength = glm::length(edge);
+            glm::dvec3 side = glm::normalize(glm::cross(edge, normal));
+            double d = -glm::dot(side, position(a));
+            quadrics[a].addPlane(side, d, 10.0 * edgeLength * edgeLength);
+            quadrics[b].addPlane(side, d, 10.0 * edgeLength * edgeLength);
+        }
+    }
+    for (size_t v = 0; v < vertexCount; ++v)
+        if (borderEdges[v] != 0)
+            kind[v] = borderEdges[v] == 2 && kind[v] == VertexKind::Manifold ? VertexKind::Border : VertexKind::Locked;
+
+    if (resultLocked) {
+        std::vector<bool> counted(vertexCount, false);
+        *resultLocked = 0;
+        for (uint32_t v : result)
+            if (!counted[v] && kind[remap[v]] == VertexKind::Locked) {
+                counted[v] = true;
+                ++*resultLocked;
+            }
+    }
+
+    // Moving `from` to `to` is allowed if `from` is free, or on a border or
+    // seam and the edge runs along it.
+    auto canCollapse = [&](uint32_t from, uint32_t to) {
+        switch (kind[from]) {
+        case VertexKind::Manifold:
+            return true;
+        case VertexKind::Border:
+            return kind[to] != VertexKind::Manifold && (isBorder(from, to) || isBorder(to, from));
+        case VertexKind::Seam:
+            return kind[to] != VertexKind::Manifold && isSeam(from, to);
+        default:
+            return false;
+        }
+    };
+
+    struct Collapse {
+        uint32_t from;      // position vertex that goes away
+        uint32_t target;    // a vertex at the position `from` moves to
+        double cost;
+    };
+    std::vector<Collapse> best(vertexCount), candidates;
+    std::vector<uint64_t> keys, keyScratch;
+    std::vector<uint32_t> order, orderScratch;
+    std::vector<uint32_t> positionIndices;
+    std::vector<uint32_t> collapseTo(vertexCount, UINT32_MAX);    // per vertex, not position
+    std::vector<std::pair<uint32_t, uint32_t>> wedges;
+    std::vector<uint8_t> touched(vertexCount);
+    double limit = double(targetError) * targetError, worst = 0.0;
+
+    // The cost of moving `from` onto `target` is the mean squared distance
+    // from there to the planes both have gathered.
+    auto consider = [&](uint32_t from, uint32_t target) {
+        uint32_t to = remap[target];
+        if (!canCollapse(from, to))
+            return;
+        const detail::Quadric &q = quadrics[from], &r = quadrics[to];
+        glm::dvec3 p = position(to);
+        double cost = (q.sum(p) + r.sum(p)) / std::max(q.weight + r.weight, 1e-30);
+        if (cost < best[from].cost)
+            best[from] = {from, target, cost};
+    };
+
+    while (result.size() > targetIndexCount) {
+        // Only each vertex's cheapest collapse is a candidate.
+        for (Collapse &c : best)
+            c.cost = DBL_MAX;
+        for (size_t t = 0; t < result.size(); t += 3)
+            for (int e = 0; e < 3; ++e) {
+                uint32_t a = result[t + e], b = result[t + (e + 1) % 3];
+                if (remap[a] == remap[b])
+                    continue;
+                consider(remap[a], b);
+                consider(remap[b], a);
+            }
+        candidates.clear();
+        for (const Collapse &c : best)
+            if (c.cost != DBL_MAX)
+                candidates.push_back(c);
+
+        keys.resize(candidates.size());
+        order.resize(candidates.size());
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            keys[i] = radix::orderedBits(float(candidates[i].cost));
+            order[i] = static_cast<uint32_t>(i);
+        }
+        keyScratch.resize(keys.size());
+        orderScratch.resize(order.size());
+        radix::sort(keys.data(), order.data(), keys.size(), keyScratch.data(), orderScratch.data());
+
+        positionIndices.resize(result.size());
+        for (size_t i = 0; i < result.size(); ++i)
+            positionIndices[i] = remap[result[i]];
+        detail::Adjacency adjacency(positionIndices.data(), positionIndices.size(), vertexCount);
+
+        // An interior collapse removes two triangles. Stop a little past the
+        // cost of the collapse that would reach the target, so one pass
+        // doesn't spend its budget on collapses a later pass could beat.
+        size_t goal = std::max<size_t>(1, (result.size() - targetIndexCount) / 6);
+        double passLimit = order.empty() ? 0.0 : candidates[order[std::min(goal, order.size()) - 1]].cost * 1.5;
+
+        std::fill(touched.begin(), touched.end(), 0);
+        size_t collapses = 0;
+        for (uint32_t i : order) {
+            const Collapse &collapse = candidates[i];
+            if (collapses >= goal || collapse.cost > limit || (collapse.cost > passLimit && collapses > 0))
+                break;
+            uint32_t from = collapse.from, to = remap[collapse.target];
+            if (touched[from] || touched[to])
+                continue;
+
+            // Reject collapses that turn a surviving triangle over, flatten
+            // it, or turn it by more than about 75 degrees: turned a little
+            // in each pass, a face could otherwise end up on edge.
+            glm::dvec3 moved = position(to);
+            bool flips = false;
+            for (uint32_t k = adjacency.offsets[from]; k < adjacency.offsets[from + 1] && !flips; ++k) {
+                const uint32_t *tri = &positionIndices[size_t(adjacency.triangles[k]) * 3];
+                if (tri[0] == to || tri[1] == to || tri[2] == to)
+                    continue;
+                glm::dvec3 p[3] = {position(tri[0]), position(tri[1]), position(tri[2])};
+                glm::dvec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                for (int c = 0; c < 3; ++c)
+                    if (tri[c] == from)
+                        p[c] = moved;
+                glm::dvec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+                flips = glm::dot(before, after) <= 0.25 * glm::length(before) * glm::length(after);
+            }
+            if (flips || !detail::matchWedges(result.data(), positionIndices.data(), adjacency, from, to, wedges))
+                continue;
+
+            // Lock the whole neighbourhood: the flip test above assumes the
+            // other corners stay where they are.
+            for (uint32_t k = adjacency.offsets[from]; k < adjacency.offsets[from + 1]; ++k) {
+                const uint32_t *tri = &positionIndices[size_t(adjacency.triangles[k]) * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+            }
+            touched[to] = 1;
+            for (const auto &w : wedges)
+                collapseTo[w.first] = w.second;
+            quadrics[to] += quadrics[from];
+            worst = std::max(worst, collapse.cost);
+            ++collapses;
+        }
+        if (collapses == 0)
+            break;
+
+        size_t kept = 0;
+        for (size_t t = 0; t < result.size(); t += 3) {
+            uint32_t tri[3];
+            for (int c = 0; c < 3; ++c) {
+                uint32_t v = result[t + c];
+                tri[c] = collapseTo[v] != UINT32_MAX ? collapseTo[v] : v;
+            }
+            if (remap[tri[0]] == remap[tri[1]] || remap[tri[1]] == remap[tri[2]] || remap[tri[0]] == remap[tri[2]])
+                continue;
+            std::copy(tri, tri + 3, &result[kept]);
+            kept += 3;
+        }
+        result.resize(kept);
+        for (size_t v = 0; v < vertexCount; ++v)
+            collapseTo[v] = UINT32_MAX;
+    }
+
+    if (resultError)
+        *resultError = float(std::sqrt(worst));
+    std::copy(result.begin(), result.end(), destination);
+    return result.size();
+}
+
+}
+
+#endif
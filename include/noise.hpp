@@ -0,0 +1,366 @@
+#ifndef NOISE_HPP
+#define NOISE_HPP
+
+#include "job_pool.hpp"
+#include "simd.hpp"
+#include "texture.hpp"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Batch gradient noise for procedural textures.
+ *
+ * The generators are glm::perlin and glm::simplex (2D and 3D) rewritten so
+ * each SIMD lane evaluates a different point. glm's versions hash with float
+ * arithmetic (the mod 289 permutation polynomial) instead of table lookups,
+ * so they vectorize without gathers. The operations run in glm's order, so
+ * every path matches glm exactly, provided the compiler doesn't contract
+ * multiply-adds on its own (-ffp-contract=off, which the build sets). With
+ * contraction, points near a cell boundary can land in the neighbouring
+ * simplex, and glm's 3D simplex noise isn't continuous there: fBm values move
+ * by up to 0.25. Only the fBm sum uses fmadd, which is exact when the gain is
+ * a power of two.
+ *
+ * `fill` evaluates fBm over a pixel grid, splitting rows across a JobPool, and
+ * `makeImage` turns that into an Image ready for Texture.
+ */
+namespace noise {
+
+enum class Basis { Perlin, Simplex };
+
+/**
+ * Fractal Brownian motion: octave k samples the basis at frequency
+ * lacunarity^k with weight gain^k. The sum is divided by the total weight,
+ * so the range stays roughly [-1, 1] whatever the octave count. Fewer than
+ * one octave counts as one.
+ */
+struct Fbm {
+    Basis basis = Basis::Perlin;
+    int octaves = 1;
+    float lacunarity = 2.0f;
+    float gain = 0.5f;
+};
+
+/**
+ * Where the pixels of a generated image sit in noise space. Pixel (i, j)
+ * samples origin + (i, j) * step; with `volume` set it samples the 3D noise
+ * at that point and depth z, which animates smoothly as z changes.
+ */
+struct Grid {
+    int width = 256, height = 256;
+    glm::vec2 origin = glm::vec2(0.0f);
+    glm::vec2 step = glm::vec2(1.0f / 32.0f);
+    bool volume = false;
+    float z = 0.0f;
+};
+
+namespace detail {
+
+// One noise evaluation per lane, transcribed from glm/gtc/noise.inl.
+template <class O>
+struct Generator {
+    using F = typename O::Float;
+
+    static F c(float v) { return O::set1(v); }
+
+    static F fract(const F &x) { return O::sub(x, O::floor(x)); }
+
+    static F mod289(const F &x) {
+        return O::sub(x, O::mul(O::floor(O::mul(x, c(1.0f / 289.0f))), c(289.0f)));
+    }
+
+    // glm::mod(x, 289), which divides where mod289 multiplies.
+    static F mod289Div(const F &x) {
+        return O::sub(x, O::mul(c(289.0f), O::floor(O::div(x, c(289.0f)))));
+    }
+
+    static F permute(const F &x) {
+        return mod289(O::mul(O::add(O::mul(x, c(34.0f)), c(1.0f)), x));
+    }
+
+    static F taylorInvSqrt(const F &r) {
+        return O::sub(c(1.79284291400159f), O::mul(c(0.85373472095314f), r));
+    }
+
+    static F fade(const F &t) {
+        F t3 = O::mul(O::mul(t, t), t);
+        return O::mul(t3, O::add(O::mul(t, O::sub(O::mul(t, c(6.0f)), c(15.0f))), c(10.0f)));
+    }
+
+    static F mix(const F &a, const F &b, const F &t) {
+        return O::add(O::mul(a, O::sub(c(1.0f), t)), O::mul(b, t));
+    }
+
+    // Gradient for lattice hash h, dotted with the offset (fx, fy).
+    static F perlinCorner(const F &h, const F &fx, const F &fy) {
+        F gx = O::sub(O::mul(c(2.0f), fract(O::div(h, c(41.0f)))), c(1.0f));
+        F gy = O::sub(O::abs(gx), c(0.5f));
+        gx = O::sub(gx, O::floor(O::add(gx, c(0.5f))));
+        F norm = taylorInvSqrt(O::add(O::mul(gx, gx), O::mul(gy, gy)));
+        return O::add(O::mul(O::mul(gx, norm), fx), O::mul(O::mul(gy, norm), fy));
+    }
+
+    static F perlin(const F &x, const F &y) {
+        F ix0 = O::floor(x), iy0 = O::floor(y);
+        F fx0 = O::sub(x, ix0), fy0 = O::sub(y, iy0);
+        F fx1 = O::sub(fx0, c(1.0f)), fy1 = O::sub(fy0, c(1.0f));
+        F ix1 = mod289Div(O::add(ix0, c(1.0f))), iy1 = mod289Div(O::add(iy0, c(1.0f)));
+        ix0 = mod289Div(ix0);
+        iy0 = mod289Div(iy0);
+
+        F px0 = permute(ix0), px1 = permute(ix1);
+        F n00 = perlinCorner(permute(O::add(px0, iy0)), fx0, fy0);
+        F n10 = perlinCorner(permute(O::add(px1, iy0)), fx1, fy0);
+        F n01 = perlinCorner(permute(O::add(px0, iy1)), fx0, fy1);
+        F n11 = perlinCorner(permute(O::add(px1, iy1)), fx1, fy1);
+
+        F u = fade(fx0), v = fade(fy0);
+        return O::mul(c(2.3f), mix(mix(n00, n10, u), mix(n01, n11, u), v));
+    }
+
+    static F perlinCorner(const F &h, const F &fx, const F &fy, const F &fz) {
+        F gx = O::mul(h, c(1.0f / 7.0f));
+        F gy = O::sub(fract(O::mul(O::floor(gx), c(1.0f / 7.0f))), c(0.5f));
+        gx = fract(gx);
+        F gz = O::sub(O::sub(c(0.5f), O::abs(gx)), O::abs(gy));
+        F sz = O::step(gz, c(0.0f));
+        gx = O::sub(gx, O::mul(sz, O::sub(O::step(c(0.0f), gx), c(0.5f))));
+        gy = O::sub(gy, O::mul(sz, O::sub(O::step(c(0.0f), gy), c(0.5f))));
+        F norm = taylorInvSqrt(O::add(O::add(O::mul(gx, gx), O::mul(gy, gy)), O::mul(gz, gz)));
+        return O::add(O::add(O::mul(O::mul(gx, norm), fx), O::mul(O::mul(gy, norm), fy)),
+                      O::mul(O::mul(gz, norm), fz));
+    }
+
+    static F perlin(const F &x, const F &y, const F &z) {
+        F ix0 = O::floor(x), iy0 = O::floor(y), iz0 = O::floor(z);
+        F ix1 = mod289(O::add(ix0, c(1.0f)));
+        F iy1 = mod289(O::add(iy0, c(1.0f)));
+        F iz1 = mod289(O::add(iz0, c(1.0f)));
+        F fx0 = fract(x), fy0 = fract(y), fz0 = fract(z);
+        F fx1 = O::sub(fx0, c(1.0f)), fy1 = O::sub(fy0, c(1.0f)), fz1 = O::sub(fz0, c(1.0f));
+        ix0 = mod289(ix0);
+        iy0 = mod289(iy0);
+        iz0 = mod289(iz0);
+
+        F px0 = permute(ix0), px1 = permute(ix1);
+        F h00 = permute(O::add(px0, iy0)), h10 = permute(O::add(px1, iy0));
+        F h01 = permute(O::add(px0, iy1)), h11 = permute(O::add(px1, iy1));
+
+        F n000 = perlinCorner(permute(O::add(h00, iz0)), fx0, fy0, fz0);
+        F n100 = perlinCorner(permute(O::add(h10, iz0)), fx1, fy0, fz0);
+        F n010 = perlinCorner(permute(O::add(h01, iz0)), fx0, fy1, fz0);
+        F n110 = perlinCorner(permute(O::add(h11, iz0)), fx1, fy1, fz0);
+        F n001 = perlinCorner(permute(O::add(h00, iz1)), fx0, fy0, fz1);
+        F n101 = perlinCorner(permute(O::add(h10, iz1)), fx1, fy0, fz1);
+        F n011 = perlinCorner(permute(O::add(h01, iz1)), fx0, fy1, fz1);
+        F n111 = perlinCorner(permute(O::add(h11, iz1)), fx1, fy1, fz1);
+
+        F u = fade(fx0), v = fade(fy0), w = fade(fz0);
+        F nz00 = mix(n000, n001, w), nz10 = mix(n100, n101, w);
+        F nz01 = mix(n010, n011, w), nz11 = mix(n110, n111, w);
+        return O::mul(c(2.2f), mix(mix(nz00, nz01, v), mix(nz10, nz11, v), u));
+    }
+
+    // Radial falloff times gradient for one simplex corner at offset (x, y).
+    static F simplexCorner(const F &p, const F &x, const F &y) {
+        F m = O::max(O::sub(c(0.5f), O::add(O::mul(x, x), O::mul(y, y))), c(0.0f));
+        m = O::mul(m, m);
+        m = O::mul(m, m);
+        F gx = O::sub(O::mul(c(2.0f), fract(O::mul(p, c(0.024390243902439f)))), c(1.0f));
+        F h = O::sub(O::abs(gx), c(0.5f));
+        F a0 = O::sub(gx, O::floor(O::add(gx, c(0.5f))));
+        m = O::mul(m, O::sub(c(1.79284291400159f), O::mul(c(0.85373472095314f), O::add(O::mul(a0, a0), O::mul(h, h)))));
+        return O::mul(m, O::add(O::mul(a0, x), O::mul(h, y)));
+    }
+
+    static F simplex(const F &x, const F &y) {
+        const float cx = 0.211324865405187f, cy = 0.366025403784439f, cz = -0.577350269189626f;
+
+        F s = O::add(O::mul(x, c(cy)), O::mul(y, c(cy)));
+        F ix = O::floor(O::add(x, s)), iy = O::floor(O::add(y, s));
+        F t = O::add(O::mul(ix, c(cx)), O::mul(iy, c(cx)));
+        F x0 = O::add(O::sub(x, ix), t), y0 = O::add(O::sub(y, iy), t);
+
+        // (1, 0) for the lower triangle, (0, 1) for the upper.
+        F i1y = O::step(x0, y0);
+        F i1x = O::sub(c(1.0f), i1y);
+        F x1 = O::sub(O::add(x0, c(cx)), i1x), y1 = O::sub(O::add(y0, c(cx)), i1y);
+        F x2 = O::add(x0, c(cz)), y2 = O::add(y0, c(cz));
+
+        ix = mod289Div(ix);
+        iy = mod289Div(iy);
+        F p0 = permute(O::add(O::add(permute(iy), ix), c(0.0f)));
+        F p1 = permute(O::add(O::add(permute(O::add(iy, i1y)), ix), i1x));
+        F p2 = permute(O::add(O::add(permute(O::add(iy, c(1.0f))), ix), c(1.0f)));
+
+        F g0 = simplexCorner(p0, x0, y0);
+        F g1 = simplexCorner(p1, x1, y1);
+        F g2 = simplexCorner(p2, x2, y2);
+        return O::mul(c(130.0f), O::add(O::add(g0, g1), g2));
+    }
+
+    static F simplexCorner(const F &p, const F &x, const F &y, const F &z) {
+        const float n = 0.142857142857f;
+        F j = O::sub(p, O::mul(c(49.0f), O::floor(O::mul(O::mul(p, c(n)), c(n)))));
+        F xg = O::floor(O::mul(j, c(n)));
+        F yg = O::floor(O::sub(j, O::mul(c(7.0f), xg)));
+        xg = O::add(O::mul(xg, c(n * 2.0f)), c(n * 0.5f - 1.0f));
+        yg = O::add(O::mul(yg, c(n * 2.0f)), c(n * 0.5f - 1.0f));
+        F h = O::sub(O::sub(c(1.0f), O::abs(xg)), O::abs(yg));
+
+        F sh = O::sub(c(0.0f), O::step(h, c(0.0f)));
+        F gx = O::add(xg, O::mul(O::add(O::mul(O::floor(xg), c(2.0f)), c(1.0f)), sh));
+        F gy = O::add(yg, O::mul(O::add(O::mul(O::floor(yg), c(2.0f)), c(1.0f)), sh));
+        F norm = taylorInvSqrt(O::add(O::add(O::mul(gx, gx), O::mul(gy, gy)), O::mul(h, h)));
+
+        F m = O::max(O::sub(c(0.6f), O::add(O::add(O::mul(x, x), O::mul(y, y)), O::mul(z, z))), c(0.0f));
+        m = O::mul(m, m);
+        F g = O::add(O::add(O::mul(O::mul(gx, norm), x), O::mul(O::mul(gy, norm), y)), O::mul(O::mul(h, norm), z));
+        return O::mul(O::mul(m, m), g);
+    }
+
+    static F simplex(const F &x, const F &y, const F &z) {
+        const float cx = static_cast<float>(1.0 / 6.0), cy = static_cast<float>(1.0 / 3.0);
+
+        F s = O::add(O::add(O::mul(x, c(cy)), O::mul(y, c(cy))), O::mul(z, c(cy)));
+        F ix = O::floor(O::add(x, s)), iy = O::floor(O::add(y, s)), iz = O::floor(O::add(z, s));
+        F t = O::add(O::add(O::mul(ix, c(cx)), O::mul(iy, c(cx))), O::mul(iz, c(cx)));
+        F x0 = O::add(O::sub(x, ix), t), y0 = O::add(O::sub(y, iy), t), z0 = O::add(O::sub(z, iz), t);
+
+        // Which of the six tetrahedra the point is in, as two corner offsets.
+        F gx = O::step(y0, x0), gy = O::step(z0, y0), gz = O::step(x0, z0);
+        F lx = O::sub(c(1.0f), gx), ly = O::sub(c(1.0f), gy), lz = O::sub(c(1.0f), gz);
+        F i1x = O::min(gx, lz), i1y = O::min(gy, lx), i1z = O::min(gz, ly);
+        F i2x = O::max(gx, lz), i2y = O::max(gy, lx), i2z = O::max(gz, ly);
+
+        F x1 = O::add(O::sub(x0, i1x), c(cx)), y1 = O::add(O::sub(y0, i1y), c(cx)), z1 = O::add(O::sub(z0, i1z), c(cx));
+        F x2 = O::add(O::sub(x0, i2x), c(cy)), y2 = O::add(O::sub(y0, i2y), c(cy)), z2 = O::add(O::sub(z0, i2z), c(cy));
+        F x3 = O::sub(x0, c(0.5f)), y3 = O::sub(y0, c(0.5f)), z3 = O::sub(z0, c(0.5f));
+
+        ix = mod289(ix);
+        iy = mod289(iy);
+        iz = mod289(iz);
+        auto hash = [&](const F &ox, const F &oy, const F &oz) {
+            F h = permute(O::add(iz, oz));
+            h = permute(O::add(O::add(h, iy), oy));
+            return permute(O::add(O::add(h, ix), ox));
+        };
+        F zero = c(0.0f), one = c(1.0f);
+        F n0 = simplexCorner(hash(zero, zero, zero), x0, y0, z0);
+        F n1 = simplexCorner(hash(i1x, i1y, i1z), x1, y1, z1);
+        F n2 = simplexCorner(hash(i2x, i2y, i2z), x2, y2, z2);
+        F n3 = simplexCorner(hash(one, one, one), x3, y3, z3);
+        return O::mul(c(42.0f), O::add(O::add(n0, n1), O::add(n2, n3)));
+    }
+
+    static F sample(noise::Basis basis, const F &x, const F &y) {
+        return basis == noise::Basis::Perlin ? perlin(x, y) : simplex(x, y);
+    }
+
+    static F sample(noise::Basis basis, const F &x, const F &y, const F &z) {
+        return basis == noise::Basis::Perlin ? perlin(x, y, z) : simplex(x, y, z);
+    }
+};
+
+// out[i] = fBm at (x[i], y[i]), or (x[i], y[i], z[i]) when z isn't null.
+template <class Ops>
+struct FbmKernel {
+    static void run(size_t count, const float *x, const float *y, const float *z, float *out, Fbm fbm) {
+        // No octaves would divide zero by zero.
+        fbm.octaves = std::max(fbm.octaves, 1);
+        float totalWeight = 0.0f, weight = 1.0f;
+        for (int o = 0; o < fbm.octaves; ++o, weight *= fbm.gain)
+            totalWeight += weight;
+        float scale = 1.0f / totalWeight;
+
+        simd::forEachBlock<Ops>(count, [&](auto ops, size_t i) {
+            using O = decltype(ops);
+            using F = typename O::Float;
+            F px = O::load(x + i), py = O::load(y + i);
+            F pz = z ? O::load(z + i) : O::set1(0.0f);
+            F sum = O::set1(0.0f);
+            float frequency = 1.0f, amplitude = 1.0f;
+            for (int o = 0; o < fbm.octaves; ++o) {
+                F f = O::set1(frequency);
+                F n = z ? Generator<O>::sample(fbm.basis, O::mul(px, f), O::mul(py, f), O::mul(pz, f))
+                        : Generator<O>::sample(fbm.basis, O::mul(px, f), O::mul(py, f));
+                sum = O::fmadd(n, O::set1(amplitude), sum);
+                frequency *= fbm.lacunarity;
+                amplitude *= fbm.gain;
+            }
+            O::store(out + i, O::mul(sum, O::set1(scale)));
+        });
+    }
+};
+
+}
+
+/**
+ * @brief out[i] = fBm at (x[i], y[i]), or at (x[i], y[i], z[i]) if z isn't
+ *        null. A single octave is plain glm::perlin/simplex.
+ */
+inline void sample(const Fbm &fbm, const float *x, const float *y, const float *z, float *out, size_t count) {
+    simd::dispatch<detail::FbmKernel>(count, x, y, z, out, fbm);
+}
+
+/**
+ * @brief Fills out (width * height floats, row by row) with fBm over the grid.
+ *
+ * @param pool Bands of rows are spread over it; nullptr runs everything on
+ * the calling thread.
+ */
+inline void fill(const Grid &grid, const Fbm &fbm, float *out, JobPool *pool = &defaultJobPool()) {
+    size_t width = static_cast<size_t>(grid.width);
+    std::vector<float> xs(width);
+    for (size_t i = 0; i < width; ++i)
+        xs[i] = grid.origin.x + static_cast<float>(i) * grid.step.x;
+
+    auto rows = [&](size_t begin, size_t end) {
+        std::vector<float> ys(width), zs(grid.volume ? width : 0, grid.z);
+        for (size_t row = begin; row < end; ++row) {
+            std::fill(ys.begin(), ys.end(), grid.origin.y + static_cast<float>(row) * grid.step.y);
+            sample(fbm, xs.data(), ys.data(), grid.volume ? zs.data() : nullptr, out + row * width, width);
+        }
+    };
+
+    size_t height = static_cast<size_t>(grid.height);
+    if (pool) {
+        size_t grain = std::max<size_t>(1, height / (pool->threadCount() * 4));
+        pool->parallelFor(0, height, grain, rows);
+    } else {
+        rows(0, height);
+    }
+}
+
+/**
+ * @brief Generates a one-channel Image of fBm over the grid.
+ *
+ * UInt8 maps [-1, 1] to [0, 255], clamping anything outside. Half keeps the
+ * raw values for shaders that want the sign. Texture swizzles one-channel
+ * images to grey.
+ */
+inline Image makeImage(const Grid &grid, const Fbm &fbm, Image::PixelType type = Image::PixelType::UInt8,
+                       JobPool *pool = &defaultJobPool()) {
+    Image image(grid.width, grid.height, 1, type == Image::PixelType::Half ? type : Image::PixelType::UInt8);
+    if (!image)
+        return image;
+
+    size_t count = image.sampleCount();
+    std::vector<float> values(count);
+    fill(grid, fbm, values.data(), pool);
+
+    if (image.type == Image::PixelType::Half) {
+        floatToHalf(values.data(), static_cast<uint16_t *>(image.pixels), count);
+    } else {
+        unsigned char *p = static_cast<unsigned char *>(image.pixels);
+        for (size_t i = 0; i < count; ++i)
+            p[i] = static_cast<unsigned char>(std::clamp(values[i] * 127.5f + 128.0f, 0.0f, 255.0f));
+    }
+    return image;
+}
+
+}
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef OBJ_IMPORT_HPP
+#define OBJ_IMPORT_HPP
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * A Wavefront OBJ reader, for the offline mesh cook (tools/obj2mesh.cpp)
+ * rather than for loading at runtime.
+ *
+ * Reads v, vt, vn and f lines and ignores everything else (groups,
+ * materials, smoothing groups). Polygons are fanned into triangles, negative
+ * (relative) indices are supported, and each distinct v/vt/vn combination
+ * becomes one vertex. Meshes without normals get smooth, area-weighted ones.
+ */
+namespace obj {
+
+/// Interleaved position, normal and texture coords: 8 floats a vertex.
+struct Mesh {
+    static constexpr int floatsPerVertex = 8;
+
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+
+    size_t vertexCount() const { return vertices.size() / floatsPerVertex; }
+    bool empty() const { return indices.empty(); }
+};
+
+namespace detail {
+
+struct Corner {
+    int position, texcoord, normal;    // 0-based, -1 when absent
+
+    bool operator==(const Corner &other) const {
+        return position == other.position && texcoord == other.texcoord && normal == other.normal;
+    }
+};
+
+struct CornerHash {
+    size_t operator()(const Corner &c) const {
+        uint64_t h = uint64_t(uint32_t(c.position)) * 0x9E3779B97F4A7C15ull;
+        h ^= uint64_t(uint32_t(c.texcoord)) * 0xC2B2AE3D27D4EB4Full + (h >> 29);
+        h ^= uint64_t(uint32_t(c.normal)) * 0x165667B19E3779F9ull + (h >> 32);
+        return static_cast<size_t>(h);
+    }
+};
+
+// OBJ indices are 1-based, or negative to count back from the latest.
+inline int resolve(long index, size_t count) {
+    if (index > 0)
+        return static_cast<int>(index - 1);
+    if (index < 0)
+        return static_cast<int>(static_cast<long>(count) + index);
+    return -1;
+}
+
+inline const char *skipSpaces(const char *p) {
+    while (*p == ' ' || *p == '\t')
+        ++p;
+    return p;
+}
+
+}
+
+/**
+ * @brief Parses OBJ text. Returns an empty mesh if there are no faces.
+ */
+inline Mesh parse(const std::string &text) {
+    std::vector<glm::vec3> positions, normals;
+    std::vector<glm::vec2> texcoords;
+    std::unordered_map<detail::Corner, uint32_t, detail::CornerHash> corners;
+    std::vector<detail::Corner> cornerList;
+    Mesh mesh;
+
+    std::vector<uint32_t> polygon;
+    const char *p = text.c_str();
+    while (*p) {
+        p = detail::skipSpaces(p);
+        char *end = nullptr;
+        if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+            glm::vec3 v;
+            v.x = std::strtof(p + 2, &end);
+            v.y = std::strtof(end, &end);
+            v.z = std::strtof(end, &end);
+            positions.push_back(v);
+            p = end;
+        } else if (p[0] == 'v' && p[1] == 't') {
+            glm::vec2 t;
+            t.x = std::strtof(p + 2, &end);
+            t.y = std::strtof(end, &end);
+            texcoords.push_back(t);
+            p = end;
+        } else if (p[0] == 'v' && p[1] == 'n') {
+            glm::vec3 n;
+            n.x = std::strtof(p + 2, &end);
+            n.y = std::strtof(end, &end);
+            n.z = std::strtof(end, &end);
+            normals.push_back(n);
+            p = end;
+        } else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+            polygon.clear();
+            p += 2;
+            for (;;) {
+                p = detail::skipSpaces(p);
+                long v = std::strtol(p, &end, 10);
+                if (end == p)
+                    break;
+                detail::Corner c{detail::resolve(v, positions.size()), -1, -1};
+                p = end;
+                if (*p == '/') {
+                    ++p;
+                    if (*p != '/') {
+                        c.texcoord = detail::resolve(std::strtol(p, &end, 10), texcoords.size());
+                        p = end;
+                    }
+                    if (*p == '/') {
+                        ++p;
+                        c.normal = detail::resolve(std::strtol(p, &end, 10), normals.size());
+                        p = end;
+                    }
+                }
+                if (c.position < 0 || c.position >= int(positions.size())
+                    || c.texcoord >= int(texcoords.size()) || c.normal >= int(normals.size()))
+                    continue;
+
+                auto inserted = corners.emplace(c, static_cast<uint32_t>(cornerList.size()));
+                if (inserted.second)
+                    cornerList.push_back(c);
+                polygon.push_back(inserted.first->second);
+            }
+            for (size_t i = 2; i < polygon.size(); ++i)
+                mesh.indices.insert(mesh.indices.end(), {polygon[0], polygon[i - 1], polygon[i]});
+        }
+        while (*p && *p != '\n')
+            ++p;
+        if (*p)
+            ++p;
+    }
+
+    bool needNormals = false;
+    mesh.vertices.resize(cornerList.size() * Mesh::floatsPerVertex);
+    for (size_t i = 0; i < cornerList.size(); ++i) {
+        const detail::Corner &c = cornerList[i];
+        float *v = &mesh.vertices[i * Mesh::floatsPerVertex];
+        glm::vec3 position = positions[c.position];
+        glm::vec3 normal = c.normal >= 0 ? normals[c.normal] : glm::vec3(0.0f);
+        glm::vec2 uv = c.texcoord >= 0 ? texcoords[c.texcoord] : glm::vec2(0.0f);
+        needNormals |= c.normal < 0;
+        float values[] = {position.x, position.y, position.z, normal.x, normal.y, normal.z, uv.x, uv.y};
+        std::copy(values, values + Mesh::floatsPerVertex, v);
+    }
+
+    // Sum face normals (length is twice the area) over corners sharing a
+    // position, then normalize.
+    if (needNormals) {
+        std::vector<glm::vec3> sums(positions.size(), glm::vec3(0.0f));
+        for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+            int a = cornerList[mesh.indices[t]].position, b = cornerList[mesh.indices[t + 1]].position,
+                c = cornerList[mesh.indices[t + 2]].position;
+            glm::vec3 n = glm::cross(positions[b] - positions[a], positions[c] - positions[a]);
+            sums[a] += n;
+            sums[b] += n;
+            sums[c] += n;
+        }
+        for (size_t i = 0; i < cornerList.size(); ++i) {
+            if (cornerList[i].normal >= 0)
+                continue;
+            glm::vec3 n = sums[cornerList[i].position];
+            float length = glm::length(n);
+            n = length > 0.0f ? n / length : glm::vec3(0.0f, 0.0f, 1.0f);
+            float *v = &mesh.vertices[i * Mesh::floatsPerVertex];
+            v[3] = n.x;
+            v[4] = n.y;
+            v[5] = n.z;
+        }
+    }
+    return mesh;
+}
+
+/**
+ * @brief Reads and parses an OBJ file. Returns an empty mesh on failure.
+ */
+inline Mesh load(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cout << "Failed to open OBJ file: " << path << std::endl;
+        return {};
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    Mesh mesh = parse(text.str());
+    if (mesh.empty())
+        std::cout << "No faces in OBJ file: " << path << std::endl;
+    return mesh;
+}
+
+}
+
+#endif
@@ -0,0 +1,567 @@
+#ifndef PNG_DECODE_HPP
+#define PNG_DECODE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/**
+ * A PNG decoder that hands out one scanline at a time and can stop between
+ * any two, for spreading a big decode over several frames (TextureStream).
+ *
+ * Only a 32 KB inflate window plus a couple of rows are kept, never the whole
+ * decompressed image. Covers 8-bit grey, RGB, palette, grey+alpha and RGBA,
+ * 16-bit except palette, and tRNS transparency. Interlaced and 1/2/4-bit
+ * images report !supported() and are left to stb_image.
+ */
+namespace png {
+
+namespace detail {
+
+// LSB-first bit reader over the IDAT payloads, which needn't be contiguous.
+class BitReader {
+public:
+    struct Span {
+        const unsigned char *data;
+        size_t size;
+    };
+
+    explicit BitReader(std::vector<Span> spans) : spans(std::move(spans)) {
+        if (!this->spans.empty()) {
+            pos = this->spans[0].data;
+            end = pos + this->spans[0].size;
+        }
+    }
+
+    /// Tops the buffer up to at least 57 bits, padding with zeros past the end.
+    void refill() {
+        while (count <= 56) {
+            bits |= uint64_t(nextByte()) << count;
+            count += 8;
+        }
+    }
+
+    uint32_t peek(int n) const { return static_cast<uint32_t>(bits & ((uint64_t(1) << n) - 1)); }
+
+    void consume(int n) {
+        bits >>= n;
+        count -= n;
+    }
+
+    uint32_t take(int n) {
+        if (count < n)
+            refill();
+        uint32_t value = peek(n);
+        consume(n);
+        return value;
+    }
+
+    void alignToByte() { consume(count % 8); }
+
+    /// True once bits from beyond the end of the data have been consumed.
+    bool overrun() const { return padding * 8 > size_t(count); }
+
+private:
+    std::vector<Span> spans;
+    size_t span = 0;
+    const unsigned char *pos = nullptr, *end = nullptr;
+    uint64_t bits = 0;
+    int count = 0;
+    size_t padding = 0;
+
+    unsigned char nextByte() {
+        while (pos == end) {
+            if (span + 1 >= spans.size()) {
+                ++padding;
+                return 0;
+            }
+            ++span;
+            pos = spans[span].data;
+            end = pos + spans[span].size;
+        }
+        return *pos++;
+    }
+};
+
+inline uint32_t reverseBits(uint32_t v, int n) {
+    uint32_t r = 0;
+    for (int i = 0; i < n; ++i, v >>= 1)
+        r = (r << 1) | (v & 1);
+    return r;
+}
+
+// Canonical Huffman code: a 9-bit lookup table for short codes, and
+// per-length ranges for the rest.
+class Huffman {
+public:
+    static constexpr int fastBits = 9;
+
+    bool build(const uint8_t *lengths, int count) {
+        int counts[16] = {}, nextCode[16];
+        std::fill(std::begin(fast), std::end(fast), 0);
+        for (int i = 0; i < count; ++i)
+            ++counts[lengths[i]];
+        counts[0] = 0;
+
+        int code = 0, index = 0;
+        for (int len = 1; len < 16; ++len) {
+            nextCode[len] = code;
+            firstCode[len] = code;
+            firstIndex[len] = index;
+            code += counts[len];
+            if (counts[len] && code - 1 >= (1 << len))
+                return false;    // over-subscribed
+            maxCode[len] = static_cast<uint32_t>(code) << (16 - len);
+            code <<= 1;
+            index += counts[len];
+        }
+        maxCode[16] = 0x10000;
+
+        for (int symbol = 0; symbol < count; ++symbol) {
+            int len = lengths[symbol];
+            if (!len)
+                continue;
+            int c = nextCode[len]++;
+            symbols[firstIndex[len] + c - firstCode[len]] = static_cast<uint16_t>(symbol);
+            if (len <= fastBits)
+                for (uint32_t j = reverseBits(c, len); j < (1u << fastBits); j += 1u << len)
+                    fast[j] = static_cast<uint16_t>(len << 9 | symbol);
+        }
+        return true;
+    }
+
+    /// The next symbol, or -1 for a code that isn't in the table.
+    int decode(BitReader &in) const {
+        if (uint16_t entry = fast[in.peek(fastBits)]) {
+            in.consume(entry >> 9);
+            return entry & 511;
+        }
+        uint32_t k = reverseBits(in.peek(16), 16);
+        int len = fastBits + 1;
+        while (k >= maxCode[len])
+            ++len;
+        if (len == 16)
+            return -1;
+        in.consume(len);
+        return symbols[firstIndex[len] + (k >> (16 - len)) - firstCode[len]];
+    }
+
+private:
+    uint16_t fast[1 << fastBits];    // length << 9 | symbol, 0 if longer
+    int firstCode[16], firstIndex[16];
+    uint32_t maxCode[17];            // first code past each length, left-aligned to 16 bits
+    uint16_t symbols[288];
+};
+
+/**
+ * Resumable inflate (RFC 1951). Output goes into a ring big enough for the
+ * 32 KB window plus what the caller asks for at once, and is taken out with
+ * read(). The decoder only stops between symbols, so all its state is in
+ * members.
+ */
+class Inflater {
+public:
+    Inflater(std::vector<BitReader::Span> spans, size_t largestRead) : in(std::move(spans)) {
+        size_t size = 1;
+        while (size < 32768 + largestRead + 258)
+            size <<= 1;
+        ring.resize(size);
+        mask = size - 1;
+    }
+
+    /// Decodes until `bytes` are waiting to be read. False on corrupt data or
+    /// if the stream ends first.
+    bool fill(size_t bytes) {
+        while (produced - consumed < bytes) {
+            bool ok = state == State::Codes ? symbol() : step();
+            if (!ok)
+                return false;
+        }
+        return !in.overrun() || fail();
+    }
+
+    void read(unsigned char *dst, size_t bytes) {
+        size_t start = consumed & mask, first = std::min(bytes, ring.size() - start);
+        std::memcpy(dst, &ring[start], first);
+        std::memcpy(dst + first, ring.data(), bytes - first);
+        consumed += bytes;
+    }
+
+private:
+    enum class State { Header, Stored, Codes, Done, Error };
+
+    BitReader in;
+    std::vector<unsigned char> ring;
+    size_t mask = 0;
+    uint64_t produced = 0, consumed = 0;
+    State state = State::Header;
+    bool finalBlock = false;
+    uint32_t storedLeft = 0;
+    Huffman literals, distances;
+
+    bool fail() {
+        state = State::Error;
+        return false;
+    }
+
+    void put(unsigned char byte) { ring[produced++ & mask] = byte; }
+
+    // One block header, one stored byte, or one literal/length symbol.
+    bool step() {
+        switch (state) {
+        case State::Header:
+            return header();
+        case State::Stored:
+            put(static_cast<unsigned char>(in.take(8)));
+            if (--storedLeft == 0)
+                state = finalBlock ? State::Done : State::Header;
+            return true;
+        case State::Codes:
+            return symbol();
+        case State::Done:
+        case State::Error:
+            return false;
+        }
+        return false;
+    }
+
+    bool header() {
+        in.refill();
+        finalBlock = in.take(1);
+        switch (in.take(2)) {
+        case 0: {
+            in.alignToByte();
+            uint32_t length = in.take(16), check = in.take(16);
+            if ((length ^ 0xFFFF) != check)
+                return fail();
+            storedLeft = length;
+            state = length ? State::Stored : finalBlock ? State::Done : State::Header;
+            return true;
+        }
+        case 1: {
+            uint8_t lengths[288 + 32];
+            std::fill(lengths, lengths + 144, 8);
+            std::fill(lengths + 144, lengths + 256, 9);
+            std::fill(lengths + 256, lengths + 280, 7);
+            std::fill(lengths + 280, lengths + 288, 8);
+            std::fill(lengths + 288, lengths + 320, 5);
+            literals.build(lengths, 288);
+            distances.build(lengths + 288, 32);
+            state = State::Codes;
+            return true;
+        }
+        case 2:
+            if (!dynamicTables())
+                return fail();
+            state = State::Codes;
+            return true;
+        default:
+            return fail();
+        }
+    }
+
+    bool dynamicTables() {
+        static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+        int literalCount = in.take(5) + 257, distanceCount = in.take(5) + 1, codeCount = in.take(4) + 4;
+        // HLIT and HDIST can encode up to 288 and 32, but only 286 and 30
+        // codes exist; like zlib, reject the rest before they index lengths.
+        if (literalCount > 286 || distanceCount > 30)
+            return false;
+        uint8_t codeLengths[19] = {};
+        for (int i = 0; i < codeCount; ++i)
+            codeLengths[order[i]] = static_cast<uint8_t>(in.take(3));
+        Huffman codes;
+        if (!codes.build(codeLengths, 19))
+            return false;
+
+        uint8_t lengths[286 + 30] = {};
+        int total = literalCount + distanceCount;
+        for (int n = 0; n < total;) {
+            in.refill();
+            int symbol = codes.decode(in);
+            if (symbol < 0)
+                return false;
+            if (symbol < 16) {
+                lengths[n++] = static_cast<uint8_t>(symbol);
+                continue;
+            }
+            int repeat;
+            uint8_t value = 0;
+            if (symbol == 16) {
+                if (n == 0)
+                    return false;
+                value = lengths[n - 1];
+                repeat = 3 + in.take(2);
+            } else if (symbol == 17) {
+                repeat = 3 + in.take(3);
+            } else {
+                repeat = 11 + in.take(7);
+            }
+            if (n + repeat > total)
+                return false;
+            std::fill(lengths + n, lengths + n + repeat, value);
+            n += repeat;
+        }
+        return literals.build(lengths, literalCount) && distances.build(lengths + literalCount, distanceCount);
+    }
+
+    bool symbol() {
+        static const uint16_t lengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                                31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const uint8_t lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                                2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static const uint16_t distanceBase[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,
+                                                  33,  49,  65,  97,  129, 193,  257,  385,  513,  769,
+                                                  1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        static const uint8_t distanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                                  6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+        in.refill();
+        int s = literals.decode(in);
+        if (s < 0)
+            return fail();
+        if (s < 256) {
+            put(static_cast<unsigned char>(s));
+            return true;
+        }
+        if (s == 256) {
+            state = finalBlock ? State::Done : State::Header;
+            return true;
+        }
+        s -= 257;
+        if (s >= 29)
+            return fail();
+        uint32_t length = lengthBase[s] + in.take(lengthExtra[s]);
+        int d = distances.decode(in);
+        if (d < 0 || d >= 30)
+            return fail();
+        uint32_t distance = distanceBase[d] + in.take(distanceExtra[d]);
+        if (distance > produced || distance > 32768)
+            return fail();
+        for (uint32_t i = 0; i < length; ++i, ++produced)
+            ring[produced & mask] = ring[(produced - distance) & mask];
+        return true;
+    }
+};
+
+inline uint32_t readBigEndian32(const unsigned char *p) {
+    return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+}
+
+}
+
+/**
+ * @brief Reads a PNG from memory row by row.
+ *
+ *     png::Decoder png(bytes, size);
+ *     if (png.supported())
+ *         while (png.rowsDecoded() < png.height())
+ *             use(png.nextRow());
+ *
+ * Rows come out top to bottom with palettes and tRNS already applied: 1 to 4
+ * channels of 8-bit or native-endian 16-bit samples. The file must outlive
+ * the decoder.
+ */
+class Decoder {
+public:
+    Decoder(const unsigned char *data, size_t size) {
+        static const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+        if (size < 8 || std::memcmp(data, signature, 8) != 0)
+            return;
+        isPng = true;
+
+        std::vector<detail::BitReader::Span> idat;
+        int interlace = 0;
+        bool hasTransparency = false;
+        for (size_t offset = 8; offset + 12 <= size;) {
+            uint32_t length = detail::readBigEndian32(data + offset);
+            const unsigned char *type = data + offset + 4, *body = data + offset + 8;
+            if (length > size - offset - 12)
+                return;
+            offset += 12 + size_t(length);
+
+            if (std::memcmp(type, "IHDR", 4) == 0) {
+                if (length != 13)
+                    return;
+                w = static_cast<int>(detail::readBigEndian32(body));
+                h = static_cast<int>(detail::readBigEndian32(body + 4));
+                depth = body[8];
+                colorType = body[9];
+                interlace = body[12];
+                if (w <= 0 || h <= 0 || w > (1 << 24) || h > (1 << 24) || body[10] != 0 || body[11] != 0)
+                    return;
+            } else if (std::memcmp(type, "PLTE", 4) == 0) {
+                if (length % 3 != 0 || length > 768)
+                    return;
+                palette.assign(length / 3 * 4, 255);
+                for (uint32_t i = 0; i < length / 3; ++i)
+                    std::memcpy(&palette[i * 4], body + i * 3, 3);
+            } else if (std::memcmp(type, "tRNS", 4) == 0) {
+                hasTransparency = true;
+                if (colorType == 3) {
+                    if (length > palette.size() / 4)
+                        return;
+                    for (uint32_t i = 0; i < length; ++i)
+                        palette[i * 4 + 3] = body[i];
+                } else {
+                    for (uint32_t i = 0; i + 1 < length && i / 2 < 3; i += 2)
+                        key[i / 2] = static_cast<uint16_t>(body[i] << 8 | body[i + 1]);
+                }
+            } else if (std::memcmp(type, "IDAT", 4) == 0) {
+                idat.push_back({body, length});
+            } else if (std::memcmp(type, "IEND", 4) == 0) {
+                break;
+            } else if (!(type[0] & 32)) {
+                return;    // an unknown critical chunk, e.g. Apple's CgBI
+            }
+        }
+
+        static const int sourceChannels[7] = {1, 0, 3, 1, 2, 0, 4};
+        bool knownType = colorType <= 6 && sourceChannels[colorType] != 0;
+        if (!knownType || interlace != 0 || idat.empty() || (depth != 8 && depth != 16)
+            || (colorType == 3 && (depth != 8 || palette.empty())))
+            return;
+        fileChannels = sourceChannels[colorType];
+        keyed = hasTransparency && (colorType == 0 || colorType == 2);
+        outChannels = colorType == 3 ? (hasTransparency ? 4 : 3) : fileChannels + (keyed ? 1 : 0);
+
+        // The zlib header: deflate, no preset dictionary.
+        if (idat[0].size < 2 || (idat[0].data[0] & 15) != 8 || (idat[0].data[1] & 32)
+            || (idat[0].data[0] << 8 | idat[0].data[1]) % 31 != 0)
+            return;
+        idat[0].data += 2;
+        idat[0].size -= 2;
+
+        filteredBytes = size_t(w) * fileChannels * (depth / 8);
+        inflater = std::make_unique<detail::Inflater>(std::move(idat), filteredBytes + 1);
+        previous.assign(filteredBytes, 0);
+        current.assign(filteredBytes, 0);
+        row.resize(size_t(w) * outChannels * bytesPerSample());
+        ok = true;
+    }
+
+    /// False if this isn't a PNG at all.
+    bool isPngFile() const { return isPng; }
+    /// False for PNGs this decoder doesn't handle, or broken ones.
+    bool supported() const { return ok; }
+
+    int width() const { return w; }
+    int height() const { return h; }
+    int channels() const { return outChannels; }
+    int bytesPerSample() const { return depth / 8; }
+    int rowsDecoded() const { return rows; }
+
+    /**
+     * @brief Decodes the next row. Returns nullptr past the last row or on
+     *        corrupt data, after which supported() is false.
+     */
+    const void *nextRow() {
+        if (!ok || rows >= h)
+            return nullptr;
+        unsigned char filter;
+        if (!inflater->fill(filteredBytes + 1)) {
+            ok = false;
+            return nullptr;
+        }
+        inflater->read(&filter, 1);
+        inflater->read(current.data(), filteredBytes);
+        if (!unfilter(filter)) {
+            ok = false;
+            return nullptr;
+        }
+        expand();
+        std::swap(previous, current);
+        ++rows;
+        return row.data();
+    }
+
+private:
+    bool isPng = false, ok = false;
+    int w = 0, h = 0, depth = 0, colorType = 0;
+    int fileChannels = 0, outChannels = 0;
+    bool keyed = false;
+    uint16_t key[3] = {};
+    std::vector<unsigned char> palette;    // RGBA
+    size_t filteredBytes = 0;
+    std::unique_ptr<detail::Inflater> inflater;
+    std::vector<unsigned char> previous, current, row;
+    int rows = 0;
+
+    bool unfilter(unsigned char filter) {
+        size_t bpp = size_t(fileChannels) * (depth / 8);
+        unsigned char *c = current.data();
+        const unsigned char *p = previous.data();
+        switch (filter) {
+        case 0:
+            break;
+        case 1:
+            for (size_t i = bpp; i < filteredBytes; ++i)
+                c[i] = static_cast<unsigned char>(c[i] + c[i - bpp]);
+            break;
+        case 2:
+            for (size_t i = 0; i < filteredBytes; ++i)
+                c[i] = static_cast<unsigned char>(c[i] + p[i]);
+            break;
+        case 3:
+            for (size_t i = 0; i < filteredBytes; ++i)
+                c[i] = static_cast<unsigned char>(c[i] + ((i >= bpp ? c[i - bpp] : 0) + p[i]) / 2);
+            break;
+        case 4:
+            for (size_t i = 0; i < filteredBytes; ++i) {
+                int a = i >= bpp ? c[i - bpp] : 0, b = p[i], d = i >= bpp ? p[i - bpp] : 0;
+                int estimate = a + b - d;
+                int pa = std::abs(estimate - a), pb = std::abs(estimate - b), pd = std::abs(estimate - d);
+                int predictor = (pa <= pb && pa <= pd) ? a : pb <= pd ? b : d;
+                c[i] = static_cast<unsigned char>(c[i] + predictor);
+            }
+            break;
+        default:
+            return false;
+        }
+        return true;
+    }
+
+    // Palette lookup, colour-key alpha and byte swapping into `row`.
+    void expand() {
+        const unsigned char *c = current.data();
+        if (colorType == 3) {
+            unsigned char *out = row.data();
+            for (int x = 0; x < w; ++x, out += outChannels) {
+                size_t index = size_t(c[x]) * 4;
+                const unsigned char *entry = index < palette.size() ? &palette[index] : palette.data();
+                std::memcpy(out, entry, outChannels);
+            }
+        } else if (depth == 8) {
+            unsigned char *out = row.data();
+            for (int x = 0; x < w; ++x, c += fileChannels, out += outChannels) {
+                std::memcpy(out, c, fileChannels);
+                if (keyed)
+                    out[fileChannels] = matchesKey(c, 1) ? 0 : 255;
+            }
+        } else {
+            uint16_t *out = reinterpret_cast<uint16_t *>(row.data());
+            for (int x = 0; x < w; ++x, c += fileChannels * 2, out += outChannels) {
+                for (int i = 0; i < fileChannels; ++i)
+                    out[i] = static_cast<uint16_t>(c[i * 2] << 8 | c[i * 2 + 1]);
+                if (keyed)
+                    out[fileChannels] = matchesKey(c, 2) ? 0 : 65535;
+            }
+        }
+    }
+
+    bool matchesKey(const unsigned char *pixel, int bytes) const {
+        for (int i = 0; i < fileChannels; ++i) {
+            uint16_t value = bytes == 1 ? pixel[i] : static_cast<uint16_t>(pixel[i * 2] << 8 | pixel[i * 2 + 1]);
+            if (value != key[i])
+                return false;
+        }
+        return true;
+    }
+};
+
+}
+
+#endif
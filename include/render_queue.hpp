@@ -0,0 +1,141 @@
+#ifndef RENDER_QUEUE_HPP
+#define RENDER_QUEUE_HPP
+
+#include "radix_sort.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Builds the 64-bit sort keys for a RenderQueue.
+ *
+ * Opaque draws sort by state first so binds are shared, then front to back so
+ * early depth testing rejects hidden fragments:
+ *
+ *     63-60 pass | 59-48 program | 47-32 texture set | 31-0 depth, near first
+ *
+ * Translucent draws have to be blended back to front, so depth moves up and
+ * state only breaks ties:
+ *
+ *     63-60 pass | 59-28 depth, far first | 27-16 program | 15-0 texture set
+ *
+ * Program and texture set are small ids the caller hands out (up to 4096 and
+ * 65536), not GL names; the payload carries the GL objects themselves.
+ */
+struct DrawKey {
+    static constexpr unsigned maxPasses = 16;
+    static constexpr unsigned maxPrograms = 4096;
+    static constexpr unsigned maxTextureSets = 65536;
+
+    static uint64_t opaque(unsigned pass, unsigned program, unsigned textureSet, float depth) {
+        return uint64_t(pass & 0xF) << 60 | uint64_t(program & 0xFFF) << 48
+             | uint64_t(textureSet & 0xFFFF) << 32 | radix::orderedBits(depth);
+    }
+
+    static uint64_t translucent(unsigned pass, float depth, unsigned program, unsigned textureSet) {
+        return uint64_t(pass & 0xF) << 60 | uint64_t(~radix::orderedBits(depth)) << 28
+             | uint64_t(program & 0xFFF) << 16 | uint64_t(textureSet & 0xFFFF);
+    }
+
+    static unsigned pass(uint64_t key) { return static_cast<unsigned>(key >> 60); }
+};
+
+/**
+ * @brief Collects draw packets from any number of threads, then sorts them by
+ *        key and hands them back in order.
+ *
+ * Nothing here touches GL. A frame goes:
+ *
+ *     queue.push(DrawKey::opaque(...), packet);   // any thread
+ *     queue.sort();                                // once producers are done
+ *     queue.replay(executor);                      // GL thread
+ *     queue.clear();
+ *
+ * push() claims a slot with one atomic increment. Packets beyond the current
+ * capacity go to a mutex-guarded overflow list and the capacity grows at the
+ * next sort(), so a steady frame never takes the lock.
+ *
+ * @note Payload must be default constructible and cheap to copy; keep it to a
+ * handful of words and point at anything bigger.
+ */
+template <class Payload>
+class RenderQueue {
+public:
+    explicit RenderQueue(size_t capacity = 4096) : packets(capacity) {}
+
+    RenderQueue(const RenderQueue &) = delete;
+    RenderQueue &operator=(const RenderQueue &) = delete;
+
+    /// Safe to call from several threads at once, but not alongside sort().
+    void push(uint64_t key, const Payload &payload) {
+        size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+        if (slot < packets.size()) {
+            packets[slot] = {key, payload};
+            return;
+        }
+        std::lock_guard<std::mutex> lock(overflowMutex);
+        overflow.push_back({key, payload});
+    }
+
+    /// Packets pushed since the last clear(). Not exact while pushes are running.
+    size_t size() const { return std::min(next.load(std::memory_order_relaxed), packets.size()) + overflow.size(); }
+
+    /**
+     * @brief Orders the packets by key; equal keys keep the order they were
+     *        pushed in only when pushed from one thread.
+     */
+    void sort() {
+        size_t count = std::min(next.load(std::memory_order_acquire), packets.size());
+        if (!overflow.empty()) {
+            packets.resize(count);
+            packets.insert(packets.end(), overflow.begin(), overflow.end());
+            count = packets.size();
+            overflow.clear();
+        }
+
+        keys.resize(count);
+        order.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            keys[i] = packets[i].key;
+            order[i] = static_cast<uint32_t>(i);
+        }
+        sorter.sort(keys, order);
+    }
+
+    /// Calls fn(key, payload) for every packet in the order sort() left them.
+    template <class Fn>
+    void replay(Fn &&fn) const {
+        for (uint32_t index : order)
+            fn(packets[index].key, packets[index].payload);
+    }
+
+    /// The packet indices, in push order, arranged by sort(). For inspection.
+    const std::vector<uint32_t> &sortedOrder() const { return order; }
+
+    /// Empties the queue, keeping its memory for the next frame.
+    void clear() {
+        next.store(0, std::memory_order_relaxed);
+        order.clear();
+        keys.clear();
+    }
+
+private:
+    struct Packet {
+        uint64_t key;
+        Payload payload;
+    };
+
+    std::vector<Packet> packets;
+    std::atomic<size_t> next{0};
+    std::mutex overflowMutex;
+    std::vector<Packet> overflow;
+
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> order;
+    radix::Sorter sorter;
+};
+
+#endif
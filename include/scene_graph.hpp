@@ -0,0 +1,192 @@
+#ifndef SCENE_GRAPH_HPP
+#define SCENE_GRAPH_HPP
+
+#include "job_pool.hpp"
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+/**
+ * A local transform as translation, rotation and scale, applied in the order
+ * scale, rotate, translate.
+ */
+struct Transform {
+    glm::vec3 translation = glm::vec3(0.0f);
+    glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+
+    glm::mat4 matrix() const {
+        glm::mat4 m = glm::mat4_cast(rotation);
+        m[0] *= scale.x;
+        m[1] *= scale.y;
+        m[2] *= scale.z;
+        m[3] = glm::vec4(translation, 1.0f);
+        return m;
+    }
+};
+
+/**
+ * @brief A transform hierarchy stored as flat arrays in breadth-first order.
+ *
+ * Every node has a parent index, a local Transform and a world matrix. The
+ * arrays are sorted by depth, so each level is one contiguous range and every
+ * parent comes before its children. `update()` walks the levels top-down and
+ * only recomputes nodes whose own transform or an ancestor's changed since the
+ * last update. Levels big enough to be worth it are split across a JobPool.
+ *
+ * Nodes are referred to by the NodeId that addNode returned. Internally nodes
+ * move when the hierarchy is re-sorted, so don't keep slot indices around.
+ */
+class SceneGraph {
+public:
+    using NodeId = uint32_t;
+    static constexpr NodeId none = ~0u;
+
+    /// Levels with fewer nodes than this are updated on the calling thread.
+    size_t parallelThreshold = 8192;
+
+    /**
+     * @param parent An existing node, or SceneGraph::none for a root.
+     */
+    NodeId addNode(NodeId parent, const Transform &local = {}) {
+        NodeId id = static_cast<NodeId>(slotOf.size());
+        uint32_t parentSlot = parent == none ? none : slotOf[parent];
+
+        slotOf.push_back(static_cast<uint32_t>(idOf.size()));
+        idOf.push_back(id);
+        parents.push_back(parentSlot);
+        depths.push_back(parentSlot == none ? 0 : depths[parentSlot] + 1);
+        locals.push_back(local);
+        worlds.push_back(glm::mat4(1.0f));
+        dirty.push_back(1);
+
+        // Appending keeps depth order as long as nothing shallower follows.
+        if (idOf.size() > 1 && depths.back() < depths[depths.size() - 2])
+            unsorted = true;
+        anyDirty = true;
+        return id;
+    }
+
+    size_t size() const { return idOf.size(); }
+
+    const Transform &local(NodeId id) const { return locals[slotOf[id]]; }
+
+    void setLocal(NodeId id, const Transform &local) {
+        uint32_t slot = slotOf[id];
+        locals[slot] = local;
+        dirty[slot] = 1;
+        anyDirty = true;
+    }
+
+    /// World matrix as of the last update().
+    const glm::mat4 &world(NodeId id) const { return worlds[slotOf[id]]; }
+
+    NodeId parent(NodeId id) const {
+        uint32_t p = parents[slotOf[id]];
+        return p == none ? none : idOf[p];
+    }
+
+    /**
+     * @brief Recomputes world matrices for every node that changed, or sits
+     *        under one that did.
+     *
+     * @param pool Workers for large levels; nullptr keeps everything on the
+     * calling thread.
+     */
+    void update(JobPool *pool = &defaultJobPool()) {
+        if (!anyDirty)
+            return;
+        if (unsorted)
+            sortByDepth();
+        if (levelStarts.empty() || levelStarts.back() != idOf.size())
+            findLevels();
+
+        for (size_t level = 0; level + 1 < levelStarts.size(); ++level) {
+            size_t begin = levelStarts[level], end = levelStarts[level + 1];
+            if (pool && end - begin >= parallelThreshold) {
+                size_t grain = std::max<size_t>(1024, (end - begin) / (pool->threadCount() * 4));
+                pool->parallelFor(begin, end, grain, [this](size_t b, size_t e) { updateRange(b, e); });
+            } else {
+                updateRange(begin, end);
+            }
+        }
+
+        std::fill(dirty.begin(), dirty.end(), 0);
+        anyDirty = false;
+    }
+
+private:
+    // Indexed by slot (position in breadth-first order).
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> depths;
+    std::vector<Transform> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<uint8_t> dirty;
+    std::vector<NodeId> idOf;
+
+    std::vector<uint32_t> slotOf;       // indexed by NodeId
+    std::vector<size_t> levelStarts;    // slot where each depth begins, plus the end
+
+    bool unsorted = false;
+    bool anyDirty = false;
+
+    // A node's dirty flag becomes "my world changed", so children one level
+    // down see it when their level runs.
+    void updateRange(size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t p = parents[i];
+            if (p != none && dirty[p])
+                dirty[i] = 1;
+            if (!dirty[i])
+                continue;
+            worlds[i] = p == none ? locals[i].matrix() : worlds[p] * locals[i].matrix();
+        }
+    }
+
+    void findLevels() {
+        levelStarts.clear();
+        for (size_t i = 0; i < depths.size(); ++i)
+            if (i == 0 || depths[i] != depths[i - 1])
+                levelStarts.push_back(i);
+        levelStarts.push_back(depths.size());
+    }
+
+    void sortByDepth() {
+        std::vector<uint32_t> order(idOf.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return depths[a] < depths[b];
+        });
+
+        std::vector<uint32_t> newSlot(order.size());
+        for (uint32_t i = 0; i < order.size(); ++i)
+            newSlot[order[i]] = i;
+
+        auto permute = [&](auto &values) {
+            std::remove_reference_t<decltype(values)> sorted(values.size());
+            for (size_t i = 0; i < order.size(); ++i)
+                sorted[i] = values[order[i]];
+            values.swap(sorted);
+        };
+        permute(parents);
+        permute(depths);
+        permute(locals);
+        permute(worlds);
+        permute(dirty);
+        permute(idOf);
+
+        for (uint32_t &p : parents)
+            if (p != none)
+                p = newSlot[p];
+        for (uint32_t i = 0; i < idOf.size(); ++i)
+            slotOf[idOf[i]] = i;
+
+        unsorted = false;
+        levelStarts.clear();
+    }
+};
+
+#endif
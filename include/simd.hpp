@@ -0,0 +1,326 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * SIMD_TARGET(isa) lets one function use instructions beyond what the build
+ * was compiled for. SIMD_DISPATCH(isa) also flattens the function, so the
+ * templated kernel it calls gets compiled for that ISA too. MSVC lets any
+ * function use any intrinsic, so both are empty there.
+ *
+ * GCC warns (-Wpsabi) about kernels passing __m256 and __m512 outside these
+ * functions. The warning is noise, since kernels always run inlined into
+ * SIMD_DISPATCH; the build turns it off rather than this header, so code
+ * including it keeps its own diagnostics.
+ */
+#if defined(SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#define SIMD_DISPATCH(isa) __attribute__((target(isa), flatten))
+#else
+#define SIMD_TARGET(isa)
+#define SIMD_DISPATCH(isa)
+#endif
+
+/**
+ * Thin wrappers over one SIMD register width each, so a batch kernel can be
+ * written once as a template and instantiated for every ISA level.
+ *
+ * Every wrapper has the same static interface: `Float`, `width`, `load`,
+ * `store`, `set1`, `add`, `sub`, `mul`, `div`, `sqrt`, `fmadd` (a * b + c),
+ * `abs`, `floor`, `min`, `max`, `step` (GLSL's: 0 where x < edge, else 1),
+ * `rsqrt` (the hardware estimate: about 12 bits, 14 on AVX-512, exact in
+ * Scalar), `pow2` (2^n for whole n in [-126, 127]), `flipSign` (a, negated
+ * wherever b is negative) and `lessMask` (bit i set where lane i of a < b). Loads and stores are unaligned. `simd::Scalar`
+ * handles loop tails.
+ *
+ * `Avx2` and `Avx512` are always declared on x86. Only call them from a
+ * function marked SIMD_DISPATCH with the matching ISA, and only after
+ * `simd::runtimeLevel()` says the CPU has it.
+ */
+namespace simd {
+
+enum class Level { Scalar, Sse, Avx2, Avx512 };
+
+struct Scalar {
+    using Float = float;
+    static constexpr int width = 1;
+    static constexpr Level level = Level::Scalar;
+
+    static Float load(const float *p) { return *p; }
+    static void store(float *p, Float v) { *p = v; }
+    static Float set1(float v) { return v; }
+    static Float add(Float a, Float b) { return a + b; }
+    static Float sub(Float a, Float b) { return a - b; }
+    static Float mul(Float a, Float b) { return a * b; }
+    static Float div(Float a, Float b) { return a / b; }
+    static Float sqrt(Float a) { return std::sqrt(a); }
+    static Float fmadd(Float a, Float b, Float c) { return a * b + c; }
+    static Float abs(Float a) { return std::fabs(a); }
+    static Float floor(Float a) { return std::floor(a); }
+    static Float min(Float a, Float b) { return b < a ? b : a; }
+    static Float max(Float a, Float b) { return a < b ? b : a; }
+    static Float step(Float edge, Float x) { return x < edge ? 0.0f : 1.0f; }
+    static Float rsqrt(Float a) { return 1.0f / std::sqrt(a); }
+    // Builds the exponent field like the SIMD levels; std::ldexp is a libm call.
+    static Float pow2(Float n) {
+        uint32_t bits = static_cast<uint32_t>(static_cast<int>(n) + 127) << 23;
+        float v;
+        std::memcpy(&v, &bits, sizeof v);
+        return v;
+    }
+    static Float flipSign(Float a, Float b) { return std::signbit(b) ? -a : a; }
+    static unsigned lessMask(Float a, Float b) { return a < b ? 1u : 0u; }
+};
+
+#if defined(SIMD_X86)
+struct Sse {
+    using Float = __m128;
+    static constexpr int width = 4;
+    static constexpr Level level = Level::Sse;
+
+    static Float load(const float *p) { return _mm_loadu_ps(p); }
+    static void store(float *p, Float v) { _mm_storeu_ps(p, v); }
+    static Float set1(float v) { return _mm_set1_ps(v); }
+    static Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+    static Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+    static Float div(Float a, Float b) { return _mm_div_ps(a, b); }
+    static Float sqrt(Float a) { return _mm_sqrt_ps(a); }
+    static Float fmadd(Float a, Float b, Float c) {
+#if defined(__FMA__)
+        return _mm_fmadd_ps(a, b, c);
+#else
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+    }
+    static Float abs(Float a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+    // SSE2 has no floor: truncate, then step down where that rounded up.
+    // Only valid for |a| < 2^31.
+    static Float floor(Float a) {
+#if defined(__SSE4_1__)
+        return _mm_floor_ps(a);
+#else
+        __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+        return _mm_sub_ps(t, _mm_and_ps(_mm_cmplt_ps(a, t), _mm_set1_ps(1.0f)));
+#endif
+    }
+    static Float min(Float a, Float b) { return _mm_min_ps(a, b); }
+    static Float max(Float a, Float b) { return _mm_max_ps(a, b); }
+    static Float step(Float edge, Float x) { return _mm_andnot_ps(_mm_cmplt_ps(x, edge), _mm_set1_ps(1.0f)); }
+    static Float rsqrt(Float a) { return _mm_rsqrt_ps(a); }
+    // Builds the float's exponent field directly.
+    static Float pow2(Float n) {
+        __m128i e = _mm_add_epi32(_mm_cvttps_epi32(n), _mm_set1_epi32(127));
+        return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+    }
+    static Float flipSign(Float a, Float b) { return _mm_xor_ps(a, _mm_and_ps(b, _mm_set1_ps(-0.0f))); }
+    static unsigned lessMask(Float a, Float b) { return static_cast<unsigned>(_mm_movemask_ps(_mm_cmplt_ps(a, b))); }
+};
+
+struct Avx2 {
+    using Float = __m256;
+    static constexpr int width = 8;
+    static constexpr Level level = Level::Avx2;
+
+    SIMD_TARGET("avx2,fma") static Float load(const float *p) { return _mm256_loadu_ps(p); }
+    SIMD_TARGET("avx2,fma") static void store(float *p, Float v) { _mm256_storeu_ps(p, v); }
+    SIMD_TARGET("avx2,fma") static Float set1(float v) { return _mm256_set1_ps(v); }
+    SIMD_TARGET("avx2,fma") static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+    SIMD_TARGET("avx2,fma") static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+    SIMD_TARGET("avx2,fma") static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+    SIMD_TARGET("avx2,fma") static Float div(Float a, Float b) { return _mm256_div_ps(a, b); }
+    SIMD_TARGET("avx2,fma") static Float sqrt(Float a) { return _mm256_sqrt_ps(a); }
+    SIMD_TARGET("avx2,fma") static Float fmadd(Float a, Float b, Float c) { return _mm256_fmadd_ps(a, b, c); }
+    SIMD_TARGET("avx2,fma") static Float abs(Float a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    SIMD_TARGET("avx2,fma") static Float floor(Float a) { return _mm256_floor_ps(a); }
+    SIMD_TARGET("avx2,fma") static Float min(Float a, Float b) { return _mm256_min_ps(a, b); }
+    SIMD_TARGET("avx2,fma") static Float max(Float a, Float b) { return _mm256_max_ps(a, b); }
+    SIMD_TARGET("avx2,fma") static Float step(Float edge, Float x) {
+        return _mm256_andnot_ps(_mm256_cmp_ps(x, edge, _CMP_LT_OQ), _mm256_set1_ps(1.0f));
+    }
+    SIMD_TARGET("avx2,fma") static Float rsqrt(Float a) { return _mm256_rsqrt_ps(a); }
+    SIMD_TARGET("avx2,fma") static Float pow2(Float n) {
+        __m256i e = _mm256_add_epi32(_mm256_cvttps_epi32(n), _mm256_set1_epi32(127));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+    }
+    SIMD_TARGET("avx2,fma") static Float flipSign(Float a, Float b) {
+        return _mm256_xor_ps(a, _mm256_and_ps(b, _mm256_set1_ps(-0.0f)));
+    }
+    SIMD_TARGET("avx2,fma") static unsigned lessMask(Float a, Float b) {
+        return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ)));
+    }
+};
+
+// Several of these use the masked intrinsic with every lane set: GCC 12 warns
+// about the unmasked forms' undefined passthrough operand under -Wall.
+struct Avx512 {
+    using Float = __m512;
+    static constexpr int width = 16;
+    static constexpr Level level = Level::Avx512;
+
+    SIMD_TARGET("avx512f") static Float load(const float *p) { return _mm512_loadu_ps(p); }
+    SIMD_TARGET("avx512f") static void store(float *p, Float v) { _mm512_storeu_ps(p, v); }
+    SIMD_TARGET("avx512f") static Float set1(float v) { return _mm512_set1_ps(v); }
+    SIMD_TARGET("avx512f") static Float add(Float a, Float b) { return _mm512_add_ps(a, b); }
+    SIMD_TARGET("avx512f") static Float sub(Float a, Float b) { return _mm512_sub_ps(a, b); }
+    SIMD_TARGET("avx512f") static Float mul(Float a, Float b) { return _mm512_mul_ps(a, b); }
+    SIMD_TARGET("avx512f") static Float div(Float a, Float b) { return _mm512_div_ps(a, b); }
+    SIMD_TARGET("avx512f") static Float sqrt(Float a) { return _mm512_mask_sqrt_ps(a, 0xFFFF, a); }
+    SIMD_TARGET("avx512f") static Float fmadd(Float a, Float b, Float c) { return _mm512_fmadd_ps(a, b, c); }
+    SIMD_TARGET("avx512f") static Float abs(Float a) { return _mm512_abs_ps(a); }
+    SIMD_TARGET("avx512f") static Float floor(Float a) {
+        return _mm512_mask_roundscale_ps(a, 0xFFFF, a, _MM_FROUND_TO_NEG_INF);
+    }
+    SIMD_TARGET("avx512f") static Float min(Float a, Float b) { return _mm512_mask_min_ps(a, 0xFFFF, a, b); }
+    SIMD_TARGET("avx512f") static Float max(Float a, Float b) { return _mm512_mask_max_ps(a, 0xFFFF, a, b); }
+    SIMD_TARGET("avx512f") static Float step(Float edge, Float x) {
+        return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, edge, _CMP_LT_OQ), _mm512_set1_ps(1.0f), _mm512_setzero_ps());
+    }
+    SIMD_TARGET("avx512f") static Float rsqrt(Float a) { return _mm512_mask_rsqrt14_ps(a, 0xFFFF, a); }
+    SIMD_TARGET("avx512f") static Float pow2(Float n) {
+        __m512i e = _mm512_add_epi32(_mm512_mask_cvttps_epi32(_mm512_setzero_si512(), 0xFFFF, n), _mm512_set1_epi32(127));
+        return _mm512_castsi512_ps(_mm512_mask_slli_epi32(e, 0xFFFF, e, 23));
+    }
+    // AVX-512F has no float xor/and, so do the sign flip in the integer domain.
+    SIMD_TARGET("avx512f") static Float flipSign(Float a, Float b) {
+        __m512i sign = _mm512_and_si512(_mm512_castps_si512(b), _mm512_set1_epi32(static_cast<int>(0x80000000u)));
+        return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), sign));
+    }
+    SIMD_TARGET("avx512f") static unsigned lessMask(Float a, Float b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+};
+#endif
+
+/**
+ * @brief Asks the CPU (and OS) which of the levels above it can run.
+ */
+inline Level detectLevel() {
+#if defined(SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return Level::Avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return Level::Avx2;
+    return Level::Sse;
+#elif defined(SIMD_X86)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave || maxLeaf < 7)
+        return Level::Sse;
+    unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+    bool avx512f = (info[1] & (1 << 16)) != 0;
+    if (avx512f && (xcr0 & 0xe6) == 0xe6)
+        return Level::Avx512;
+    if (avx2 && fma && (xcr0 & 0x6) == 0x6)
+        return Level::Avx2;
+    return Level::Sse;
+#else
+    return Level::Scalar;
+#endif
+}
+
+/**
+ * @brief The level dispatched kernels use. Detected once, on first call.
+ *
+ * Setting SIMD_MAX_LEVEL to 0-3 at build time caps it, which is handy for
+ * checking the lower paths on a fast machine.
+ */
+inline Level runtimeLevel() {
+    static const Level level = [] {
+        Level detected = detectLevel();
+#if defined(SIMD_MAX_LEVEL)
+        if (static_cast<int>(detected) > SIMD_MAX_LEVEL)
+            detected = static_cast<Level>(SIMD_MAX_LEVEL);
+#endif
+        return detected;
+    }();
+    return level;
+}
+
+/**
+ * @brief Calls block(Ops(), i) for each full register starting at i, then
+ *        block(Scalar(), i) for each element of the tail.
+ *
+ * Write the block as a generic lambda so one body serves both.
+ */
+template <class Ops, class Block>
+inline void forEachBlock(size_t count, Block block) {
+    size_t i = 0;
+    for (; i + Ops::width <= count; i += Ops::width)
+        block(Ops(), i);
+    for (; i < count; ++i)
+        block(Scalar(), i);
+}
+
+namespace detail {
+
+#if defined(SIMD_X86)
+template <template <class> class Kernel, class... Args>
+SIMD_DISPATCH("avx512f") void runAvx512(Args... args) {
+    Kernel<Avx512>::run(args...);
+}
+
+template <template <class> class Kernel, class... Args>
+SIMD_DISPATCH("avx2,fma") void runAvx2(Args... args) {
+    Kernel<Avx2>::run(args...);
+}
+#endif
+
+}
+
+/**
+ * @brief Runs Kernel<Ops>::run(args...) with the widest Ops the CPU supports.
+ *
+ * Kernel is a class template over one of the wrappers above. Its run() should
+ * process full registers with Ops and the remainder with Scalar.
+ */
+template <template <class> class Kernel, class... Args>
+inline void dispatch(Args... args) {
+#if defined(SIMD_X86)
+    switch (runtimeLevel()) {
+    case Level::Avx512:
+        detail::runAvx512<Kernel>(args...);
+        return;
+    case Level::Avx2:
+        detail::runAvx2<Kernel>(args...);
+        return;
+    case Level::Scalar:
+        Kernel<Scalar>::run(args...);
+        return;
+    default:
+        Kernel<Sse>::run(args...);
+        return;
+    }
+#else
+    Kernel<Scalar>::run(args...);
+#endif
+}
+
+inline const char *levelName(Level level) {
+    switch (level) {
+    case Level::Avx512: return "AVX-512";
+    case Level::Avx2:   return "AVX2+FMA";
+    case Level::Sse:    return "SSE2";
+    default:            return "scalar";
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,241 @@
+#ifndef SPRITE_BATCH_HPP
+#define SPRITE_BATCH_HPP
+
+#include "radix_sort.hpp"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+/**
+ * An axis-aligned textured quad. Positions are in whatever space the
+ * program's projection expects; shaders/sprite.vert takes a `projection`
+ * uniform.
+ */
+struct Sprite {
+    glm::vec2 position;                        // bottom-left corner
+    glm::vec2 size;
+    glm::vec4 uv = glm::vec4(0, 0, 1, 1);      // u0, v0, u1, v1
+    glm::vec4 color = glm::vec4(1.0f);
+};
+
+/// 20 bytes: position, texture coords, RGBA8 colour.
+struct SpriteVertex {
+    float x, y;
+    float u, v;
+    uint32_t color;
+};
+
+/**
+ * @brief Collects quads over a frame and draws them in as few calls as the
+ *        programs and textures allow.
+ *
+ * `draw()` only records the sprite and a 64-bit sort key:
+ *
+ *     bits 63-56  program     bits 55-32  texture     bits 31-0  depth
+ *
+ * `flush()` sorts by that key, so sprites sharing a program and texture end up
+ * next to each other and go out in one glDrawElementsBaseVertex call, in
+ * increasing depth. Vertices are written straight into a ring of GPU memory
+ * with unsynchronized glMapBufferRange; when the ring is full it's orphaned,
+ * so the CPU never waits for the GPU to finish with earlier draws. All quads
+ * share one static 16-bit index buffer.
+ *
+ * @note Depth only orders sprites that share a program and texture. Blended
+ * sprites that must overlap across textures in a set order need separate
+ * flushes.
+ */
+class SpriteBatch {
+public:
+    /// Quads one draw call can cover with 16-bit indices.
+    static constexpr size_t maxQuadsPerDraw = 16384;
+
+    struct Stats {
+        size_t sprites = 0;
+        size_t drawCalls = 0;
+        size_t stateChanges = 0;    // program or texture binds
+        size_t orphans = 0;
+    };
+
+    unsigned int VAO = 0;
+    unsigned int VBO = 0;
+    unsigned int EBO = 0;
+
+    /**
+     * @param ringQuads Size of the vertex ring, in quads. The default is
+     * 5 MB of vertices.
+     */
+    explicit SpriteBatch(size_t ringQuads = 4 * maxQuadsPerDraw)
+        : ringQuads(std::max(ringQuads, maxQuadsPerDraw)) {
+        glGenVertexArrays(1, &VAO);
+        glBindVertexArray(VAO);
+
+        glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, ringBytes(), nullptr, GL_STREAM_DRAW);
+
+        GLsizei stride = sizeof(SpriteVertex);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(SpriteVertex, x));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void *)offsetof(SpriteVertex, color));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(SpriteVertex, u));
+        glEnableVertexAttribArray(2);
+
+        std::vector<uint16_t> indices(maxQuadsPerDraw * 6);
+        for (size_t q = 0; q < maxQuadsPerDraw; ++q) {
+            uint16_t v = static_cast<uint16_t>(q * 4);
+            uint16_t quad[6] = {v, uint16_t(v + 1), uint16_t(v + 2), uint16_t(v + 2), uint16_t(v + 3), v};
+            std::copy(quad, quad + 6, indices.begin() + q * 6);
+        }
+        glGenBuffers(1, &EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+
+        glBindVertexArray(0);
+    }
+
+    ~SpriteBatch() {
+        glDeleteBuffers(1, &EBO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteVertexArrays(1, &VAO);
+    }
+
+    SpriteBatch(const SpriteBatch &) = delete;
+    SpriteBatch &operator=(const SpriteBatch &) = delete;
+
+    /**
+     * @brief The sort key for a sprite. Only the low 8 bits of the program
+     *        name and low 24 of the texture name take part; sprites whose
+     *        names collide still draw correctly, just with extra binds.
+     */
+    static uint64_t makeKey(GLuint program, GLuint texture, float depth) {
+        return uint64_t(program & 0xFFu) << 56 | uint64_t(texture & 0xFFFFFFu) << 32 | radix::orderedBits(depth);
+    }
+
+    /// Queues a sprite for the next flush().
+    void draw(GLuint program, GLuint texture, const Sprite &sprite, float depth = 0.0f) {
+        keys.push_back(makeKey(program, texture, depth));
+        order.push_back(static_cast<uint32_t>(entries.size()));
+        entries.push_back({sprite, program, texture});
+    }
+
+    size_t pending() const { return entries.size(); }
+
+    /**
+     * @brief Sorts and draws everything queued since the last flush.
+     *
+     * Binds each program and texture (on unit 0) as needed and leaves the
+     * last ones bound; set uniforms such as `projection` beforehand.
+     */
+    Stats flush() {
+        Stats stats;
+        stats.sprites = entries.size();
+        if (entries.empty())
+            return stats;
+
+        sorter.sort(keys, order);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glActiveTexture(GL_TEXTURE0);
+        GLuint boundProgram = 0, boundTexture = 0;
+        bool first = true;
+
+        size_t i = 0;
+        while (i < keys.size()) {
+            const Entry &head = entries[order[i]];
+            size_t runEnd = i + 1;
+            while (runEnd < keys.size() && entries[order[runEnd]].program == head.program
+                   && entries[order[runEnd]].texture == head.texture)
+                ++runEnd;
+
+            if (first || head.program != boundProgram) {
+                glUseProgram(head.program);
+                boundProgram = head.program;
+                ++stats.stateChanges;
+            }
+            if (first || head.texture != boundTexture) {
+                glBindTexture(GL_TEXTURE_2D, head.texture);
+                boundTexture = head.texture;
+                ++stats.stateChanges;
+            }
+            first = false;
+
+            while (i < runEnd) {
+                size_t quads = std::min(runEnd - i, maxQuadsPerDraw);
+                if (ringQuads - cursor < quads) {
+                    glBufferData(GL_ARRAY_BUFFER, ringBytes(), nullptr, GL_STREAM_DRAW);
+                    cursor = 0;
+                    ++stats.orphans;
+                }
+
+                void *mapped = glMapBufferRange(GL_ARRAY_BUFFER, cursor * quadBytes, quads * quadBytes,
+                                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+                if (!mapped) {
+                    std::cout << "Failed to map sprite vertex buffer" << std::endl;
+                    clear();
+                    return stats;
+                }
+                SpriteVertex *out = static_cast<SpriteVertex *>(mapped);
+                for (size_t q = 0; q < quads; ++q)
+                    writeQuad(entries[order[i + q]].sprite, out + q * 4);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+
+                glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(quads * 6), GL_UNSIGNED_SHORT, nullptr,
+                                         static_cast<GLint>(cursor * 4));
+                ++stats.drawCalls;
+                cursor += quads;
+                i += quads;
+            }
+        }
+
+        glBindVertexArray(0);
+        clear();
+        return stats;
+    }
+
+    /// Drops everything queued without drawing it.
+    void clear() {
+        entries.clear();
+        keys.clear();
+        order.clear();
+    }
+
+private:
+    struct Entry {
+        Sprite sprite;
+        GLuint program;
+        GLuint texture;
+    };
+
+    static constexpr size_t quadBytes = 4 * sizeof(SpriteVertex);
+
+    static uint32_t packColor(const glm::vec4 &c) {
+        auto channel = [](float v) { return static_cast<uint32_t>(std::min(std::max(v, 0.0f), 1.0f) * 255.0f + 0.5f); };
+        return channel(c.r) | channel(c.g) << 8 | channel(c.b) << 16 | channel(c.a) << 24;
+    }
+
+    static void writeQuad(const Sprite &s, SpriteVertex *out) {
+        uint32_t color = packColor(s.color);
+        float x1 = s.position.x + s.size.x, y1 = s.position.y + s.size.y;
+        out[0] = {s.position.x, s.position.y, s.uv.x, s.uv.y, color};
+        out[1] = {x1, s.position.y, s.uv.z, s.uv.y, color};
+        out[2] = {x1, y1, s.uv.z, s.uv.w, color};
+        out[3] = {s.position.x, y1, s.uv.x, s.uv.w, color};
+    }
+
+    size_t ringBytes() const { return ringQuads * quadBytes; }
+
+    size_t ringQuads;
+    size_t cursor = 0;    // next free quad in the ring
+    std::vector<Entry> entries;
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> order;    // indices into entries, sorted by key
+    radix::Sorter sorter;
+};
+
+#endif
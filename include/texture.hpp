@@ -1,10 +1,209 @@
 #ifndef TEXTURE_HPP
 #define TEXTURE_HPP
 
+#include "half.hpp"
 #include <glad/glad.h>
 #include <stb_image.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Per-load decode options. Everything that used to be global stb_image state
+ * lives here so loads on different threads can't affect each other.
+ */
+struct TextureDesc {
+    bool flipVertically = true;
+    int desiredChannels = 0;   // 0 keeps whatever the file has
+    bool load16Bit = false;    // use stbi_load_16 (only meaningful for PNG)
+    bool loadHdr = false;      // use stbi_loadf; .hdr files always load this way
+    bool premultiplyAlpha = false;
+    bool srgb = false;         // colour data: 8-bit RGB(A) gets an sRGB internal format
+};
+
+/**
+ * Swaps row i with row (height - 1 - i) in place, 16 bytes at a time where
+ * SSE2 is available.
+ */
+inline void flipRowsInPlace(void *pixels, size_t rowBytes, int height) {
+    unsigned char *top = static_cast<unsigned char *>(pixels);
+    unsigned char *bottom = top + (height - 1) * rowBytes;
+
+    for (; top < bottom; top += rowBytes, bottom -= rowBytes) {
+        size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        for (; i + 16 <= rowBytes; i += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(top + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bottom + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(top + i), b);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(bottom + i), a);
+        }
+#endif
+        for (; i < rowBytes; ++i)
+            std::swap(top[i], bottom[i]);
+    }
+}
+
+/**
+ * Grey and grey+alpha images stay 1 and 2 channels in memory; the swizzle
+ * makes them sample like the RGB(A) images they came from. Does nothing for
+ * 3 and 4 channels. Applies to the texture bound to `target`.
+ */
+inline void setChannelSwizzle(GLenum target, int nrChannels) {
+    if (nrChannels == 1) {
+        GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+        glTexParameteriv(target, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    } else if (nrChannels == 2) {
+        GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_GREEN };
+        glTexParameteriv(target, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+}
+
+/**
+ * Decoded pixels straight from stb_image. Owns the buffer and is move-only.
+ *
+ * Decoding touches no GL or global state, so images can be decoded on worker
+ * threads and handed to Texture on the GL thread.
+ */
+struct Image {
+    enum class PixelType { UInt8, UInt16, Half };
+
+    void *pixels = nullptr;
+    int width = 0, height = 0, nrChannels = 0;
+    PixelType type = PixelType::UInt8;
+    bool srgb = false;
+
+    Image() = default;
+
+    /**
+     * @brief An uninitialized image for pixels generated on the CPU.
+     *
+     * The buffer comes from malloc, which is what stbi_image_free releases
+     * unless STBI_MALLOC/STBI_FREE are overridden.
+     */
+    Image(int width, int height, int nrChannels, PixelType type = PixelType::UInt8)
+        : width(width), height(height), nrChannels(nrChannels), type(type) {
+        pixels = std::malloc(static_cast<size_t>(height) * rowBytes());
+    }
+
+    /**
+     * HDR images are decoded as float and converted to half in place, so they
+     * take half the memory on both the CPU and the GPU.
+     */
+    Image(const std::string &path, const TextureDesc &desc = {}) : srgb(desc.srgb) {
+        int fileChannels = 0;
+        if (desc.loadHdr || stbi_is_hdr(path.c_str())) {
+            pixels = stbi_loadf(path.c_str(), &width, &height, &fileChannels, desc.desiredChannels);
+            type = PixelType::Half;
+        } else if (desc.load16Bit) {
+            pixels = stbi_load_16(path.c_str(), &width, &height, &fileChannels, desc.desiredChannels);
+            type = PixelType::UInt16;
+        } else {
+            pixels = stbi_load(path.c_str(), &width, &height, &fileChannels, desc.desiredChannels);
+        }
+        if (!pixels)
+            return;
+
+        nrChannels = desc.desiredChannels ? desc.desiredChannels : fileChannels;
+        if (desc.premultiplyAlpha)
+            premultiplyPixels(pixels, static_cast<size_t>(width) * height, nrChannels, type);
+        if (type == PixelType::Half)
+            floatToHalf(static_cast<float *>(pixels), static_cast<uint16_t *>(pixels), sampleCount());
+        if (desc.flipVertically)
+            flipRowsInPlace(pixels, rowBytes(), height);
+    }
+
+    Image(Image &&other) noexcept { *this = std::move(other); }
+
+    Image &operator=(Image &&other) noexcept {
+        if (this != &other) {
+            stbi_image_free(pixels);
+            pixels = std::exchange(other.pixels, nullptr);
+            width = other.width;
+            height = other.height;
+            nrChannels = other.nrChannels;
+            type = other.type;
+            srgb = other.srgb;
+        }
+        return *this;
+    }
+
+    Image(const Image &) = delete;
+    Image &operator=(const Image &) = delete;
+
+    ~Image() {
+        stbi_image_free(pixels);
+    }
+
+    explicit operator bool() const { return pixels != nullptr; }
+
+    static GLenum glFormat(int nrChannels) {
+        static const GLenum formats[] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+        return formats[nrChannels - 1];
+    }
+
+    /// sRGB only exists for 8-bit RGB and RGBA; everything else stays linear.
+    static GLint glInternalFormat(PixelType type, int nrChannels, bool srgb = false) {
+        if (srgb && type == PixelType::UInt8 && nrChannels >= 3)
+            return nrChannels == 3 ? GL_SRGB8 : GL_SRGB8_ALPHA8;
+        static const GLint internalFormats[][4] = {
+            { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 },
+            { GL_R16, GL_RG16, GL_RGB16, GL_RGBA16 },
+            { GL_R16F, GL_RG16F, GL_RGB16F, GL_RGBA16F },
+        };
+        return internalFormats[static_cast<int>(type)][nrChannels - 1];
+    }
+
+    static GLenum glType(PixelType type) {
+        static const GLenum types[] = { GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_HALF_FLOAT };
+        return types[static_cast<int>(type)];
+    }
+
+    size_t bytesPerChannel() const { return type == PixelType::UInt8 ? 1 : 2; }
+    size_t sampleCount() const { return static_cast<size_t>(width) * height * nrChannels; }
+    size_t rowBytes() const { return static_cast<size_t>(width) * nrChannels * bytesPerChannel(); }
+
+    /**
+     * @brief Premultiplies `count` pixels in place. Alpha is the last channel;
+     *        anything but grey+alpha and RGBA is left alone.
+     *
+     * Half means the pixels are still the floats stbi_loadf returned, i.e.
+     * this runs before the half conversion.
+     */
+    static void premultiplyPixels(void *pixels, size_t count, int nrChannels, PixelType type) {
+        if (nrChannels != 2 && nrChannels != 4)
+            return;
+        if (type == PixelType::Half) {
+            float *p = static_cast<float *>(pixels);
+            int alpha = nrChannels - 1;
+            for (size_t i = 0; i < count; ++i, p += nrChannels)
+                for (int c = 0; c < alpha; ++c)
+                    p[c] *= p[alpha];
+        } else if (type == PixelType::UInt16) {
+            premultiplyAs<uint16_t>(static_cast<uint16_t *>(pixels), count, nrChannels, 65535);
+        } else {
+            premultiplyAs<uint8_t>(static_cast<uint8_t *>(pixels), count, nrChannels, 255);
+        }
+    }
+
+private:
+    template <typename T>
+    static void premultiplyAs(T *p, size_t count, int nrChannels, T maxValue) {
+        int alpha = nrChannels - 1;
+        for (size_t i = 0; i < count; ++i, p += nrChannels) {
+            uint32_t a = p[alpha];
+            for (int c = 0; c < alpha; ++c)
+                p[c] = static_cast<T>((p[c] * a + maxValue / 2) / maxValue);
+        }
+    }
+};
 
 /**
  * Handles the creation, binding, and configuration of 2D textures in OpenGL.
@@ -17,8 +216,22 @@ public:
     unsigned int ID;
     int width, height, nrChannels;
 
-    Texture(const std::string &path) {
-        stbi_set_flip_vertically_on_load(true);
+    Texture(const std::string &path, const TextureDesc &desc = {})
+        : Texture(Image(path, desc)) {
+        if (ID == 0)
+            std::cout << "Failed to load texture: " << path << std::endl;
+    }
+
+    /**
+     * @brief Uploads an already decoded image. Must run on the GL thread.
+     *
+     * Leaves ID at 0 if the image is empty.
+     */
+    explicit Texture(const Image &image)
+        : ID(0), width(image.width), height(image.height), nrChannels(image.nrChannels) {
+        if (!image)
+            return;
+
         glGenTextures(1, &ID);
         glBindTexture(GL_TEXTURE_2D, ID);
 
@@ -27,18 +240,14 @@ public:
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-        unsigned char *data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
-        if (data) {
-            GLenum format = (nrChannels == 3) ? GL_RGB : GL_RGBA;
-            glTexImage2D(
-                GL_TEXTURE_2D, 0, format, width, height,
-                0, format, GL_UNSIGNED_BYTE, data
-            );
-            glGenerateMipmap(GL_TEXTURE_2D);
-        } else {
-            std::cout << "Failed to load texture: " << path << std::endl;
-        }
-        stbi_image_free(data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(
+            GL_TEXTURE_2D, 0, Image::glInternalFormat(image.type, nrChannels, image.srgb), width, height,
+            0, Image::glFormat(nrChannels), Image::glType(image.type), image.pixels
+        );
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        setChannelSwizzle(GL_TEXTURE_2D, nrChannels);
     }
 
     void bind() const {
@@ -0,0 +1,429 @@
+#ifndef TEXTURE_STREAM_HPP
+#define TEXTURE_STREAM_HPP
+
+#include "png_decode.hpp"
+#include "texture.hpp"
+#include <glad/glad.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Loads a 2D texture a little at a time so a large image never stalls
+ *        the render loop for more than a few milliseconds.
+ *
+ * Call `step()` once per frame with a time budget. Each call reads a bounded
+ * chunk of the file, decodes some more of it, or uploads a bounded band of
+ * scanlines with glTexSubImage2D, then returns. The texture can be bound
+ * while it is still streaming; rows that have not arrived yet are simply
+ * undefined.
+ *
+ * PNGs go through png::Decoder one scanline at a time on the calling
+ * thread, and each band is uploaded as soon as it is decoded. Everything else
+ * (and the PNGs png::Decoder turns down) is decoded by stb_image on a worker
+ * thread, as Flipbook does; `step()` only checks whether it has finished and
+ * then uploads the result in bands. GL is only ever called from the thread
+ * calling `step()`.
+ *
+ * The TextureDesc is honoured the way Texture does it.
+ */
+class TextureStream {
+public:
+    enum class Stage { Read, Decode, Upload, Mipmap, Done, Failed };
+
+    unsigned int ID;
+    int width = 0, height = 0, nrChannels = 0;
+
+    /**
+     * @param path Image file to stream.
+     * @param desc Decode options, as for Texture.
+     * @param rowsPerStep Maximum number of scanlines uploaded per band.
+     * @param bytesPerStep Maximum number of file bytes read per chunk.
+     */
+    TextureStream(const std::string &path, const TextureDesc &desc = {}, int rowsPerStep = 64,
+                  size_t bytesPerStep = 256 * 1024)
+        : path(path), desc(desc), rowsPerStep(std::max(rowsPerStep, 1)),
+          bytesPerStep(std::max<size_t>(bytesPerStep, 1)) {
+        glGenTextures(1, &ID);
+        glBindTexture(GL_TEXTURE_2D, ID);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        // Only level 0 exists until the mipmap stage, so don't sample the rest.
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        file.open(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            fail("Failed to open texture");
+            return;
+        }
+        fileSize = static_cast<size_t>(file.tellg());
+        fileBytes.reserve(fileSize);
+        file.seekg(0);
+    }
+
+    /// A decode still running on the worker is cut short: stb sees the end
+    /// of its input and gives up.
+    ~TextureStream() {
+        cancelled = true;
+        if (worker.joinable())
+            worker.join();
+        stbi_image_free(decoded);
+    }
+
+    TextureStream(const TextureStream &) = delete;
+    TextureStream &operator=(const TextureStream &) = delete;
+
+    /**
+     * @brief Advances the load until the budget runs out or it finishes.
+     *
+     * At least one unit of work is always done, so a tiny budget still makes
+     * progress. While the worker is decoding it returns straight away.
+     *
+     * @param budgetMs Wall-clock time this call may spend, in milliseconds.
+     * @return true once the texture is fully loaded (or has failed).
+     */
+    bool step(double budgetMs = 1.0) {
+        deadline = clock::now() + std::chrono::duration_cast<clock::duration>(
+                                      std::chrono::duration<double, std::milli>(budgetMs));
+
+        do {
+            // Nothing to do on this thread until the worker is done.
+            if (worker.joinable() && !workerDone.load())
+                return false;
+            switch (stage) {
+            case Stage::Read:   readChunk();   break;
+            case Stage::Decode: decodeSome();  break;
+            case Stage::Upload: uploadBand();  break;
+            case Stage::Mipmap: buildMipmaps(); break;
+            case Stage::Done:
+            case Stage::Failed:
+                return true;
+            }
+        } while (clock::now() < deadline);
+
+        return done();
+    }
+
+    /**
+     * @brief Runs every remaining stage without a budget.
+     */
+    void finish() {
+        while (!step(1e9))
+            std::this_thread::yield();
+    }
+
+    void bind() const {
+        glBindTexture(GL_TEXTURE_2D, ID);
+    }
+
+    bool done() const { return stage == Stage::Done || stage == Stage::Failed; }
+    bool failed() const { return stage == Stage::Failed; }
+    Stage currentStage() const { return stage; }
+
+    /**
+     * @return Rough completion in [0, 1]: reading is the first quarter,
+     * decoding and uploading the rest.
+     */
+    float progress() const {
+        // The worker writes height, so it is only read once the PNG decoder
+        // or the finished worker has set it.
+        switch (stage) {
+        case Stage::Read:
+            return fileSize ? 0.25f * static_cast<float>(fileBytes.size()) / fileSize : 0.0f;
+        case Stage::Decode:
+            if (png)
+                return 0.25f + 0.75f * static_cast<float>(rowsUploaded) / std::max(height, 1);
+            return 0.25f + 0.5f * static_cast<float>(readOffset.load()) / std::max<size_t>(fileBytes.size(), 1);
+        case Stage::Upload:
+            return 0.75f + 0.25f * static_cast<float>(rowsUploaded) / std::max(height, 1);
+        default:
+            return 1.0f;
+        }
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    std::thread worker;
+    std::atomic<bool> workerDone{false};
+    std::atomic<bool> cancelled{false};
+
+    std::string path;
+    TextureDesc desc;
+    int rowsPerStep;
+    size_t bytesPerStep;
+    Stage stage = Stage::Read;
+    clock::time_point deadline;
+
+    std::ifstream file;
+    std::vector<unsigned char> fileBytes;
+    size_t fileSize = 0;
+
+    Image::PixelType type = Image::PixelType::UInt8;
+    std::unique_ptr<png::Decoder> png;
+    // Written only by the worker before `workerDone` is set, along with
+    // width, height and nrChannels.
+    void *decoded = nullptr;        // stb's output: floats for HDR
+    std::atomic<size_t> readOffset{0};
+    std::vector<unsigned char> band;
+    int rowsUploaded = 0;
+
+    void fail(const char *what) {
+        std::cout << what << ": " << path << std::endl;
+        stage = Stage::Failed;
+        fileBytes = {};
+        png.reset();
+    }
+
+    size_t rowBytes() const {
+        return static_cast<size_t>(width) * nrChannels * (type == Image::PixelType::UInt8 ? 1 : 2);
+    }
+
+    void readChunk() {
+        size_t offset = fileBytes.size();
+        size_t count = std::min(bytesPerStep, fileSize - offset);
+        fileBytes.resize(offset + count);
+        file.read(reinterpret_cast<char *>(fileBytes.data() + offset), count);
+        if (static_cast<size_t>(file.gcount()) != count) {
+            fail("Failed to read texture");
+            return;
+        }
+        if (fileBytes.size() == fileSize) {
+            file.close();
+            startDecode();
+        }
+    }
+
+    void startDecode() {
+        stage = Stage::Decode;
+        if (!desc.loadHdr) {
+            png = std::make_unique<png::Decoder>(fileBytes.data(), fileBytes.size());
+            if (png->supported()) {
+                width = png->width();
+                height = png->height();
+                nrChannels = desc.desiredChannels ? desc.desiredChannels : png->channels();
+                type = desc.load16Bit ? Image::PixelType::UInt16 : Image::PixelType::UInt8;
+                allocate();
+                return;
+            }
+            png.reset();
+        }
+
+        int size = static_cast<int>(fileBytes.size());
+        if (desc.loadHdr || stbi_is_hdr_from_memory(fileBytes.data(), size))
+            type = Image::PixelType::Half;
+        else if (desc.load16Bit)
+            type = Image::PixelType::UInt16;
+        // fileBytes is left alone until the worker is done, so it can read
+        // it without a lock.
+        worker = std::thread([this] {
+            decodeWithStb();
+            workerDone = true;
+        });
+    }
+
+    void decodeSome() {
+        if (png) {
+            decodeBand();
+            return;
+        }
+
+        worker.join();
+        fileBytes = {};
+        if (!decoded) {
+            fail("Failed to load texture");
+            return;
+        }
+        allocate();
+        if (stage != Stage::Failed)
+            stage = Stage::Upload;
+    }
+
+    void decodeWithStb() {
+        stbi_io_callbacks callbacks = { &stbRead, &stbSkip, &stbEof };
+        int fileChannels = 0;
+        if (type == Image::PixelType::Half)
+            decoded = stbi_loadf_from_callbacks(&callbacks, this, &width, &height, &fileChannels, desc.desiredChannels);
+        else if (type == Image::PixelType::UInt16)
+            decoded = stbi_load_16_from_callbacks(&callbacks, this, &width, &height, &fileChannels, desc.desiredChannels);
+        else
+            decoded = stbi_load_from_callbacks(&callbacks, this, &width, &height, &fileChannels, desc.desiredChannels);
+        nrChannels = desc.desiredChannels ? desc.desiredChannels : fileChannels;
+    }
+
+    // stb pulls input through here on the worker, which is how progress()
+    // follows it and how the destructor stops it early.
+    static int stbRead(void *user, char *data, int size) {
+        auto *self = static_cast<TextureStream *>(user);
+        if (self->cancelled.load())
+            return 0;
+        size_t offset = self->readOffset.load();
+        size_t count = std::min(static_cast<size_t>(size), self->fileBytes.size() - offset);
+        std::memcpy(data, self->fileBytes.data() + offset, count);
+        self->readOffset = offset + count;
+        return static_cast<int>(count);
+    }
+
+    // A negative count steps back.
+    static void stbSkip(void *user, int count) {
+        auto *self = static_cast<TextureStream *>(user);
+        size_t offset = self->readOffset.load();
+        if (count < 0)
+            self->readOffset = offset - std::min(static_cast<size_t>(-static_cast<int64_t>(count)), offset);
+        else
+            self->readOffset = std::min(offset + count, self->fileBytes.size());
+    }
+
+    static int stbEof(void *user) {
+        auto *self = static_cast<TextureStream *>(user);
+        if (self->cancelled.load())
+            return 1;
+        return self->readOffset.load() >= self->fileBytes.size();
+    }
+
+    void allocate() {
+        if (nrChannels < 1 || nrChannels > 4) {
+            fail("Failed to load texture");
+            return;
+        }
+        bind();
+        glTexImage2D(
+            GL_TEXTURE_2D, 0, Image::glInternalFormat(type, nrChannels, desc.srgb), width, height,
+            0, Image::glFormat(nrChannels), Image::glType(type), nullptr
+        );
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        setChannelSwizzle(GL_TEXTURE_2D, nrChannels);
+        band.resize(static_cast<size_t>(rowsPerStep) * rowBytes());
+    }
+
+    // When flipping, a band fills from its last slot backwards, so its rows
+    // are contiguous in texture order either way.
+    unsigned char *bandRow(int i) {
+        int slot = desc.flipVertically ? rowsPerStep - 1 - i : i;
+        return band.data() + slot * rowBytes();
+    }
+
+    void uploadRows(int rows) {
+        int first = desc.flipVertically ? rowsPerStep - rows : 0;
+        int y = desc.flipVertically ? height - rowsUploaded - rows : rowsUploaded;
+        bind();
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(
+            GL_TEXTURE_2D, 0, 0, y, width, rows,
+            Image::glFormat(nrChannels), Image::glType(type), band.data() + first * rowBytes()
+        );
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        rowsUploaded += rows;
+    }
+
+    // Decodes PNG rows until the band is full or time is up, then uploads them.
+    void decodeBand() {
+        int rows = 0, limit = std::min(rowsPerStep, height - rowsUploaded);
+        do {
+            const void *row = png->nextRow();
+            if (!row) {
+                fail("Failed to load texture");
+                return;
+            }
+            unsigned char *dst = bandRow(rows);
+            if (png->bytesPerSample() == 1)
+                storeRow(static_cast<const uint8_t *>(row), dst);
+            else
+                storeRow(static_cast<const uint16_t *>(row), dst);
+            if (desc.premultiplyAlpha)
+                Image::premultiplyPixels(dst, width, nrChannels, type);
+            ++rows;
+        } while (rows < limit && clock::now() < deadline);
+
+        uploadRows(rows);
+        if (rowsUploaded == height) {
+            png.reset();
+            fileBytes = {};
+            stage = Stage::Mipmap;
+        }
+    }
+
+    template <typename Src>
+    void storeRow(const Src *src, unsigned char *dst) {
+        if (type == Image::PixelType::UInt16)
+            convertRow(src, reinterpret_cast<uint16_t *>(dst));
+        else
+            convertRow(src, dst);
+    }
+
+    // Channel conversion as stb_image does it, in the file's bit depth, then
+    // widened or narrowed to the texture's.
+    template <typename Src, typename Dst>
+    void convertRow(const Src *src, Dst *dst) {
+        const Src max = static_cast<Src>(~Src(0));
+        int from = png->channels(), to = nrChannels;
+        for (int x = 0; x < width; ++x, src += from, dst += to) {
+            Src r = src[0], g = from >= 3 ? src[1] : r, b = from >= 3 ? src[2] : r;
+            Src a = (from == 2 || from == 4) ? src[from - 1] : max;
+            Src grey = from >= 3 ? static_cast<Src>((r * 77u + g * 150u + b * 29u) >> 8) : r;
+            Src out[4] = { grey, a, 0, 0 };
+            if (to >= 3) {
+                out[0] = r;
+                out[1] = g;
+                out[2] = b;
+                out[3] = a;
+            }
+            for (int c = 0; c < to; ++c) {
+                if (sizeof(Dst) == sizeof(Src))
+                    dst[c] = static_cast<Dst>(out[c]);
+                else if (sizeof(Dst) > sizeof(Src))
+                    dst[c] = static_cast<Dst>(out[c] * 257u);
+                else
+                    dst[c] = static_cast<Dst>(out[c] >> 8);
+            }
+        }
+    }
+
+    // Copies a band of stb's rows out, applying premultiply and the half
+    // conversion on the way.
+    void uploadBand() {
+        int rows = std::min(rowsPerStep, height - rowsUploaded);
+        size_t samples = static_cast<size_t>(width) * nrChannels;
+        for (int i = 0; i < rows; ++i) {
+            size_t row = static_cast<size_t>(rowsUploaded + i);
+            unsigned char *dst = bandRow(i);
+            if (type == Image::PixelType::Half) {
+                float *src = static_cast<float *>(decoded) + row * samples;
+                if (desc.premultiplyAlpha)
+                    Image::premultiplyPixels(src, width, nrChannels, type);
+                floatToHalf(src, reinterpret_cast<uint16_t *>(dst), samples);
+            } else {
+                std::memcpy(dst, static_cast<unsigned char *>(decoded) + row * rowBytes(), rowBytes());
+                if (desc.premultiplyAlpha)
+                    Image::premultiplyPixels(dst, width, nrChannels, type);
+            }
+        }
+        uploadRows(rows);
+
+        if (rowsUploaded == height) {
+            stbi_image_free(decoded);
+            decoded = nullptr;
+            stage = Stage::Mipmap;
+        }
+    }
+
+    void buildMipmaps() {
+        bind();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        stage = Stage::Done;
+    }
+};
+
+#endif
@@ -0,0 +1,243 @@
+#ifndef VERTEX_PACK_HPP
+#define VERTEX_PACK_HPP
+
+#include "simd.hpp"
+#include "half.hpp"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+/**
+ * Compresses interleaved float vertices into smaller GPU formats and builds
+ * the glVertexAttribPointer calls that read them back.
+ *
+ * The conversions match glm's gtc/packing.hpp (packHalf, packSnorm,
+ * packUnorm, packSnorm3x10_1x2, packUnorm3x10_1x2) but run over whole arrays:
+ * each attribute is pulled out into structure-of-arrays chunks, quantized
+ * with the SIMD wrappers, then written back interleaved.
+ *
+ * A typical position/colour/UV vertex drops from 32 bytes to 16 with Half
+ * positions and UVs and Unorm8 colours, or to 12 with Snorm16 positions that
+ * were scaled into [-1, 1].
+ */
+namespace vertexpack {
+
+enum class Format {
+    Float,        // unchanged, 4 bytes per component
+    Half,         // GL_HALF_FLOAT, 2 bytes per component
+    Snorm16,      // [-1, 1] as GL_SHORT, 2 bytes per component
+    Unorm8,       // [0, 1] as GL_UNSIGNED_BYTE, 1 byte per component
+    Snorm10x3_2,  // [-1, 1] as GL_INT_2_10_10_10_REV, 4 bytes total
+    Unorm10x3_2,  // [0, 1] as GL_UNSIGNED_INT_2_10_10_10_REV, 4 bytes total
+};
+
+struct Attribute {
+    GLuint location;
+    int components;       // 1-4, read from the source vertex
+    Format format;
+    int sourceOffset;     // in floats, from the start of a source vertex
+};
+
+/**
+ * Where each attribute lands in a packed vertex. Every attribute starts on a
+ * 4-byte boundary, as GL prefers.
+ *
+ * @note The 10:10:10:2 formats always have GL size 4; components the source
+ * doesn't provide are written as 0.
+ */
+struct Layout {
+    struct Entry {
+        Attribute attribute;
+        GLint size;
+        GLenum type;
+        GLboolean normalized;
+        size_t offset;
+    };
+
+    std::vector<Entry> entries;
+    size_t stride = 0;
+
+    Layout() = default;
+
+    explicit Layout(const std::vector<Attribute> &attributes) {
+        for (const Attribute &a : attributes) {
+            Entry e{a, a.components, GL_FLOAT, GL_FALSE, stride};
+            size_t bytes = 0;
+            switch (a.format) {
+            case Format::Float:
+                bytes = 4 * a.components;
+                break;
+            case Format::Half:
+                e.type = GL_HALF_FLOAT;
+                bytes = 2 * a.components;
+                break;
+            case Format::Snorm16:
+                e.type = GL_SHORT;
+                e.normalized = GL_TRUE;
+                bytes = 2 * a.components;
+                break;
+            case Format::Unorm8:
+                e.type = GL_UNSIGNED_BYTE;
+                e.normalized = GL_TRUE;
+                bytes = a.components;
+                break;
+            case Format::Snorm10x3_2:
+            case Format::Unorm10x3_2:
+                e.type = a.format == Format::Snorm10x3_2 ? GL_INT_2_10_10_10_REV : GL_UNSIGNED_INT_2_10_10_10_REV;
+                e.size = 4;
+                e.normalized = GL_TRUE;
+                bytes = 4;
+                break;
+            }
+            entries.push_back(e);
+            stride += (bytes + 3) & ~size_t(3);
+        }
+    }
+
+    /**
+     * @brief Points and enables every attribute for the bound VAO and
+     *        GL_ARRAY_BUFFER.
+     */
+    void apply() const {
+        for (const Entry &e : entries) {
+            glVertexAttribPointer(e.attribute.location, e.size, e.type, e.normalized,
+                                  static_cast<GLsizei>(stride), (void *)e.offset);
+            glEnableVertexAttribArray(e.attribute.location);
+        }
+    }
+};
+
+struct PackedVertices {
+    Layout layout;
+    std::vector<unsigned char> data;
+    size_t count = 0;
+
+    size_t bytes() const { return data.size(); }
+};
+
+namespace detail {
+
+// out[i] = round(clamp(in[i], low, 1) * scale), rounding halves away from
+// zero like glm::round.
+template <class Ops>
+struct QuantizeKernel {
+    static void run(size_t count, const float *in, float *out, float low, float scale) {
+        simd::forEachBlock<Ops>(count, [&](auto ops, size_t i) {
+            using O = decltype(ops);
+            using F = typename O::Float;
+            F v = O::min(O::max(O::load(in + i), O::set1(low)), O::set1(1.0f));
+            v = O::mul(v, O::set1(scale));
+            O::store(out + i, O::flipSign(O::floor(O::add(O::abs(v), O::set1(0.5f))), v));
+        });
+    }
+};
+
+inline void quantize(const float *in, float *out, size_t count, float low, float scale) {
+    simd::dispatch<QuantizeKernel>(count, in, out, low, scale);
+}
+
+}
+
+/**
+ * @brief Packs `count` vertices of `floatsPerVertex` floats each into the
+ *        formats the attributes ask for.
+ *
+ * @return Nothing packed if an attribute has other than 1 to 4 components or
+ * reads past the end of a source vertex.
+ */
+inline PackedVertices pack(const float *vertices, size_t count, int floatsPerVertex,
+                           const std::vector<Attribute> &attributes) {
+    PackedVertices out;
+    for (const Attribute &a : attributes) {
+        if (a.components < 1 || a.components > 4 || a.sourceOffset < 0 ||
+            a.sourceOffset + a.components > floatsPerVertex) {
+            std::cout << "Failed to pack vertices: attribute " << a.location << " has " << a.components
+                      << " components at offset " << a.sourceOffset << std::endl;
+            return out;
+        }
+    }
+    out.layout = Layout(attributes);
+    out.count = count;
+    out.data.assign(count * out.layout.stride, 0);
+
+    constexpr size_t chunk = 256;
+    float soa[4][chunk], quantized[4][chunk];
+    uint16_t halves[4][chunk];
+
+    for (size_t base = 0; base < count; base += chunk) {
+        size_t n = std::min(chunk, count - base);
+        const float *src = vertices + base * floatsPerVertex;
+        unsigned char *vertexBase = out.data.data() + base * out.layout.stride;
+
+        for (const Layout::Entry &e : out.layout.entries) {
+            const Attribute &a = e.attribute;
+            for (int c = 0; c < a.components; ++c)
+                for (size_t i = 0; i < n; ++i)
+                    soa[c][i] = src[i * floatsPerVertex + a.sourceOffset + c];
+
+            unsigned char *dst = vertexBase + e.offset;
+            size_t stride = out.layout.stride;
+
+            switch (a.format) {
+            case Format::Float:
+                for (size_t i = 0; i < n; ++i)
+                    for (int c = 0; c < a.components; ++c)
+                        std::memcpy(dst + i * stride + 4 * c, &soa[c][i], 4);
+                break;
+
+            case Format::Half:
+                for (int c = 0; c < a.components; ++c)
+                    floatToHalf(soa[c], halves[c], n);
+                for (size_t i = 0; i < n; ++i)
+                    for (int c = 0; c < a.components; ++c)
+                        std::memcpy(dst + i * stride + 2 * c, &halves[c][i], 2);
+                break;
+
+            case Format::Snorm16:
+                for (int c = 0; c < a.components; ++c)
+                    detail::quantize(soa[c], quantized[c], n, -1.0f, 32767.0f);
+                for (size_t i = 0; i < n; ++i)
+                    for (int c = 0; c < a.components; ++c) {
+                        int16_t v = static_cast<int16_t>(quantized[c][i]);
+                        std::memcpy(dst + i * stride + 2 * c, &v, 2);
+                    }
+                break;
+
+            case Format::Unorm8:
+                for (int c = 0; c < a.components; ++c)
+                    detail::quantize(soa[c], quantized[c], n, 0.0f, 255.0f);
+                for (size_t i = 0; i < n; ++i)
+                    for (int c = 0; c < a.components; ++c)
+                        dst[i * stride + c] = static_cast<uint8_t>(quantized[c][i]);
+                break;
+
+            case Format::Snorm10x3_2:
+            case Format::Unorm10x3_2: {
+                bool isSigned = a.format == Format::Snorm10x3_2;
+                for (int c = 0; c < a.components; ++c)
+                    detail::quantize(soa[c], quantized[c], n, isSigned ? -1.0f : 0.0f,
+                                     c < 3 ? (isSigned ? 511.0f : 1023.0f) : (isSigned ? 1.0f : 3.0f));
+                for (size_t i = 0; i < n; ++i) {
+                    uint32_t packed = 0;
+                    for (int c = 0; c < a.components; ++c) {
+                        uint32_t mask = c < 3 ? 0x3FFu : 0x3u;
+                        uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(quantized[c][i])) & mask;
+                        packed |= bits << (10 * c);
+                    }
+                    std::memcpy(dst + i * stride, &packed, 4);
+                }
+                break;
+            }
+            }
+        }
+    }
+    return out;
+}
+
+}
+
+#endif
@@ -1,8 +1,11 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "glad/glad.h" // glad must go b4 glfw
+#include "include/geometry_arena.hpp"
+#include "include/mesh_format.hpp"
 #include "include/shader.hpp"
 #include "include/texture.hpp"
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -45,34 +48,6 @@ void checkShaderError(unsigned int shader) {
     }
 }
 
-// For reusing vertices when making triangles.
-uint createEBO(uint *indices, size_t size) {
-    uint EBO;
-
-    glGenBuffers(1, &EBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(
-        GL_ELEMENT_ARRAY_BUFFER,
-        size,
-        indices,
-        GL_STATIC_DRAW);
-
-    return EBO;
-}
-
-void handleVertexObjects(
-    unsigned int *VAO,
-    unsigned int *VBO,
-    const float *vertices,
-    size_t sizeOfVertices
-) {
-    glGenVertexArrays(1, VAO);
-    glBindVertexArray(*VAO);             // Sets the currently active VAO
-    glGenBuffers(1, VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, *VBO); // Associates the VBO with the current VAO
-    glBufferData(GL_ARRAY_BUFFER, sizeOfVertices, vertices, GL_STATIC_DRAW);
-}
-
 int main() {
     glfwInit();
     setGlfwVersion(3, 3);
@@ -96,70 +71,25 @@ int main() {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    Shader shader("../shaders/vertex.vert", "../shaders/colorFromVertex.frag");
-    Shader shaderTwo("../shaders/vertex.vert", "../shaders/uniformColor.frag");
+    glEnable(GL_DEPTH_TEST);
+
+    Shader shader("../shaders/mesh.vert", "../shaders/mesh.frag");
     shader.use();
     shader.setUniformInt("texture1", 0);
     shader.setUniformInt("texture2", 1);
     float alpha = 0.0f;
     shader.setUniformFloat("alpha", alpha);
 
-    float triangles[] = {
-        // positions          // colors           // texture coords
-        0.5f,  0.5f, 0.0f,   1.0f, 0.0f, 0.0f,   2.0f, 2.0f,   // top right
-        0.5f, -0.5f, 0.0f,   0.0f, 1.0f, 0.0f,   2.0f, 0.0f,   // bottom right
-       -0.5f, -0.5f, 0.0f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f,   // bottom left
-       -0.5f,  0.5f, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 2.0f    // top left
-    };
-
-    unsigned int indices[] = {
-        0, 1, 3,   // first triangle
-        1, 2, 3    // second triangle
-    };
-
-    unsigned int EBO = createEBO(indices, sizeof(indices));
-    unsigned int vertexBufferObject; // Stores raw vertex data (positions, colors, texture coordinates, etc.) in GPU memory.
-    unsigned int vertexArrayObject;  // Stores the configuration of how vertex data is interpreted and used.
-    handleVertexObjects(
-        &vertexBufferObject,
-        &vertexArrayObject,
-        triangles,
-        sizeof(triangles)
-    );
-
-    // position
-    glVertexAttribPointer(
-        0, 3,
-        GL_FLOAT,
-        GL_FALSE,
-        8 * sizeof(float),
-        (void *)0
-    );
-    glEnableVertexAttribArray(0);
-    // color
-    glVertexAttribPointer(
-        1, 3,
-        GL_FLOAT,
-        GL_FALSE,
-        8 * sizeof(float),
-        (void*)(3 * sizeof(float))
-    );
-    glEnableVertexAttribArray(1);
-    // texture
-    glVertexAttribPointer(
-        2, 2,
-        GL_FLOAT,
-        GL_FALSE,
-        8 * sizeof(float),
-        (void*)(6 * sizeof(float))
-    );
-    glEnableVertexAttribArray(2);
-
-    float textureCoords[] = {
-        0.0f, -0.5f,
-        -0.5f, 0.5f,
-        0.5f, 0.5f
-    };
+    // Cooked from meshes/torus.obj by tools/obj2mesh: the file is mapped and
+    // its vertex and index blobs go straight into the arena's buffers.
+    meshfile::MeshFile torus("../meshes/torus.mesh");
+    if (!torus) {
+        glfwTerminate();
+        return -1;
+    }
+    GeometryArena arena(torus.layout());
+    MeshRange torusRange = arena.add(torus.vertices(), torus.vertexCount(), torus.indices(), torus.indexCount());
+    size_t shownLevel = torus.lodCount();
 
     Texture slop("../textures/slop.jpg");
     Texture tomato("../textures/tomato.png");
@@ -167,7 +97,7 @@ int main() {
 
     while (!glfwWindowShouldClose(window)) {
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         glActiveTexture(GL_TEXTURE0);
         slop.bind();
@@ -184,9 +114,33 @@ int main() {
         glActiveTexture(GL_TEXTURE1);
         tomato.bind();
         
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+        float aspect = float(width) / float(std::max(height, 1));
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 100.0f);
+        // The torus drifts away and back, so the LODs take over in turn.
+        float time = float(glfwGetTime());
+        float distance = 3.0f + 27.0f * (0.5f - 0.5f * std::cos(time * 0.3f));
+        glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -distance));
+        glm::mat4 model = glm::rotate(glm::mat4(1.0f), time, glm::vec3(1.0f, 0.3f, 0.0f));
+
+        // The file holds every LOD's indices one after another; draw the
+        // coarsest one that stays within a pixel of the original.
+        size_t level = torus.selectLod(projection * view * model, float(height));
+        MeshRange torusLod = torusRange;
+        torusLod.firstIndex += torus.lod(level).firstIndex;
+        torusLod.indexCount = torus.lod(level).indexCount;
+        if (level != shownLevel) {
+            std::string title = "OpenGL - torus LOD " + std::to_string(level) + ", "
+                              + std::to_string(torusLod.indexCount / 3) + " triangles";
+            glfwSetWindowTitle(window, title.c_str());
+            shownLevel = level;
+        }
+
         shader.use();
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO); // u don't need to this in loop unless ur object changes
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        shader.setMat4("model", model);
+        shader.setMat4("viewProjection", projection * view);
+        arena.draw(torusLod);
 
         processKeyboardInput(window);
 
@@ -0,0 +1,12 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec4 ourColor;
+in vec3 TexCoord;
+
+uniform sampler2DArray textures;
+
+void main()
+{
+    FragColor = texture(textures, TexCoord) * ourColor;
+}
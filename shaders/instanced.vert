@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in mat4 aModel; // one per instance, takes 3-6
+layout (location = 7) in vec4 aInstanceColor;
+layout (location = 8) in float aLayer;
+
+uniform mat4 viewProjection;
+
+out vec4 ourColor;
+out vec3 TexCoord; // xy plus texture array layer
+
+void main()
+{
+    gl_Position = viewProjection * aModel * vec4(aPos, 1.0);
+    ourColor = vec4(aColor, 1.0) * aInstanceColor;
+    TexCoord = vec3(aTexCoord, aLayer);
+}
@@ -1,6 +1,6 @@
 #version 330 core
 out vec4 FragColor;
-  
+
 in vec3 ourColor;
 in vec2 TexCoord;
 
@@ -14,5 +14,5 @@ void main()
                     texture(texture1, TexCoord),
                     texture(texture2, TexCoord),
                     alpha
-                );
-}
\ No newline at end of file
+                ) * vec4(ourColor, 1.0);
+}
@@ -0,0 +1,18 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+
+uniform mat4 model;
+uniform mat4 viewProjection;
+
+out vec3 ourColor; // diffuse light from a fixed direction
+out vec2 TexCoord;
+
+void main()
+{
+    gl_Position = viewProjection * model * vec4(aPos, 1.0);
+    vec3 normal = normalize(mat3(model) * aNormal);
+    ourColor = vec3(0.25 + 0.75 * max(dot(normal, normalize(vec3(0.4, 0.8, 0.6))), 0.0));
+    TexCoord = aTexCoord;
+}
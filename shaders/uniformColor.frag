@@ -1,8 +0,0 @@
-#version 330 core
-out vec4 FragColor;
-uniform vec4 ourColor; // uniform means global
-
-void main()
-{
-    FragColor = ourColor;
-}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in vec2 aTexCoord;
+
+// One draw call per object; instanced.vert reads these per instance instead.
+uniform mat4 model;
+uniform vec4 instanceColor;
+uniform float layer;
+uniform mat4 viewProjection;
+
+out vec4 ourColor;
+out vec3 TexCoord; // xy plus texture array layer
+
+void main()
+{
+    gl_Position = viewProjection * model * vec4(aPos, 1.0);
+    ourColor = vec4(aColor, 1.0) * instanceColor;
+    TexCoord = vec3(aTexCoord, layer);
+}
@@ -0,0 +1,37 @@
+#ifndef CHECK_HPP
+#define CHECK_HPP
+
+#include <cstdio>
+
+/**
+ * The tests are plain executables. CHECK records a failure and carries on,
+ * and main returns check::result() so CTest sees a non-zero exit.
+ */
+namespace check {
+
+inline int &failures() {
+    static int count = 0;
+    return count;
+}
+
+inline bool record(bool ok, const char *expression, const char *file, int line) {
+    if (!ok) {
+        std::printf("%s:%d: CHECK(%s) failed\n", file, line, expression);
+        ++failures();
+    }
+    return ok;
+}
+
+inline int result() {
+    if (failures())
+        std::printf("%d check(s) failed\n", failures());
+    else
+        std::printf("all checks passed\n");
+    return failures() ? 1 : 0;
+}
+
+}
+
+#define CHECK(expression) check::record(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
+
+#endif
@@ -0,0 +1,281 @@
+#ifndef GL_STUB_HPP
+#define GL_STUB_HPP
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Stands in for an OpenGL context in tests that have no window, by pointing
+ * the glad function pointers the headers use at fakes that keep their state
+ * in plain memory. Call `glstub::install()` first.
+ *
+ * Textures keep level 0 of GL_TEXTURE_2D so uploads can be compared with the
+ * image they came from. Buffers keep their contents and can be mapped. Fences
+ * are counted, so leaks show, and can be made to time out. Binds, uniforms and
+ * draws are appended to `state.calls`.
+ */
+namespace glstub {
+
+struct Texture {
+    int width = 0, height = 0;
+    GLint internalFormat = 0;
+    GLenum format = 0, type = 0;
+    std::map<GLenum, GLint> parameters;
+    bool mipmapped = false;
+    std::vector<uint8_t> pixels;   // tightly packed rows
+
+    size_t pixelBytes() const {
+        size_t channels = format == GL_RED ? 1 : format == GL_RG ? 2 : format == GL_RGB ? 3 : 4;
+        return channels * (type == GL_UNSIGNED_BYTE ? 1 : type == GL_FLOAT ? 4 : 2);
+    }
+};
+
+struct Buffer {
+    std::vector<uint8_t> data;
+    bool mapped = false;
+    size_t maps = 0;
+};
+
+/// One recorded call: its name, integer arguments, then float data.
+struct Call {
+    std::string name;
+    std::vector<int64_t> ints;
+    std::vector<float> floats;
+
+    bool operator==(const Call &other) const {
+        return name == other.name && ints == other.ints && floats == other.floats;
+    }
+};
+
+struct State {
+    GLuint nextName = 1;
+    std::map<GLuint, Texture> textures;
+    GLuint boundTexture = 0;
+    GLint unpackAlignment = 4;
+
+    std::map<GLuint, Buffer> buffers;
+    std::map<GLenum, GLuint> boundBuffers;
+    bool failMaps = false;
+
+    std::set<uintptr_t> fences;    // created and not yet deleted
+    uintptr_t nextFence = 1;
+    int timeoutsBeforeSignal = 0;  // glClientWaitSync times out this often first
+    size_t waits = 0, badDeletes = 0;
+
+    std::vector<Call> calls;
+};
+
+inline State state;
+
+namespace detail {
+
+inline void genTextures(GLsizei n, GLuint *names) {
+    for (GLsizei i = 0; i < n; ++i) {
+        names[i] = state.nextName++;
+        state.textures[names[i]];
+    }
+}
+
+inline void deleteTextures(GLsizei n, const GLuint *names) {
+    for (GLsizei i = 0; i < n; ++i)
+        state.textures.erase(names[i]);
+}
+
+inline void log(const char *name, std::vector<int64_t> ints, std::vector<float> floats = {}) {
+    state.calls.push_back({name, std::move(ints), std::move(floats)});
+}
+
+inline void bindTexture(GLenum target, GLuint name) {
+    state.boundTexture = name;
+    log("glBindTexture", {target, name});
+}
+
+inline void texParameteri(GLenum, GLenum name, GLint value) {
+    state.textures[state.boundTexture].parameters[name] = value;
+}
+
+inline void texParameteriv(GLenum, GLenum name, const GLint *values) {
+    state.textures[state.boundTexture].parameters[name] = values[0];
+}
+
+inline void pixelStorei(GLenum name, GLint value) {
+    if (name == GL_UNPACK_ALIGNMENT)
+        state.unpackAlignment = value;
+}
+
+inline void texImage2D(GLenum, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint,
+                       GLenum format, GLenum type, const void *pixels) {
+    if (level != 0)
+        return;
+    Texture &texture = state.textures[state.boundTexture];
+    texture.width = width;
+    texture.height = height;
+    texture.internalFormat = internalFormat;
+    texture.format = format;
+    texture.type = type;
+    texture.pixels.assign(size_t(width) * height * texture.pixelBytes(), 0);
+    if (pixels) {
+        size_t rowBytes = size_t(width) * texture.pixelBytes();
+        size_t stride = (rowBytes + state.unpackAlignment - 1) / state.unpackAlignment * state.unpackAlignment;
+        for (GLsizei y = 0; y < height; ++y)
+            std::memcpy(&texture.pixels[y * rowBytes], static_cast<const uint8_t *>(pixels) + y * stride, rowBytes);
+    }
+}
+
+inline void texSubImage2D(GLenum, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+                          GLenum, GLenum, const void *pixels) {
+    Texture &texture = state.textures[state.boundTexture];
+    if (level != 0)
+        return;
+    size_t pixelBytes = texture.pixelBytes(), rowBytes = size_t(width) * pixelBytes;
+    size_t stride = (rowBytes + state.unpackAlignment - 1) / state.unpackAlignment * state.unpackAlignment;
+    for (GLsizei row = 0; row < height; ++row)
+        std::memcpy(&texture.pixels[(size_t(y + row) * texture.width + x) * pixelBytes],
+                    static_cast<const uint8_t *>(pixels) + row * stride, rowBytes);
+}
+
+inline void generateMipmap(GLenum) { state.textures[state.boundTexture].mipmapped = true; }
+
+inline void useProgram(GLuint program) { log("glUseProgram", {program}); }
+inline void bindVertexArray(GLuint vao) { log("glBindVertexArray", {vao}); }
+inline void activeTexture(GLenum unit) { log("glActiveTexture", {unit}); }
+inline void uniform1i(GLint location, GLint value) { log("glUniform1i", {location, value}); }
+inline void uniform1f(GLint location, GLfloat value) { log("glUniform1f", {location}, {value}); }
+
+inline void uniform4fv(GLint location, GLsizei count, const GLfloat *values) {
+    log("glUniform4fv", {location, count}, std::vector<float>(values, values + 4 * count));
+}
+
+inline void uniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *values) {
+    log("glUniformMatrix4fv", {location, count, transpose}, std::vector<float>(values, values + 16 * count));
+}
+
+inline void drawArrays(GLenum mode, GLint first, GLsizei count) { log("glDrawArrays", {mode, first, count}); }
+
+inline void drawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void *offset, GLint baseVertex) {
+    log("glDrawElementsBaseVertex", {mode, count, type, int64_t(reinterpret_cast<uintptr_t>(offset)), baseVertex});
+}
+
+inline void drawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum type, const void *offset,
+                                            GLsizei instances, GLint baseVertex) {
+    log("glDrawElementsInstancedBaseVertex",
+        {mode, count, type, int64_t(reinterpret_cast<uintptr_t>(offset)), instances, baseVertex});
+}
+
+inline void genBuffers(GLsizei n, GLuint *names) {
+    for (GLsizei i = 0; i < n; ++i) {
+        names[i] = state.nextName++;
+        state.buffers[names[i]];
+    }
+}
+
+inline void deleteBuffers(GLsizei n, const GLuint *names) {
+    for (GLsizei i = 0; i < n; ++i)
+        state.buffers.erase(names[i]);
+}
+
+inline void bindBuffer(GLenum target, GLuint name) { state.boundBuffers[target] = name; }
+
+inline void bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum) {
+    Buffer &buffer = state.buffers[state.boundBuffers[target]];
+    buffer.data.assign(size_t(size), 0);
+    if (data)
+        std::memcpy(buffer.data.data(), data, size_t(size));
+}
+
+/// Stands in for glBufferStorage, which glad doesn't load.
+inline void bufferStorage(GLenum target, GLsizeiptr size, const void *data, GLbitfield) {
+    bufferData(target, size, data, 0);
+}
+
+inline void *mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield) {
+    Buffer &buffer = state.buffers[state.boundBuffers[target]];
+    if (state.failMaps || buffer.mapped || size_t(offset + length) > buffer.data.size())
+        return nullptr;
+    buffer.mapped = true;
+    ++buffer.maps;
+    return buffer.data.data() + offset;
+}
+
+inline GLboolean unmapBuffer(GLenum target) {
+    Buffer &buffer = state.buffers[state.boundBuffers[target]];
+    GLboolean wasMapped = buffer.mapped;
+    buffer.mapped = false;
+    return wasMapped;
+}
+
+inline GLsync fenceSync(GLenum, GLbitfield) {
+    state.fences.insert(state.nextFence);
+    return reinterpret_cast<GLsync>(state.nextFence++);
+}
+
+inline GLenum clientWaitSync(GLsync, GLbitfield, GLuint64) {
+    ++state.waits;
+    if (state.timeoutsBeforeSignal > 0) {
+        --state.timeoutsBeforeSignal;
+        return GL_TIMEOUT_EXPIRED;
+    }
+    return GL_ALREADY_SIGNALED;
+}
+
+inline void deleteSync(GLsync sync) {
+    if (!state.fences.erase(reinterpret_cast<uintptr_t>(sync)))
+        ++state.badDeletes;
+}
+
+inline void getIntegerv(GLenum, GLint *value) { *value = 0; }
+
+inline const GLubyte *getStringi(GLenum, GLuint) { return reinterpret_cast<const GLubyte *>(""); }
+
+}
+
+/// Resets the fake context and points glad at it.
+inline void install() {
+    state = State();
+    glad_glGenTextures = &detail::genTextures;
+    glad_glDeleteTextures = &detail::deleteTextures;
+    glad_glBindTexture = &detail::bindTexture;
+    glad_glTexParameteri = &detail::texParameteri;
+    glad_glTexParameteriv = &detail::texParameteriv;
+    glad_glPixelStorei = &detail::pixelStorei;
+    glad_glTexImage2D = &detail::texImage2D;
+    glad_glTexSubImage2D = &detail::texSubImage2D;
+    glad_glGenerateMipmap = &detail::generateMipmap;
+    glad_glUseProgram = &detail::useProgram;
+    glad_glBindVertexArray = &detail::bindVertexArray;
+    glad_glActiveTexture = &detail::activeTexture;
+    glad_glUniform1i = &detail::uniform1i;
+    glad_glUniform1f = &detail::uniform1f;
+    glad_glUniform4fv = &detail::uniform4fv;
+    glad_glUniformMatrix4fv = &detail::uniformMatrix4fv;
+    glad_glDrawArrays = &detail::drawArrays;
+    glad_glDrawElementsBaseVertex = &detail::drawElementsBaseVertex;
+    glad_glDrawElementsInstancedBaseVertex = &detail::drawElementsInstancedBaseVertex;
+    glad_glGenBuffers = &detail::genBuffers;
+    glad_glDeleteBuffers = &detail::deleteBuffers;
+    glad_glBindBuffer = &detail::bindBuffer;
+    glad_glBufferData = &detail::bufferData;
+    glad_glMapBufferRange = &detail::mapBufferRange;
+    glad_glUnmapBuffer = &detail::unmapBuffer;
+    glad_glFenceSync = &detail::fenceSync;
+    glad_glClientWaitSync = &detail::clientWaitSync;
+    glad_glDeleteSync = &detail::deleteSync;
+    glad_glGetIntegerv = &detail::getIntegerv;
+    glad_glGetStringi = &detail::getStringi;
+}
+
+/// A loader for DynamicBuffer::loadBufferStorage(): only glBufferStorage.
+inline void *loadProc(const char *name) {
+    return std::strcmp(name, "glBufferStorage") == 0 ? reinterpret_cast<void *>(&detail::bufferStorage) : nullptr;
+}
+
+}
+
+#endif
@@ -0,0 +1,322 @@
+#ifndef PNG_WRITER_HPP
+#define PNG_WRITER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+/**
+ * Writes PNGs for the decoder tests, with control over what png_decode.hpp
+ * has to handle: the filter on each row and the kind of deflate block
+ * (stored, fixed or dynamic Huffman) the data is split into. Matches are
+ * found only at a few fixed distances, which is enough to exercise every
+ * length and distance code path without a real compressor.
+ */
+namespace pngwriter {
+
+enum class Block { Stored, Fixed, Dynamic };
+
+namespace detail {
+
+// LSB-first, as deflate packs everything but Huffman codes.
+class BitWriter {
+public:
+    std::vector<uint8_t> bytes;
+
+    void put(uint32_t value, int n) {
+        for (int i = 0; i < n; ++i) {
+            if (count % 8 == 0)
+                bytes.push_back(0);
+            bytes.back() |= static_cast<uint8_t>(((value >> i) & 1) << (count % 8));
+            ++count;
+        }
+    }
+
+    /// Huffman codes go most significant bit first.
+    void putCode(uint32_t code, int length) {
+        for (int i = length - 1; i >= 0; --i)
+            put((code >> i) & 1, 1);
+    }
+
+    void alignToByte() { count = (count + 7) / 8 * 8; }
+
+private:
+    size_t count = 0;
+};
+
+// Canonical codes for a set of lengths, as RFC 1951 section 3.2.2 assigns them.
+inline std::vector<uint32_t> canonicalCodes(const std::vector<uint8_t> &lengths) {
+    int counts[16] = {};
+    for (uint8_t length : lengths)
+        ++counts[length];
+    counts[0] = 0;
+    uint32_t next[16] = {}, code = 0;
+    for (int length = 1; length < 16; ++length) {
+        code = (code + counts[length - 1]) << 1;
+        next[length] = code;
+    }
+    std::vector<uint32_t> codes(lengths.size());
+    for (size_t symbol = 0; symbol < lengths.size(); ++symbol)
+        if (lengths[symbol])
+            codes[symbol] = next[lengths[symbol]]++;
+    return codes;
+}
+
+struct Alphabet {
+    std::vector<uint8_t> lengths;
+    std::vector<uint32_t> codes;
+
+    explicit Alphabet(std::vector<uint8_t> l) : lengths(std::move(l)), codes(canonicalCodes(lengths)) {}
+
+    void put(BitWriter &out, int symbol) const { out.putCode(codes[symbol], lengths[symbol]); }
+};
+
+const uint16_t lengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t distanceBase[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                   193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint8_t distanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+inline Alphabet fixedLiterals() {
+    std::vector<uint8_t> lengths(288, 8);
+    std::fill(lengths.begin() + 144, lengths.begin() + 256, 9);
+    std::fill(lengths.begin() + 256, lengths.begin() + 280, 7);
+    return Alphabet(lengths);
+}
+
+// Complete codes over all 286 literal/length and 30 distance symbols, so
+// every symbol can be written.
+inline Alphabet dynamicLiterals() {
+    std::vector<uint8_t> lengths(286, 8);
+    std::fill(lengths.begin() + 226, lengths.end(), 9);
+    return Alphabet(lengths);
+}
+
+inline Alphabet dynamicDistances() {
+    std::vector<uint8_t> lengths(30, 5);
+    lengths[0] = lengths[1] = 4;
+    return Alphabet(lengths);
+}
+
+// Code lengths 0, 4, 5, 8, 9 and the repeat codes, 3 bits each.
+inline Alphabet codeLengthAlphabet() {
+    std::vector<uint8_t> lengths(19, 0);
+    for (int symbol : {0, 4, 5, 8, 9, 16, 17, 18})
+        lengths[symbol] = 3;
+    return Alphabet(lengths);
+}
+
+const uint8_t codeLengthOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+inline void putDynamicHeader(BitWriter &out, const Alphabet &literals, const Alphabet &distances) {
+    Alphabet codeLengths = codeLengthAlphabet();
+    out.put(uint32_t(literals.lengths.size() - 257), 5);
+    out.put(uint32_t(distances.lengths.size() - 1), 5);
+    out.put(19 - 4, 4);
+    for (uint8_t symbol : codeLengthOrder)
+        out.put(codeLengths.lengths[symbol], 3);
+
+    // Runs of a length as the length and then repeat code 16.
+    std::vector<uint8_t> all = literals.lengths;
+    all.insert(all.end(), distances.lengths.begin(), distances.lengths.end());
+    for (size_t i = 0; i < all.size();) {
+        size_t run = 1;
+        while (i + run < all.size() && all[i + run] == all[i])
+            ++run;
+        codeLengths.put(out, all[i]);
+        size_t left = run - 1;
+        while (left >= 3) {
+            size_t repeat = std::min<size_t>(left, 6);
+            codeLengths.put(out, 16);
+            out.put(uint32_t(repeat - 3), 2);
+            left -= repeat;
+        }
+        for (; left > 0; --left)
+            codeLengths.put(out, all[i]);
+        i += run;
+    }
+}
+
+// Literals, and matches at the given distances when they are 3 or more
+// bytes long.
+inline void putSymbols(BitWriter &out, const uint8_t *data, size_t begin, size_t end,
+                       const std::vector<size_t> &distances, const Alphabet &literals, const Alphabet &distanceCodes) {
+    for (size_t i = begin; i < end;) {
+        size_t bestLength = 0, bestDistance = 0;
+        for (size_t d : distances) {
+            if (d == 0 || d > i || d > 32768)
+                continue;
+            size_t length = 0;
+            while (length < 258 && i + length < end && data[i + length] == data[i + length - d])
+                ++length;
+            if (length > bestLength) {
+                bestLength = length;
+                bestDistance = d;
+            }
+        }
+        if (bestLength < 3) {
+            literals.put(out, data[i++]);
+            continue;
+        }
+        int s = 28;
+        while (lengthBase[s] > bestLength)
+            --s;
+        literals.put(out, 257 + s);
+        out.put(uint32_t(bestLength - lengthBase[s]), lengthExtra[s]);
+        int d = 29;
+        while (distanceBase[d] > bestDistance)
+            --d;
+        distanceCodes.put(out, d);
+        out.put(uint32_t(bestDistance - distanceBase[d]), distanceExtra[d]);
+        i += bestLength;
+    }
+    literals.put(out, 256);
+}
+
+inline uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0) {
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; ++k)
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+inline void putBigEndian32(std::vector<uint8_t> &out, uint32_t v) {
+    for (int shift = 24; shift >= 0; shift -= 8)
+        out.push_back(static_cast<uint8_t>(v >> shift));
+}
+
+inline void chunk(std::vector<uint8_t> &png, const char *type, const std::vector<uint8_t> &body) {
+    putBigEndian32(png, uint32_t(body.size()));
+    size_t start = png.size();
+    png.insert(png.end(), type, type + 4);
+    png.insert(png.end(), body.begin(), body.end());
+    putBigEndian32(png, crc32(&png[start], png.size() - start));
+}
+
+inline uint8_t paeth(int a, int b, int c) {
+    int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    return static_cast<uint8_t>(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+}
+
+}
+
+/**
+ * @brief A zlib stream of `data`, split into blocks of `blockSize` bytes
+ *        whose types cycle through `blocks`.
+ *
+ * @param matchDistances Where to look for repeats, e.g. 1 and the row length.
+ */
+inline std::vector<uint8_t> zlib(const std::vector<uint8_t> &data, const std::vector<Block> &blocks,
+                                 size_t blockSize, const std::vector<size_t> &matchDistances) {
+    detail::BitWriter out;
+    out.put(0x78, 8);
+    out.put(0x01, 8);
+    detail::Alphabet fixed = detail::fixedLiterals(), fixedDistances(std::vector<uint8_t>(30, 5));
+    detail::Alphabet literals = detail::dynamicLiterals(), distances = detail::dynamicDistances();
+    size_t index = 0;
+    for (size_t begin = 0; begin < data.size() || index == 0; begin += blockSize, ++index) {
+        size_t end = std::min(data.size(), begin + blockSize);
+        Block type = blocks[index % blocks.size()];
+        out.put(end == data.size(), 1);
+        if (type == Block::Stored) {
+            out.put(0, 2);
+            out.alignToByte();
+            uint32_t length = uint32_t(end - begin);
+            out.put(length, 16);
+            out.put(~length & 0xFFFF, 16);
+            for (size_t i = begin; i < end; ++i)
+                out.put(data[i], 8);
+        } else if (type == Block::Fixed) {
+            out.put(1, 2);
+            detail::putSymbols(out, data.data(), begin, end, matchDistances, fixed, fixedDistances);
+        } else {
+            out.put(2, 2);
+            detail::putDynamicHeader(out, literals, distances);
+            detail::putSymbols(out, data.data(), begin, end, matchDistances, literals, distances);
+        }
+        if (end == data.size())
+            break;
+    }
+    out.alignToByte();
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : data) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    std::vector<uint8_t> stream = out.bytes;
+    detail::putBigEndian32(stream, b << 16 | a);
+    return stream;
+}
+
+struct Image {
+    int width = 0, height = 0;
+    int colorType = 0;    // 0 grey, 2 RGB, 3 palette, 4 grey+alpha, 6 RGBA
+    int depth = 8;
+    std::vector<uint8_t> pixels;      // rows of samples, big-endian when 16-bit
+    std::vector<uint8_t> palette;     // RGB triples
+    std::vector<uint8_t> transparency; // the tRNS body, if any
+
+    int channels() const { return colorType == 0 || colorType == 3 ? 1 : colorType == 2 ? 3 : colorType == 4 ? 2 : 4; }
+    size_t rowBytes() const { return size_t(width) * channels() * (depth / 8); }
+};
+
+/**
+ * @brief Encodes `image` with row y filtered by filters[y % filters.size()]
+ *        and the zlib stream built as zlib() describes.
+ */
+inline std::vector<uint8_t> encode(const Image &image, const std::vector<int> &filters,
+                                   const std::vector<Block> &blocks, size_t blockSize = 4096) {
+    size_t rowBytes = image.rowBytes(), bpp = std::max<size_t>(1, size_t(image.channels()) * (image.depth / 8));
+    std::vector<uint8_t> filtered, zero(rowBytes, 0);
+    for (int y = 0; y < image.height; ++y) {
+        const uint8_t *c = &image.pixels[size_t(y) * rowBytes];
+        const uint8_t *p = y ? c - rowBytes : zero.data();
+        int filter = filters[y % filters.size()];
+        filtered.push_back(static_cast<uint8_t>(filter));
+        for (size_t i = 0; i < rowBytes; ++i) {
+            int a = i >= bpp ? c[i - bpp] : 0, b = p[i], d = i >= bpp ? p[i - bpp] : 0;
+            int predictor = filter == 1 ? a : filter == 2 ? b : filter == 3 ? (a + b) / 2 : filter == 4 ? detail::paeth(a, b, d) : 0;
+            filtered.push_back(static_cast<uint8_t>(c[i] - predictor));
+        }
+    }
+
+    std::vector<uint8_t> png = {137, 80, 78, 71, 13, 10, 26, 10}, header;
+    detail::putBigEndian32(header, uint32_t(image.width));
+    detail::putBigEndian32(header, uint32_t(image.height));
+    header.insert(header.end(), {uint8_t(image.depth), uint8_t(image.colorType), 0, 0, 0});
+    detail::chunk(png, "IHDR", header);
+    if (!image.palette.empty())
+        detail::chunk(png, "PLTE", image.palette);
+    if (!image.transparency.empty())
+        detail::chunk(png, "tRNS", image.transparency);
+    std::vector<uint8_t> stream = zlib(filtered, blocks, blockSize, {bpp, rowBytes + 1, rowBytes + 1 + bpp});
+    // Two IDAT chunks, since the decoder has to stitch them together.
+    size_t half = stream.size() / 2;
+    detail::chunk(png, "IDAT", std::vector<uint8_t>(stream.begin(), stream.begin() + half));
+    detail::chunk(png, "IDAT", std::vector<uint8_t>(stream.begin() + half, stream.end()));
+    detail::chunk(png, "IEND", {});
+    return png;
+}
+
+/// An 8-bit grey PNG with `stream` as its whole IDAT payload.
+inline std::vector<uint8_t> wrap(int width, int height, const std::vector<uint8_t> &stream) {
+    std::vector<uint8_t> png = {137, 80, 78, 71, 13, 10, 26, 10}, header;
+    detail::putBigEndian32(header, uint32_t(width));
+    detail::putBigEndian32(header, uint32_t(height));
+    header.insert(header.end(), {8, 0, 0, 0, 0});
+    detail::chunk(png, "IHDR", header);
+    detail::chunk(png, "IDAT", stream);
+    detail::chunk(png, "IEND", {});
+    return png;
+}
+
+}
+
+#endif
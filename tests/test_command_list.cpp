@@ -0,0 +1,121 @@
+// CommandList with GL stubbed out: every command must come back out of
+// execute() as the call it stands for, and the arena must be reused after
+// reset() rather than grow.
+#include "check.hpp"
+#include "gl_stub.hpp"
+#include "include/command_list.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using glstub::Call;
+
+std::vector<float> floats(const glm::mat4 *m, size_t count) {
+    return std::vector<float>(&m[0][0][0], &m[0][0][0] + 16 * count);
+}
+
+void testRoundTrip() {
+    glstub::install();
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+    glm::mat4 bones[3] = { glm::mat4(1.0f), glm::mat4(2.0f), model };
+    glm::vec4 colour(0.25f, 0.5f, 0.75f, 1.0f);
+
+    CommandList list;
+    list.useProgram(7);
+    list.bindVertexArray(3);
+    list.bindTexture(2, GL_TEXTURE_2D, 11);
+    list.setInt(4, -9);
+    list.setFloat(5, 0.125f);
+    list.setVec4(6, colour);
+    list.setMat4(8, model);
+    list.setMat4Array(9, bones, 3);
+    list.drawArrays(GL_TRIANGLES, 6, 36);
+    list.drawElements(GL_TRIANGLES, 120, GL_UNSIGNED_INT, 4096, 17);
+    list.drawElements(GL_LINES, 24, GL_UNSIGNED_SHORT, 0, 0, 50);
+    CHECK(list.commandCount() == 11);
+    CHECK(glstub::state.calls.empty());
+
+    std::vector<Call> expected = {
+        { "glUseProgram", { 7 }, {} },
+        { "glBindVertexArray", { 3 }, {} },
+        { "glActiveTexture", { GL_TEXTURE0 + 2 }, {} },
+        { "glBindTexture", { GL_TEXTURE_2D, 11 }, {} },
+        { "glUniform1i", { 4, -9 }, {} },
+        { "glUniform1f", { 5 }, { 0.125f } },
+        { "glUniform4fv", { 6, 1 }, { 0.25f, 0.5f, 0.75f, 1.0f } },
+        { "glUniformMatrix4fv", { 8, 1, GL_FALSE }, floats(&model, 1) },
+        { "glUniformMatrix4fv", { 9, 3, GL_FALSE }, floats(bones, 3) },
+        { "glDrawArrays", { GL_TRIANGLES, 6, 36 }, {} },
+        { "glDrawElementsBaseVertex", { GL_TRIANGLES, 120, GL_UNSIGNED_INT, 4096, 17 }, {} },
+        { "glDrawElementsInstancedBaseVertex", { GL_LINES, 24, GL_UNSIGNED_SHORT, 0, 50, 0 }, {} },
+    };
+    // The array was copied, so changing it afterwards changes nothing.
+    bones[0] = glm::mat4(5.0f);
+    list.execute();
+    CHECK(glstub::state.calls == expected);
+
+    // execute() leaves the list alone; it can run again.
+    glstub::state.calls.clear();
+    list.execute();
+    CHECK(glstub::state.calls == expected);
+
+    list.reset();
+    CHECK(list.empty());
+    glstub::state.calls.clear();
+    list.execute();
+    CHECK(glstub::state.calls.empty());
+}
+
+void testArenaReuse() {
+    CommandList list;
+    // A few frames of the same work: after reset() the same memory comes
+    // back, including the block made for an allocation bigger than a block.
+    std::vector<void *> first;
+    bool same = true, aligned = true;
+    for (int frame = 0; frame < 4; ++frame) {
+        std::vector<void *> pointers;
+        for (int i = 0; i < 200; ++i) {
+            size_t align = size_t(1) << (i % 5);
+            void *p = list.allocate(1 + i * 37 % 1000, align);
+            aligned &= reinterpret_cast<uintptr_t>(p) % align == 0;
+            pointers.push_back(p);
+        }
+        pointers.push_back(list.allocate(200 * 1024));
+        pointers.push_back(list.allocate(16));
+        if (frame == 0)
+            first = pointers;
+        else
+            same &= pointers == first;
+        list.reset();
+    }
+    CHECK(aligned);
+    CHECK(same);
+
+    // Allocations in one frame never overlap.
+    uint8_t *a = static_cast<uint8_t *>(list.allocate(100, 4));
+    uint8_t *b = static_cast<uint8_t *>(list.allocate(100, 4));
+    CHECK(a + 100 <= b || b + 100 <= a);
+}
+
+// Recording on one list and replaying from a moved-to one.
+void testMove() {
+    glstub::install();
+    CommandList list;
+    glm::mat4 m(3.0f);
+    list.setMat4Array(1, &m, 1);
+    CommandList moved = std::move(list);
+    moved.execute();
+    CHECK(glstub::state.calls.size() == 1 && glstub::state.calls[0].floats == floats(&m, 1));
+}
+
+}
+
+int main() {
+    testRoundTrip();
+    testArenaReuse();
+    testMove();
+    return check::result();
+}
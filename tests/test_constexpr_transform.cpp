@@ -0,0 +1,174 @@
+// The constexpr builders in constexpr_transform.hpp against the glm functions
+// they follow step for step.
+//
+// Builders without trigonometry must match glm bit for bit. rotate and
+// perspective must too whenever cx::sin/cos/tan and the C library agree on
+// the angle; where they don't (cx is correctly rounded, glibc's sinf/cosf
+// aren't always) they may differ by a couple of ulps; the bound is 2x the
+// worst measured.
+#include "check.hpp"
+#include "include/constexpr_transform.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+const int trials = 2000;
+const float trigUlps = 4.0f;
+
+bool same(const cx::Mat4 &a, const glm::mat4 &b) {
+    for (int c = 0; c < 4; ++c)
+        for (int r = 0; r < 4; ++r)
+            if (a[c][r] != b[c][r])
+                return false;
+    return true;
+}
+
+// Error in ulps of the largest element, as in test_mat4_accuracy.
+float errorUlps(const cx::Mat4 &a, const glm::mat4 &b) {
+    float largest = 0.0f, worst = 0.0f;
+    for (int c = 0; c < 4; ++c)
+        for (int r = 0; r < 4; ++r)
+            largest = std::max(largest, std::fabs(b[c][r]));
+    float unit = std::nextafter(largest, INFINITY) - largest;
+    for (int c = 0; c < 4; ++c)
+        for (int r = 0; r < 4; ++r)
+            worst = std::max(worst, std::fabs(a[c][r] - b[c][r]) / unit);
+    return worst;
+}
+
+cx::Vec3 toCx(const glm::vec3 &v) { return {v.x, v.y, v.z}; }
+
+cx::Mat4 toCx(const glm::mat4 &m) {
+    cx::Mat4 result = cx::identity();
+    for (int c = 0; c < 4; ++c)
+        for (int r = 0; r < 4; ++r)
+            result[c][r] = m[c][r];
+    return result;
+}
+
+std::mt19937 rng(5);
+
+float uniform(float low, float high) { return std::uniform_real_distribution<float>(low, high)(rng); }
+
+glm::vec3 randomVec3(float range) {
+    return glm::vec3(uniform(-range, range), uniform(-range, range), uniform(-range, range));
+}
+
+glm::mat4 randomMat4() {
+    glm::mat4 m;
+    for (int c = 0; c < 4; ++c)
+        for (int r = 0; r < 4; ++r)
+            m[c][r] = uniform(-4.0f, 4.0f);
+    return m;
+}
+
+// cx::sin and cx::cos round the double result once, so over a sweep they
+// must equal the double library rounded to float.
+void testTrig() {
+    bool rounded = true;
+    for (int i = 0; i < 200000; ++i) {
+        float x = uniform(-50.0f, 50.0f);
+        rounded &= cx::sin(x) == static_cast<float>(std::sin(double(x)));
+        rounded &= cx::cos(x) == static_cast<float>(std::cos(double(x)));
+    }
+    CHECK(rounded);
+}
+
+void testExactBuilders() {
+    bool translated = true, scaled = true, multiplied = true, looked = true, orthographic = true;
+    for (int i = 0; i < trials; ++i) {
+        glm::mat4 m = randomMat4(), n = randomMat4();
+        glm::vec3 v = randomVec3(10.0f);
+        translated &= same(cx::translate(toCx(m), toCx(v)), glm::translate(m, v));
+        scaled &= same(cx::scale(toCx(m), toCx(v)), glm::scale(m, v));
+        multiplied &= same(toCx(m) * toCx(n), m * n);
+
+        glm::vec3 eye = randomVec3(100.0f), center = randomVec3(100.0f), up = glm::normalize(randomVec3(1.0f));
+        looked &= same(cx::lookAt(toCx(eye), toCx(center), toCx(up)), glm::lookAt(eye, center, up));
+
+        float left = uniform(-100.0f, -1.0f), right = uniform(1.0f, 100.0f);
+        float bottom = uniform(-100.0f, -1.0f), top = uniform(1.0f, 100.0f);
+        float zNear = uniform(0.01f, 1.0f), zFar = uniform(10.0f, 1000.0f);
+        orthographic &= same(cx::ortho(left, right, bottom, top, zNear, zFar),
+                             glm::ortho(left, right, bottom, top, zNear, zFar));
+    }
+    CHECK(translated);
+    CHECK(scaled);
+    CHECK(multiplied);
+    CHECK(looked);
+    CHECK(orthographic);
+}
+
+void testTrigBuilders() {
+    int rotateExact = 0, rotateAgreeing = 0, perspectiveExact = 0, perspectiveAgreeing = 0;
+    float rotateWorst = 0.0f, perspectiveWorst = 0.0f;
+    for (int i = 0; i < trials; ++i) {
+        glm::mat4 m = randomMat4();
+        float angle = uniform(-7.0f, 7.0f);
+        glm::vec3 axis = randomVec3(1.0f);
+        cx::Mat4 rotated = cx::rotate(toCx(m), angle, toCx(axis));
+        glm::mat4 expected = glm::rotate(m, angle, axis);
+        bool exact = same(rotated, expected);
+        if (cx::sin(angle) == std::sin(angle) && cx::cos(angle) == std::cos(angle)) {
+            ++rotateAgreeing;
+            rotateExact += exact;
+        }
+        rotateWorst = std::max(rotateWorst, errorUlps(rotated, expected));
+
+        float fovy = uniform(0.1f, 3.0f), aspect = uniform(0.5f, 3.0f);
+        float zNear = uniform(0.01f, 1.0f), zFar = uniform(10.0f, 1000.0f);
+        cx::Mat4 projection = cx::perspective(fovy, aspect, zNear, zFar);
+        glm::mat4 expectedProjection = glm::perspective(fovy, aspect, zNear, zFar);
+        exact = same(projection, expectedProjection);
+        if (cx::tan(fovy / 2.0f) == std::tan(fovy / 2.0f)) {
+            ++perspectiveAgreeing;
+            perspectiveExact += exact;
+        }
+        perspectiveWorst = std::max(perspectiveWorst, errorUlps(projection, expectedProjection));
+    }
+    std::printf("rotate: %d/%d angles where sin/cos agree, max %g ulps overall\n", rotateAgreeing, trials,
+                rotateWorst);
+    std::printf("perspective: %d/%d angles where tan agrees, max %g ulps overall\n", perspectiveAgreeing, trials,
+                perspectiveWorst);
+    CHECK(rotateExact == rotateAgreeing);
+    CHECK(perspectiveExact == perspectiveAgreeing);
+    CHECK(rotateWorst <= trigUlps);
+    CHECK(perspectiveWorst <= trigUlps);
+}
+
+// A chain evaluated by the compiler, against glm at runtime.
+void testCompileTime() {
+    constexpr cx::Mat4 model =
+        cx::rotate(cx::scale(cx::translate(cx::identity(), {0.0f, 1.0f, -2.0f}), {2.0f, 2.0f, 2.0f}),
+                   cx::radians(30.0f), {0.0f, 1.0f, 0.0f});
+    constexpr cx::Mat4 view = cx::lookAt({3.0f, 2.0f, 6.0f}, {0.0f, 0.5f, 0.0f}, {0.0f, 1.0f, 0.0f});
+    constexpr cx::Mat4 projection = cx::perspective(cx::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    constexpr cx::Mat4 mvp = projection * view * model;
+
+    glm::mat4 glmModel = glm::rotate(glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, -2.0f)),
+                                                glm::vec3(2.0f)),
+                                     glm::radians(30.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 glmView = glm::lookAt(glm::vec3(3.0f, 2.0f, 6.0f), glm::vec3(0.0f, 0.5f, 0.0f),
+                                    glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 glmProjection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    CHECK(same(model, glmModel));
+    CHECK(same(view, glmView));
+    CHECK(same(projection, glmProjection));
+    CHECK(same(mvp, glmProjection * glmView * glmModel));
+    // The same builders called at runtime give the same bits.
+    CHECK(same(mvp, glm::mat4(cx::perspective(cx::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f) * view * model)));
+}
+
+}
+
+int main() {
+    testTrig();
+    testExactBuilders();
+    testTrigBuilders();
+    testCompileTime();
+    return check::result();
+}
@@ -0,0 +1,120 @@
+// DynamicBuffer with GL stubbed out, on both the persistent-mapping and the
+// map-per-upload paths: regions rotate, data lands where upload() says, full
+// regions are counted, and every fence is waited on once and deleted.
+#include "check.hpp"
+#include "gl_stub.hpp"
+#include "include/dynamic_buffer.hpp"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const glstub::Buffer &contents(const DynamicBuffer &ring) { return glstub::state.buffers[ring.ID]; }
+
+void testRotation(bool persistent) {
+    glstub::install();
+    GLVersion.major = persistent ? 4 : 3;
+    GLVersion.minor = persistent ? 4 : 3;
+    CHECK(DynamicBuffer::loadBufferStorage(&glstub::loadProc) == persistent);
+    {
+        // 1000 bytes round up to 1024 per region.
+        DynamicBuffer ring(GL_ARRAY_BUFFER, 1000, 3);
+        CHECK(ring.isPersistent() == persistent);
+        CHECK(contents(ring).data.size() == 3 * 1024);
+
+        bool placed = true, written = true, bounded = true;
+        for (int frame = 0; frame < 10; ++frame) {
+            ring.beginFrame();
+            size_t region = size_t(frame + 1) % 3;
+            uint8_t bytes[100];
+            std::memset(bytes, frame + 1, sizeof(bytes));
+            size_t a = ring.upload(bytes, 10, 1);
+            size_t b = ring.upload(bytes, 100, 64);
+            // Each frame writes from the start of the next region.
+            placed &= a == region * 1024 && b == region * 1024 + 64;
+            written &= contents(ring).data[b] == frame + 1 && contents(ring).data[b + 99] == frame + 1;
+            // GL 3.3 can't draw from a mapped buffer.
+            written &= contents(ring).mapped == persistent;
+            ring.endFrame();
+            // A fence per region in flight, never more.
+            bounded &= glstub::state.fences.size() <= 3;
+        }
+        CHECK(placed);
+        CHECK(written);
+        CHECK(bounded);
+        // Once every region has a fence, each beginFrame() waits once.
+        CHECK(glstub::state.waits == 10 - 3);
+        CHECK(ring.getStats().fenceWaits == 0);
+        // Persistent: mapped once. Otherwise one map per upload.
+        CHECK(contents(ring).maps == (persistent ? 1u : 20u));
+    }
+    CHECK(glstub::state.fences.empty());
+    CHECK(glstub::state.buffers.empty());
+    CHECK(glstub::state.badDeletes == 0);
+}
+
+void testOverflow() {
+    glstub::install();
+    GLVersion.major = 3;
+    DynamicBuffer::loadBufferStorage(&glstub::loadProc);
+    DynamicBuffer ring(GL_UNIFORM_BUFFER, 256, 2);
+    std::vector<uint8_t> data(300, 7);
+
+    ring.beginFrame();
+    CHECK(ring.remaining() == 256);
+    CHECK(ring.upload(data.data(), 300) == SIZE_MAX);
+    CHECK(ring.upload(data.data(), 200) != SIZE_MAX);
+    CHECK(ring.remaining() == 56);
+    // 56 bytes left but aligning to 256 would start past the end.
+    CHECK(ring.upload(data.data(), 8, 256) == SIZE_MAX);
+    CHECK(ring.upload(data.data(), 56, 8) != SIZE_MAX);
+    CHECK(ring.upload(data.data(), 1) == SIZE_MAX);
+    CHECK(ring.getStats().failedUploads == 3);
+    ring.endFrame();
+
+    // The next region starts empty again.
+    ring.beginFrame();
+    CHECK(ring.remaining() == 256);
+
+    // A failed map is an upload failure, not a crash.
+    glstub::state.failMaps = true;
+    CHECK(ring.upload(data.data(), 16) == SIZE_MAX);
+    glstub::state.failMaps = false;
+    ring.endFrame();
+}
+
+void testFences() {
+    glstub::install();
+    GLVersion.major = 3;
+    DynamicBuffer::loadBufferStorage(&glstub::loadProc);
+    {
+        DynamicBuffer ring(GL_ARRAY_BUFFER, 64, 2);
+        // endFrame() twice in a row replaces the fence rather than leaking it.
+        ring.beginFrame();
+        ring.endFrame();
+        ring.endFrame();
+        CHECK(glstub::state.fences.size() == 1);
+
+        // A GPU that's behind: the wait times out twice, then signals.
+        ring.beginFrame();
+        ring.endFrame();
+        glstub::state.timeoutsBeforeSignal = 2;
+        ring.beginFrame();
+        CHECK(ring.getStats().fenceWaits == 1);
+        CHECK(glstub::state.timeoutsBeforeSignal == 0);
+        ring.endFrame();
+    }
+    CHECK(glstub::state.fences.empty());
+    CHECK(glstub::state.badDeletes == 0);
+}
+
+}
+
+int main() {
+    testRotation(false);
+    testRotation(true);
+    testOverflow();
+    testFences();
+    return check::result();
+}
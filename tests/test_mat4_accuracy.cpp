@@ -0,0 +1,180 @@
+// The SIMD mat4 kernels (mat4_pair.hpp and batch_transform.hpp) against glm's
+// scalar func_matrix.inl path, in ULPs.
+//
+// Elements near zero come out of a sum of much larger terms, so an error is
+// counted in ULPs of the scale the element was computed at: the largest
+// element of the result for multiply and inverse, and the Hadamard bound (the
+// product of column lengths) for determinant. Transpose must be exact.
+//
+// Camera matrices (perspective * view) have badly conditioned inverses, and
+// there glm itself lands ~1000 ULPs from the correctly rounded answer. So
+// inverses are measured against one computed in double, and a kernel passes
+// if it is within inverseUlps of it or no further off than glm.
+#include "check.hpp"
+#include "include/batch_transform.hpp"
+#include "include/mat4_pair.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Roughly 2x the worst measured at any level on well-conditioned matrices.
+const float multiplyUlps = 4.0f;
+const float inverseUlps = 10.0f;
+const float determinantUlps = 6.0f;
+
+enum Kind { Camera, Skinning, General, KindCount };
+const char *kindNames[] = { "camera", "skinning", "general" };
+
+float ulp(float scale) {
+    scale = std::fabs(scale);
+    return std::nextafter(scale, INFINITY) - scale;
+}
+
+float largestElement(const glm::mat4 &m) {
+    float largest = 0.0f;
+    for (int c = 0; c < 4; ++c)
+        for (int r = 0; r < 4; ++r)
+            largest = std::max(largest, std::fabs(m[c][r]));
+    return largest;
+}
+
+float errorUlps(const glm::mat4 &value, const glm::mat4 &reference) {
+    float unit = ulp(largestElement(reference)), worst = 0.0f;
+    for (int c = 0; c < 4; ++c)
+        for (int r = 0; r < 4; ++r)
+            worst = std::max(worst, std::fabs(value[c][r] - reference[c][r]) / unit);
+    return worst;
+}
+
+// Matrix i is of Kind i % 3.
+std::vector<glm::mat4> testMatrices(size_t count) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f), scale(0.5f, 2.0f), offset(-100.0f, 100.0f);
+    std::vector<glm::mat4> matrices;
+    for (size_t i = 0; i < count; ++i) {
+        switch (i % KindCount) {
+        case Camera: {
+            glm::vec3 eye(offset(rng), offset(rng), offset(rng));
+            glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(unit(rng), unit(rng), 1.5f), glm::vec3(0, 1, 0));
+            matrices.push_back(glm::perspective(0.5f + scale(rng) * 0.5f, 16.0f / 9.0f, 0.1f, 1000.0f) * view);
+            break;
+        }
+        case Skinning: {
+            glm::quat rotation = glm::normalize(glm::quat(unit(rng), unit(rng), unit(rng), unit(rng)));
+            glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(offset(rng), offset(rng), offset(rng)));
+            matrices.push_back(glm::scale(m * glm::mat4_cast(rotation), glm::vec3(scale(rng), scale(rng), scale(rng))));
+            break;
+        }
+        default: {
+            glm::mat4 m(4.0f);
+            for (int c = 0; c < 4; ++c)
+                for (int r = 0; r < 4; ++r)
+                    m[c][r] += unit(rng);
+            matrices.push_back(m);
+        }
+        }
+    }
+    return matrices;
+}
+
+void testMultiply(const std::vector<glm::mat4> &a, const std::vector<glm::mat4> &b) {
+    size_t count = a.size();
+    std::vector<glm::mat4> pair(count), soa(count);
+    mat4pair::multiply(a.data(), b.data(), pair.data(), count);
+    batch::multiply(a.data(), b.data(), soa.data(), count);
+
+    float worstPair = 0.0f, worstSoa = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        glm::mat4 reference = a[i] * b[i];
+        worstPair = std::max(worstPair, errorUlps(pair[i], reference));
+        worstSoa = std::max(worstSoa, errorUlps(soa[i], reference));
+    }
+    std::printf("multiply:    mat4pair %.2f ulp, batch %.2f ulp\n", worstPair, worstSoa);
+    CHECK(worstPair <= multiplyUlps);
+    CHECK(worstSoa <= multiplyUlps);
+}
+
+glm::mat4 exactInverse(const glm::mat4 &m) {
+    return glm::mat4(glm::inverse(glm::dmat4(m)));
+}
+
+void testInverse(const std::vector<glm::mat4> &m) {
+    size_t count = m.size();
+    std::vector<glm::mat4> pair(count);
+    mat4pair::inverse(m.data(), pair.data(), count);
+    batch::Mat4Batch soa(m.data(), count);
+    batch::inverse(soa, soa);
+
+    float worstGlm[KindCount] = {}, worstPair[KindCount] = {}, worstSoa[KindCount] = {};
+    for (size_t i = 0; i < count; ++i) {
+        glm::mat4 reference = exactInverse(m[i]);
+        int kind = i % KindCount;
+        worstGlm[kind] = std::max(worstGlm[kind], errorUlps(glm::inverse(m[i]), reference));
+        worstPair[kind] = std::max(worstPair[kind], errorUlps(pair[i], reference));
+        worstSoa[kind] = std::max(worstSoa[kind], errorUlps(soa.get(i), reference));
+    }
+    for (int kind = 0; kind < KindCount; ++kind) {
+        std::printf("inverse:     %-8s glm %.2f ulp, mat4pair %.2f ulp, batch %.2f ulp\n", kindNames[kind],
+                    worstGlm[kind], worstPair[kind], worstSoa[kind]);
+        float bound = std::max(inverseUlps, worstGlm[kind]);
+        CHECK(worstPair[kind] <= bound);
+        CHECK(worstSoa[kind] <= bound);
+    }
+}
+
+void testTranspose(const std::vector<glm::mat4> &m) {
+    std::vector<glm::mat4> out(m.size());
+    mat4pair::transpose(m.data(), out.data(), m.size());
+    bool exact = true;
+    for (size_t i = 0; i < m.size(); ++i)
+        exact = exact && out[i] == glm::transpose(m[i]);
+    CHECK(exact);
+}
+
+void testDeterminant(const std::vector<glm::mat4> &m) {
+    std::vector<float> out(m.size());
+    mat4pair::determinant(m.data(), out.data(), m.size());
+    float worst = 0.0f;
+    for (size_t i = 0; i < m.size(); ++i) {
+        float hadamard = 1.0f;
+        for (int c = 0; c < 4; ++c)
+            hadamard *= glm::length(m[i][c]);
+        worst = std::max(worst, std::fabs(out[i] - glm::determinant(m[i])) / ulp(hadamard));
+    }
+    std::printf("determinant: mat4pair %.2f ulp\n", worst);
+    CHECK(worst <= determinantUlps);
+}
+
+// Odd counts exercise the single-matrix tail, and out aliasing the input is
+// documented as allowed. Skinning matrices only, so one bound fits.
+void testAliasingAndTails() {
+    std::vector<glm::mat4> all = testMatrices(21), m, expected;
+    for (size_t i = Skinning; i < all.size(); i += KindCount) {
+        m.push_back(all[i]);
+        expected.push_back(exactInverse(all[i]));
+    }
+    mat4pair::inverse(m.data(), m.data(), m.size());
+    float worst = 0.0f;
+    for (size_t i = 0; i < m.size(); ++i)
+        worst = std::max(worst, errorUlps(m[i], expected[i]));
+    CHECK(worst <= inverseUlps);
+}
+
+}
+
+int main() {
+    std::printf("SIMD level: %s\n", simd::levelName(simd::runtimeLevel()));
+    std::vector<glm::mat4> a = testMatrices(3001), b = testMatrices(3001);
+    std::reverse(b.begin(), b.end());
+    testMultiply(a, b);
+    testInverse(a);
+    testTranspose(a);
+    testDeterminant(a);
+    testAliasingAndTails();
+    return check::result();
+}
@@ -0,0 +1,162 @@
+// meshopt passes: they must draw exactly the same triangles, and the vertex
+// cache pass must actually help.
+#include "check.hpp"
+#include "include/mesh_optimize.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct Mesh {
+    std::vector<float> positions; // xyz
+    std::vector<uint32_t> indices;
+
+    size_t vertexCount() const { return positions.size() / 3; }
+};
+
+// side x side quads, two triangles each.
+Mesh grid(uint32_t side) {
+    Mesh mesh;
+    for (uint32_t y = 0; y <= side; ++y)
+        for (uint32_t x = 0; x <= side; ++x)
+            mesh.positions.insert(mesh.positions.end(), { float(x), float(y), 0.0f });
+    for (uint32_t y = 0; y < side; ++y) {
+        for (uint32_t x = 0; x < side; ++x) {
+            uint32_t v = y * (side + 1) + x;
+            mesh.indices.insert(mesh.indices.end(), { v, v + 1, v + side + 1, v + 1, v + side + 2, v + side + 1 });
+        }
+    }
+    return mesh;
+}
+
+// A closed UV sphere, so optimizeOverdraw has faces pointing every way.
+Mesh sphere(uint32_t rings, uint32_t segments) {
+    Mesh mesh;
+    for (uint32_t r = 0; r <= rings; ++r) {
+        float theta = 3.14159265f * r / rings;
+        for (uint32_t s = 0; s <= segments; ++s) {
+            float phi = 6.2831853f * s / segments;
+            mesh.positions.insert(mesh.positions.end(),
+                                  { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) });
+        }
+    }
+    for (uint32_t r = 0; r < rings; ++r) {
+        for (uint32_t s = 0; s < segments; ++s) {
+            uint32_t v = r * (segments + 1) + s;
+            mesh.indices.insert(mesh.indices.end(), { v, v + segments + 1, v + 1, v + 1, v + segments + 1, v + segments + 2 });
+        }
+    }
+    return mesh;
+}
+
+void shuffleTriangles(std::vector<uint32_t> &indices) {
+    std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+    for (size_t t = 0; t < triangles.size(); ++t)
+        triangles[t] = { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2] };
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(9));
+    for (size_t t = 0; t < triangles.size(); ++t)
+        std::copy(triangles[t].begin(), triangles[t].end(), indices.begin() + t * 3);
+}
+
+// Each triangle rotated to start at its smallest index, which keeps the
+// winding, then sorted.
+std::vector<std::array<uint32_t, 3>> triangleSet(const std::vector<uint32_t> &indices) {
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        std::array<uint32_t, 3> t = { indices[i], indices[i + 1], indices[i + 2] };
+        std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+        triangles.push_back(t);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+void testCacheImproves() {
+    Mesh mesh = grid(64);
+    shuffleTriangles(mesh.indices);
+    auto expected = triangleSet(mesh.indices);
+    float before = meshopt::analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount()).acmr;
+
+    meshopt::optimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount());
+    float cache = meshopt::analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount()).acmr;
+    CHECK(triangleSet(mesh.indices) == expected);
+
+    meshopt::optimizeOverdraw(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.vertexCount(), 3);
+    float overdraw = meshopt::analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount()).acmr;
+    CHECK(triangleSet(mesh.indices) == expected);
+
+    std::printf("shuffled grid ACMR: %.3f, after optimizeVertexCache %.3f, after optimizeOverdraw %.3f\n", before,
+                cache, overdraw);
+    // The header quotes 0.5-0.7 as good for a grid.
+    CHECK(cache < before);
+    CHECK(cache <= 0.75f);
+    CHECK(overdraw <= cache * 1.1f);
+}
+
+void testSphereKeepsTriangles() {
+    Mesh mesh = sphere(24, 48);
+    shuffleTriangles(mesh.indices);
+    auto expected = triangleSet(mesh.indices);
+    meshopt::optimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount());
+    CHECK(triangleSet(mesh.indices) == expected);
+    meshopt::optimizeOverdraw(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.vertexCount(), 3);
+    CHECK(triangleSet(mesh.indices) == expected);
+}
+
+struct Vertex {
+    float position[3];
+    uint32_t id;
+};
+
+void testFetchKeepsReferencedVertices() {
+    Mesh mesh = grid(16);
+    shuffleTriangles(mesh.indices);
+    std::vector<Vertex> vertices;
+    for (size_t v = 0; v < mesh.vertexCount(); ++v)
+        vertices.push_back({ { mesh.positions[v * 3], mesh.positions[v * 3 + 1], mesh.positions[v * 3 + 2] },
+                             uint32_t(v) });
+    // Unreferenced vertices, which should be dropped.
+    for (uint32_t extra = 0; extra < 10; ++extra)
+        vertices.push_back({ { -1.0f, -1.0f, -1.0f }, uint32_t(vertices.size()) });
+
+    std::vector<uint32_t> indices = mesh.indices;
+    std::vector<Vertex> fetched(vertices.size());
+    size_t count = meshopt::optimizeVertexFetch(fetched.data(), indices.data(), indices.size(), vertices.data(),
+                                                vertices.size(), sizeof(Vertex));
+    CHECK(count == mesh.vertexCount());
+
+    // Every corner still reaches the same vertex, and first uses come in
+    // order.
+    bool same = true, firstUseOrder = true;
+    uint32_t next = 0;
+    for (size_t i = 0; i < indices.size(); ++i) {
+        same = same && indices[i] < count && fetched[indices[i]].id == mesh.indices[i];
+        if (indices[i] == next)
+            ++next;
+        else
+            firstUseOrder = firstUseOrder && indices[i] < next;
+    }
+    CHECK(same);
+    CHECK(firstUseOrder);
+}
+
+void testEmpty() {
+    std::vector<uint32_t> none;
+    meshopt::optimizeVertexCache(none.data(), 0, 0);
+    meshopt::optimizeOverdraw(none.data(), 0, nullptr, 0, 3);
+    CHECK(meshopt::optimizeVertexFetch(nullptr, none.data(), 0, nullptr, 0, 12) == 0);
+}
+
+}
+
+int main() {
+    testCacheImproves();
+    testSphereKeepsTriangles();
+    testFetchKeepsReferencedVertices();
+    testEmpty();
+    return check::result();
+}
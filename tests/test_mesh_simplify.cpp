@@ -0,0 +1,303 @@
+// meshopt::simplify: the result must only use input vertices, keep every
+// triangle facing the way it did, keep borders and UV seams where they were,
+// and report its error honestly; meshfile::selectLod must pick coarser LODs
+// only as an object gets smaller on screen.
+#include "check.hpp"
+#include "include/mesh_format.hpp"
+#include "include/mesh_simplify.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// xyz and uv, so wedges on a seam differ.
+struct Mesh {
+    static constexpr int stride = 5;
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+
+    size_t vertexCount() const { return vertices.size() / stride; }
+    glm::vec3 position(uint32_t v) const { return glm::vec3(vertices[v * stride], vertices[v * stride + 1], vertices[v * stride + 2]); }
+    glm::vec2 uv(uint32_t v) const { return glm::vec2(vertices[v * stride + 3], vertices[v * stride + 4]); }
+    float u(uint32_t v) const { return vertices[v * stride + 3]; }
+};
+
+// A wavy side x side grid in the xy plane: open, so every edge of the
+// square is a border.
+Mesh grid(uint32_t side) {
+    Mesh mesh;
+    for (uint32_t y = 0; y <= side; ++y)
+        for (uint32_t x = 0; x <= side; ++x)
+            mesh.vertices.insert(mesh.vertices.end(),
+                                 { float(x), float(y), 0.3f * std::sin(x * 0.4f) * std::cos(y * 0.3f), float(x) / side,
+                                   float(y) / side });
+    for (uint32_t y = 0; y < side; ++y) {
+        for (uint32_t x = 0; x < side; ++x) {
+            uint32_t v = y * (side + 1) + x;
+            mesh.indices.insert(mesh.indices.end(), { v, v + 1, v + side + 1, v + 1, v + side + 2, v + side + 1 });
+        }
+    }
+    return mesh;
+}
+
+// A closed UV sphere with one vertex per pole and the column at u = 0
+// duplicated at u = 1, which makes a seam down one side.
+Mesh sphere(uint32_t rings, uint32_t segments) {
+    Mesh mesh;
+    mesh.vertices.insert(mesh.vertices.end(), { 0.0f, 1.0f, 0.0f, 0.5f, 0.0f });
+    for (uint32_t r = 1; r < rings; ++r) {
+        float theta = 3.14159265f * r / rings;
+        for (uint32_t s = 0; s <= segments; ++s) {
+            float phi = 6.2831853f * (s % segments) / segments;
+            mesh.vertices.insert(mesh.vertices.end(), { std::sin(theta) * std::cos(phi), std::cos(theta),
+                                                        std::sin(theta) * std::sin(phi), float(s) / segments, float(r) / rings });
+        }
+    }
+    uint32_t south = uint32_t(mesh.vertexCount());
+    mesh.vertices.insert(mesh.vertices.end(), { 0.0f, -1.0f, 0.0f, 0.5f, 1.0f });
+
+    auto ring = [&](uint32_t r, uint32_t s) { return 1 + (r - 1) * (segments + 1) + s; };
+    for (uint32_t s = 0; s < segments; ++s) {
+        mesh.indices.insert(mesh.indices.end(), { 0, ring(1, s + 1), ring(1, s) });
+        mesh.indices.insert(mesh.indices.end(), { south, ring(rings - 1, s), ring(rings - 1, s + 1) });
+    }
+    for (uint32_t r = 1; r + 1 < rings; ++r) {
+        for (uint32_t s = 0; s < segments; ++s) {
+            uint32_t a = ring(r, s), b = ring(r, s + 1), c = ring(r + 1, s), d = ring(r + 1, s + 1);
+            mesh.indices.insert(mesh.indices.end(), { a, b, c, b, d, c });
+        }
+    }
+    return mesh;
+}
+
+// A cube with its own 4 vertices per face, as flat shading needs.
+Mesh flatCube() {
+    Mesh mesh;
+    for (int axis = 0; axis < 3; ++axis) {
+        for (float sign : { -1.0f, 1.0f }) {
+            uint32_t base = uint32_t(mesh.vertexCount());
+            for (int corner = 0; corner < 4; ++corner) {
+                glm::vec3 p;
+                p[axis] = sign;
+                p[(axis + 1) % 3] = (corner & 1) ? 1.0f : -1.0f;
+                p[(axis + 2) % 3] = (corner & 2) ? 1.0f : -1.0f;
+                mesh.vertices.insert(mesh.vertices.end(), { p.x, p.y, p.z, float(corner & 1), float(corner >> 1) });
+            }
+            if (sign > 0)
+                mesh.indices.insert(mesh.indices.end(), { base, base + 1, base + 3, base, base + 3, base + 2 });
+            else
+                mesh.indices.insert(mesh.indices.end(), { base, base + 3, base + 1, base, base + 2, base + 3 });
+        }
+    }
+    return mesh;
+}
+
+glm::vec3 normal(const Mesh &mesh, const uint32_t *t) {
+    return glm::cross(mesh.position(t[1]) - mesh.position(t[0]), mesh.position(t[2]) - mesh.position(t[0]));
+}
+
+std::vector<uint32_t> simplify(const Mesh &mesh, size_t target, float targetError = FLT_MAX, float *error = nullptr,
+                               size_t *locked = nullptr) {
+    std::vector<uint32_t> out(mesh.indices.size());
+    size_t count = meshopt::simplify(out.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(),
+                                     mesh.vertexCount(), Mesh::stride, target, targetError, error, locked);
+    out.resize(count);
+    return out;
+}
+
+bool onlyInputVertices(const Mesh &mesh, const std::vector<uint32_t> &indices) {
+    std::set<uint32_t> used(mesh.indices.begin(), mesh.indices.end());
+    return indices.size() % 3 == 0
+        && std::all_of(indices.begin(), indices.end(), [&](uint32_t v) { return used.count(v) != 0; });
+}
+
+// Edges of the result with no triangle on the other side, by position.
+std::vector<std::pair<glm::vec3, glm::vec3>> openEdges(const Mesh &mesh, const std::vector<uint32_t> &indices) {
+    auto key = [](const glm::vec3 &p) { return std::make_tuple(p.x, p.y, p.z); };
+    std::multiset<std::pair<std::tuple<float, float, float>, std::tuple<float, float, float>>> halfEdges;
+    for (size_t i = 0; i < indices.size(); i += 3)
+        for (int e = 0; e < 3; ++e)
+            halfEdges.insert({ key(mesh.position(indices[i + e])), key(mesh.position(indices[i + (e + 1) % 3])) });
+    std::vector<std::pair<glm::vec3, glm::vec3>> open;
+    for (size_t i = 0; i < indices.size(); i += 3)
+        for (int e = 0; e < 3; ++e) {
+            glm::vec3 a = mesh.position(indices[i + e]), b = mesh.position(indices[i + (e + 1) % 3]);
+            if (!halfEdges.count({ key(b), key(a) }))
+                open.push_back({ a, b });
+        }
+    return open;
+}
+
+void testGridBorders() {
+    const uint32_t side = 32;
+    Mesh mesh = grid(side);
+    std::vector<uint32_t> result = simplify(mesh, mesh.indices.size() / 8);
+    CHECK(result.size() < mesh.indices.size() / 2);
+    CHECK(onlyInputVertices(mesh, result));
+
+    // No flips: the grid faces +z everywhere, gently enough that every
+    // triangle must keep doing so.
+    bool facesUp = true;
+    for (size_t i = 0; i < result.size(); i += 3)
+        facesUp &= normal(mesh, &result[i]).z > 0.0f;
+    CHECK(facesUp);
+
+    // Each open edge runs along one side of the square, so the outline
+    // hasn't moved, and together they still go all the way round.
+    bool onSide = true;
+    float length = 0.0f;
+    for (const auto &edge : openEdges(mesh, result)) {
+        glm::vec3 a = edge.first, b = edge.second;
+        onSide &= (a.x == b.x && (a.x == 0.0f || a.x == side)) || (a.y == b.y && (a.y == 0.0f || a.y == side));
+        length += glm::length(glm::vec2(b - a));
+    }
+    CHECK(onSide);
+    CHECK(std::abs(length - 4.0f * side) < 1e-3f);
+}
+
+void testSphereSeam() {
+    const uint32_t segments = 32;
+    Mesh mesh = sphere(16, segments);
+    CHECK(openEdges(mesh, mesh.indices).empty());
+    std::vector<uint32_t> result = simplify(mesh, mesh.indices.size() / 10);
+    CHECK(result.size() < mesh.indices.size() / 4);
+    CHECK(onlyInputVertices(mesh, result));
+
+    // No flips: every triangle still faces away from the centre.
+    bool outward = true;
+    for (size_t i = 0; i < result.size(); i += 3) {
+        glm::vec3 centre = (mesh.position(result[i]) + mesh.position(result[i + 1]) + mesh.position(result[i + 2])) / 3.0f;
+        outward &= glm::dot(normal(mesh, &result[i]), centre) > 0.0f;
+    }
+    CHECK(outward);
+
+    // The seam stays closed: both sides moved together, so welded by
+    // position there are no holes.
+    CHECK(openEdges(mesh, result).empty());
+
+    // And each side kept its own wedges. Every input triangle winds the same
+    // way in uv as on the sphere; one that picked up the wedge from the other
+    // side of the seam would be mirrored in uv. The poles have one u for all
+    // their triangles, so those are left out.
+    bool sameSide = true;
+    for (size_t i = 0; i < result.size(); i += 3) {
+        const uint32_t *t = &result[i];
+        if (std::any_of(t, t + 3, [&](uint32_t v) { return v == 0 || v == mesh.vertexCount() - 1; }))
+            continue;
+        glm::vec2 a = mesh.uv(t[1]) - mesh.uv(t[0]), b = mesh.uv(t[2]) - mesh.uv(t[0]);
+        sameSide &= a.x * b.y - a.y * b.x > 0.0f;
+    }
+    CHECK(sameSide);
+
+    // Vertices on the seam stay on it: the plane z = 0, x > 0.
+    bool onSeam = true;
+    for (uint32_t v : result)
+        if (mesh.u(v) == 0.0f || mesh.u(v) == 1.0f)
+            onSeam &= mesh.position(v).z == 0.0f && mesh.position(v).x > 0.0f;
+    CHECK(onSeam);
+}
+
+void testErrors() {
+    Mesh mesh = sphere(24, 48);
+
+    // From the same input, asking for fewer triangles never costs less.
+    float previous = 0.0f;
+    bool growing = true;
+    size_t lastCount = mesh.indices.size();
+    for (size_t target = mesh.indices.size() / 2; target >= 60; target /= 2) {
+        float error = -1.0f;
+        std::vector<uint32_t> result = simplify(mesh, target, FLT_MAX, &error);
+        growing &= error >= previous && result.size() <= lastCount;
+        previous = error;
+        lastCount = result.size();
+    }
+    CHECK(growing);
+    CHECK(previous > 0.0f);
+
+    // No collapse at all reports 0.
+    float error = -1.0f;
+    simplify(mesh, mesh.indices.size(), FLT_MAX, &error);
+    CHECK(error == 0.0f);
+
+    // A target error caps the error and stops short of the index target;
+    // a looser one allows fewer triangles.
+    size_t lastSize = mesh.indices.size() + 1;
+    bool capped = true, fewer = true;
+    for (float limit : { 0.001f, 0.01f, 0.05f, 0.2f }) {
+        std::vector<uint32_t> result = simplify(mesh, 0, limit, &error);
+        capped &= error <= limit;
+        fewer &= result.size() < lastSize;
+        lastSize = result.size();
+    }
+    CHECK(capped);
+    CHECK(fewer);
+}
+
+void testFlatCubeIsLocked() {
+    Mesh mesh = flatCube();
+    CHECK(openEdges(mesh, mesh.indices).empty());
+    size_t locked = 0;
+    float error = -1.0f;
+    std::vector<uint32_t> result = simplify(mesh, 6, FLT_MAX, &error, &locked);
+    // Every corner is where three seams meet, so nothing can move.
+    CHECK(result.size() == mesh.indices.size());
+    CHECK(locked == mesh.vertexCount());
+    CHECK(error == 0.0f);
+
+    // The smooth sphere has no locked vertices at all.
+    Mesh smooth = sphere(8, 16);
+    simplify(smooth, 60, FLT_MAX, nullptr, &locked);
+    CHECK(locked == 0);
+}
+
+void testSelectLod() {
+    const meshfile::LodRecord lods[] = {
+        { 0, 3000, 0.0f, 0 }, { 3000, 1500, 0.002f, 0 }, { 4500, 700, 0.01f, 0 }, { 5200, 300, 0.05f, 0 },
+    };
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    auto select = [&](glm::vec3 position) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+        return meshfile::selectLod(lods, 4, projection * view * model, glm::vec3(0.0f), 1.0f, 1080.0f);
+    };
+
+    // Behind the camera, or around it: full detail.
+    CHECK(select(glm::vec3(0.0f, 0.0f, 10.0f)) == 0);
+    CHECK(select(glm::vec3(0.0f, 0.0f, -0.5f)) == 0);
+    CHECK(select(glm::vec3(0.0f, 0.0f, -2.0f)) == 0);
+
+    // Further away: never finer, and eventually the coarsest.
+    size_t previous = 0;
+    bool coarser = true;
+    for (float distance = 2.0f; distance < 2000.0f; distance *= 1.5f) {
+        size_t level = select(glm::vec3(0.0f, 0.0f, -distance));
+        coarser &= level >= previous;
+        previous = level;
+    }
+    CHECK(coarser);
+    CHECK(previous == 3);
+    CHECK(select(glm::vec3(0.0f, 0.0f, -1000.0f)) > select(glm::vec3(0.0f, 0.0f, -10.0f)));
+
+    // Off to the side at the same depth counts the same.
+    CHECK(select(glm::vec3(5.0f, 0.0f, -100.0f)) == select(glm::vec3(0.0f, 0.0f, -100.0f)));
+
+    // A single LOD is all there is.
+    CHECK(meshfile::selectLod(lods, 1, projection * view, glm::vec3(0.0f, 0.0f, -1e6f), 1.0f, 1080.0f) == 0);
+}
+
+}
+
+int main() {
+    testGridBorders();
+    testSphereSeam();
+    testErrors();
+    testFlatCubeIsLocked();
+    testSelectLod();
+    return check::result();
+}
@@ -0,0 +1,145 @@
+// The batch noise in noise.hpp against glm::perlin and glm::simplex, which it
+// transcribes. Every path runs glm's operations in glm's order, so at every
+// SIMD level the results must match exactly. The fBm sum uses fmadd, which
+// stays exact with the default gain of 0.5.
+#include "check.hpp"
+#include "include/noise.hpp"
+#include <glm/gtc/noise.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Not a multiple of any SIMD width, so the scalar tail runs too.
+const size_t count = 4099;
+
+struct Points {
+    std::vector<float> x, y, z;
+};
+
+// Random points either side of zero, plus whole and half lattice points,
+// where the gradients meet.
+Points testPoints() {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> coordinate(-60.0f, 60.0f);
+    Points p;
+    for (size_t i = 0; i < count; ++i) {
+        float x = coordinate(rng), y = coordinate(rng), z = coordinate(rng);
+        if (i % 7 == 0) {
+            x = std::floor(x);
+            y = std::floor(y) + 0.5f;
+            z = std::floor(z);
+        }
+        p.x.push_back(x);
+        p.y.push_back(y);
+        p.z.push_back(z);
+    }
+    return p;
+}
+
+// glm's fBm, written out the way Fbm documents it.
+float reference(const noise::Fbm &fbm, float x, float y, const float *z) {
+    float sum = 0.0f, totalWeight = 0.0f, frequency = 1.0f, amplitude = 1.0f;
+    for (int o = 0; o < std::max(fbm.octaves, 1); ++o) {
+        float n;
+        if (z) {
+            glm::vec3 p = glm::vec3(x, y, *z) * frequency;
+            n = fbm.basis == noise::Basis::Perlin ? glm::perlin(p) : glm::simplex(p);
+        } else {
+            glm::vec2 p = glm::vec2(x, y) * frequency;
+            n = fbm.basis == noise::Basis::Perlin ? glm::perlin(p) : glm::simplex(p);
+        }
+        sum += n * amplitude;
+        totalWeight += amplitude;
+        frequency *= fbm.lacunarity;
+        amplitude *= fbm.gain;
+    }
+    return sum * (1.0f / totalWeight);
+}
+
+float worstError(const noise::Fbm &fbm, const Points &p, bool volume) {
+    std::vector<float> out(count);
+    noise::sample(fbm, p.x.data(), p.y.data(), volume ? p.z.data() : nullptr, out.data(), count);
+    float worst = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        float error = std::fabs(out[i] - reference(fbm, p.x[i], p.y[i], volume ? &p.z[i] : nullptr));
+        // NaN must fail, not slip past a comparison.
+        worst = std::isnan(error) ? INFINITY : std::max(worst, error);
+    }
+    return worst;
+}
+
+void testAgainstGlm() {
+    Points p = testPoints();
+    const char *basisNames[] = { "perlin", "simplex" };
+    for (noise::Basis basis : { noise::Basis::Perlin, noise::Basis::Simplex }) {
+        for (bool volume : { false, true }) {
+            // One octave is the plain glm function; four add the fBm sum.
+            for (int octaves : { 1, 4 }) {
+                noise::Fbm fbm;
+                fbm.basis = basis;
+                fbm.octaves = octaves;
+                float worst = worstError(fbm, p, volume);
+                std::printf("%-8s %dD, %d octave(s): max error %g\n", basisNames[static_cast<int>(basis)],
+                            volume ? 3 : 2, octaves, worst);
+                CHECK(worst == 0.0f);
+            }
+        }
+    }
+}
+
+// Zero or negative octaves used to divide zero by zero.
+void testOctaveClamp() {
+    Points p = testPoints();
+    std::vector<float> one(count), none(count), negative(count);
+    noise::Fbm fbm;
+    noise::sample(fbm, p.x.data(), p.y.data(), nullptr, one.data(), count);
+    fbm.octaves = 0;
+    noise::sample(fbm, p.x.data(), p.y.data(), nullptr, none.data(), count);
+    fbm.octaves = -3;
+    noise::sample(fbm, p.x.data(), p.y.data(), nullptr, negative.data(), count);
+    CHECK(none == one);
+    CHECK(negative == one);
+}
+
+// Bands of rows on a pool give the same pixels as one thread.
+void testFill() {
+    noise::Grid grid;
+    grid.width = 67;
+    grid.height = 45;
+    grid.origin = glm::vec2(-3.0f, 5.0f);
+    grid.volume = true;
+    grid.z = 1.25f;
+    noise::Fbm fbm;
+    fbm.basis = noise::Basis::Simplex;
+    fbm.octaves = 3;
+
+    size_t pixels = size_t(grid.width) * grid.height;
+    std::vector<float> serial(pixels), pooled(pixels);
+    noise::fill(grid, fbm, serial.data(), nullptr);
+    JobPool pool(3);
+    noise::fill(grid, fbm, pooled.data(), &pool);
+    CHECK(serial == pooled);
+
+    // Pixel (i, j) is the noise at origin + (i, j) * step.
+    bool placed = true;
+    for (int j = 0; j < grid.height; j += 11)
+        for (int i = 0; i < grid.width; i += 13) {
+            float x = grid.origin.x + i * grid.step.x, y = grid.origin.y + j * grid.step.y;
+            placed &= serial[j * grid.width + i] == reference(fbm, x, y, &grid.z);
+        }
+    CHECK(placed);
+}
+
+}
+
+int main() {
+    std::printf("SIMD level: %s\n", simd::levelName(simd::runtimeLevel()));
+    testAgainstGlm();
+    testOctaveClamp();
+    testFill();
+    return check::result();
+}
@@ -0,0 +1,225 @@
+// png::Decoder against stb_image on generated PNGs: every colour type and
+// depth it handles, every row filter, stored, fixed and dynamic deflate
+// blocks, and broken files, which must fail cleanly rather than crash.
+#define STB_IMAGE_IMPLEMENTATION
+#include "include/stb_image.h"
+#include "check.hpp"
+#include "png_writer.hpp"
+#include "include/png_decode.hpp"
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+using pngwriter::Block;
+
+// Noise with repeated runs and rows, so the writer finds matches of many
+// lengths and distances.
+std::vector<uint8_t> pixels(size_t size, size_t rowBytes, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> out(size);
+    for (size_t i = 0; i < size;) {
+        uint32_t kind = rng() % 4;
+        size_t run = 1 + rng() % 40;
+        for (size_t k = 0; k < run && i < size; ++k, ++i) {
+            if (kind == 0 && i >= rowBytes)
+                out[i] = out[i - rowBytes];
+            else if (kind == 1 && i > 0)
+                out[i] = out[i - 1];
+            else
+                out[i] = static_cast<uint8_t>(rng());
+        }
+    }
+    return out;
+}
+
+// Decodes every row and compares them with stb's whole image, converted to
+// the same channel count.
+bool matchesStb(const std::vector<uint8_t> &file) {
+    png::Decoder decoder(file.data(), file.size());
+    if (!decoder.supported())
+        return false;
+    int w, h, comp;
+    size_t sampleBytes = size_t(decoder.bytesPerSample());
+    void *expected = sampleBytes == 2
+        ? static_cast<void *>(stbi_load_16_from_memory(file.data(), int(file.size()), &w, &h, &comp, decoder.channels()))
+        : static_cast<void *>(stbi_load_from_memory(file.data(), int(file.size()), &w, &h, &comp, decoder.channels()));
+    if (!expected)
+        return false;
+    bool same = w == decoder.width() && h == decoder.height();
+    size_t rowBytes = size_t(w) * decoder.channels() * sampleBytes;
+    for (int y = 0; same && y < h; ++y) {
+        const void *row = decoder.nextRow();
+        same = row && std::memcmp(row, static_cast<const uint8_t *>(expected) + y * rowBytes, rowBytes) == 0;
+    }
+    stbi_image_free(expected);
+    return same && decoder.nextRow() == nullptr && decoder.supported();
+}
+
+pngwriter::Image image(int width, int height, int colorType, int depth, uint32_t seed) {
+    pngwriter::Image image;
+    image.width = width;
+    image.height = height;
+    image.colorType = colorType;
+    image.depth = depth;
+    image.pixels = pixels(image.rowBytes() * height, image.rowBytes(), seed);
+    if (colorType == 3) {
+        image.palette = pixels(256 * 3, 3, seed + 1);
+        for (uint8_t &index : image.pixels)
+            index = static_cast<uint8_t>(index % 200);
+    }
+    return image;
+}
+
+void testFormatsAndFilters() {
+    const std::vector<int> allFilters = {0, 1, 2, 3, 4};
+    const std::vector<Block> mixed = {Block::Dynamic, Block::Stored, Block::Fixed};
+    for (int colorType : {0, 2, 3, 4, 6}) {
+        for (int depth : {8, 16}) {
+            if (colorType == 3 && depth == 16)
+                continue;
+            pngwriter::Image img = image(37, 23, colorType, depth, uint32_t(colorType * 16 + depth));
+            // Each filter on its own, then all of them row by row.
+            for (int filter : allFilters) {
+                bool ok = matchesStb(pngwriter::encode(img, {filter}, mixed, 700));
+                if (!ok)
+                    std::printf("  colour type %d, %d-bit, filter %d\n", colorType, depth, filter);
+                CHECK(ok);
+            }
+            CHECK(matchesStb(pngwriter::encode(img, allFilters, mixed, 700)));
+        }
+    }
+}
+
+void testBlockTypes() {
+    pngwriter::Image img = image(120, 60, 6, 8, 7);
+    // One big block of each kind, blocks bigger than the 32 KB window, and
+    // lots of small ones so rows straddle block boundaries.
+    for (Block type : {Block::Stored, Block::Fixed, Block::Dynamic}) {
+        CHECK(matchesStb(pngwriter::encode(img, {0, 1, 2, 3, 4}, {type}, 1 << 20)));
+        CHECK(matchesStb(pngwriter::encode(img, {4}, {type}, 40000)));
+        CHECK(matchesStb(pngwriter::encode(img, {1, 2}, {type}, 97)));
+    }
+    // Stored blocks are at most 65535 bytes.
+    pngwriter::Image big = image(400, 200, 2, 8, 8);
+    CHECK(matchesStb(pngwriter::encode(big, {0}, {Block::Stored}, 65535)));
+}
+
+void testTransparency() {
+    pngwriter::Image palette = image(31, 17, 3, 8, 11);
+    palette.transparency = {0, 128, 255, 7};
+    CHECK(matchesStb(pngwriter::encode(palette, {0, 1, 2, 3, 4}, {Block::Dynamic})));
+
+    pngwriter::Image grey = image(31, 17, 0, 8, 12);
+    grey.transparency = {0, grey.pixels[5]};
+    std::vector<uint8_t> greyFile = pngwriter::encode(grey, {0}, {Block::Fixed});
+    CHECK(png::Decoder(greyFile.data(), greyFile.size()).channels() == 2);
+    CHECK(matchesStb(greyFile));
+
+    pngwriter::Image rgb = image(31, 17, 2, 16, 13);
+    rgb.transparency = {rgb.pixels[6], rgb.pixels[7], rgb.pixels[8], rgb.pixels[9], rgb.pixels[10], rgb.pixels[11]};
+    std::vector<uint8_t> rgbFile = pngwriter::encode(rgb, {3}, {Block::Dynamic});
+    CHECK(png::Decoder(rgbFile.data(), rgbFile.size()).channels() == 4);
+    CHECK(matchesStb(rgbFile));
+}
+
+// Decodes what it can; must never read out of bounds (run under ASan to be
+// sure) and must stop with supported() false.
+int decodeAll(const std::vector<uint8_t> &file) {
+    png::Decoder decoder(file.data(), file.size());
+    while (decoder.nextRow()) {
+    }
+    return decoder.supported() ? decoder.rowsDecoded() : -1;
+}
+
+void testTruncated() {
+    pngwriter::Image img = image(64, 48, 2, 8, 21);
+    std::vector<uint8_t> whole = pngwriter::encode(img, {0, 1, 2, 3, 4}, {Block::Dynamic, Block::Fixed, Block::Stored}, 900);
+    CHECK(decodeAll(whole) == 48);
+
+    // Every cut of the file: the header may not parse at all, or rows run
+    // out part way; either way no row past the data may come out.
+    bool allFailed = true;
+    for (size_t size = 0; size < whole.size() - 12; ++size) {
+        std::vector<uint8_t> cut(whole.begin(), whole.begin() + size);
+        png::Decoder decoder(cut.data(), cut.size());
+        while (decoder.nextRow()) {
+        }
+        allFailed &= !decoder.supported() && decoder.rowsDecoded() < 48;
+    }
+    CHECK(allFailed);
+
+    // A well-formed file whose zlib stream stops half way.
+    std::vector<uint8_t> filtered;
+    for (int y = 0; y < 48; ++y) {
+        filtered.push_back(0);
+        filtered.insert(filtered.end(), img.pixels.begin() + y * 192, img.pixels.begin() + (y + 1) * 192);
+    }
+    std::vector<uint8_t> stream = pngwriter::zlib(filtered, {Block::Fixed}, 1 << 20, {3, 193});
+    stream.resize(stream.size() / 2);
+    std::vector<uint8_t> file = pngwriter::wrap(64 * 3, 48, stream);
+    png::Decoder decoder(file.data(), file.size());
+    int rows = 0;
+    while (decoder.nextRow())
+        ++rows;
+    CHECK(rows > 0 && rows < 48 && !decoder.supported());
+}
+
+// HLIT = 31 and HDIST = 31 ask for 288 + 32 code lengths. Only 286 + 30
+// exist, and runs of code 18 used to write past the lengths array.
+void testOversizedCodeCounts() {
+    pngwriter::detail::BitWriter out;
+    out.put(0x78, 8);
+    out.put(0x01, 8);
+    out.put(1, 1);     // BFINAL
+    out.put(2, 2);     // dynamic
+    out.put(31, 5);    // HLIT
+    out.put(31, 5);    // HDIST
+    out.put(15, 4);    // HCLEN: all 19 code length code lengths
+    // Order 16, 17, 18, 0, ...: code 18 and code 0 both get length 1.
+    const int order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    for (int symbol : order)
+        out.put(symbol == 18 || symbol == 0 ? 1 : 0, 3);
+    // Code 0 is "0" and code 18 is "1": zero runs of 138 + 138 + 44 fill
+    // exactly the 320 lengths asked for, the last two past the array.
+    for (int repeat : {138, 138, 44}) {
+        out.putCode(1, 1);
+        out.put(uint32_t(repeat - 11), 7);
+    }
+    out.alignToByte();
+    std::vector<uint8_t> stream = out.bytes;
+    stream.resize(stream.size() + 64, 0);
+
+    std::vector<uint8_t> file = pngwriter::wrap(16, 1, stream);
+    png::Decoder decoder(file.data(), file.size());
+    CHECK(decoder.supported());
+    CHECK(decoder.nextRow() == nullptr);
+    CHECK(!decoder.supported());
+}
+
+void testNotPng() {
+    const unsigned char jpeg[] = {0xFF, 0xD8, 0xFF, 0xE0, 0, 16, 'J', 'F', 'I', 'F'};
+    png::Decoder decoder(jpeg, sizeof(jpeg));
+    CHECK(!decoder.isPngFile() && !decoder.supported() && decoder.nextRow() == nullptr);
+
+    // Interlaced: a PNG, but one left to stb_image.
+    pngwriter::Image img = image(8, 8, 0, 8, 31);
+    std::vector<uint8_t> file = pngwriter::encode(img, {0}, {Block::Stored});
+    file[8 + 8 + 12] = 1;
+    png::Decoder interlaced(file.data(), file.size());
+    CHECK(interlaced.isPngFile() && !interlaced.supported());
+}
+
+}
+
+int main() {
+    testFormatsAndFilters();
+    testBlockTypes();
+    testTransparency();
+    testTruncated();
+    testOversizedCodeCounts();
+    testNotPng();
+    return check::result();
+}
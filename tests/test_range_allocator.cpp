@@ -0,0 +1,120 @@
+// RangeAllocator against a bitmap of which units are in use, over a long run
+// of random allocations and frees.
+#include "check.hpp"
+#include "include/geometry_arena.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Run {
+    size_t offset, size;
+};
+
+std::vector<Run> freeRuns(const std::vector<bool> &used) {
+    std::vector<Run> runs;
+    for (size_t i = 0; i < used.size();) {
+        if (used[i]) {
+            ++i;
+            continue;
+        }
+        size_t start = i;
+        while (i < used.size() && !used[i])
+            ++i;
+        runs.push_back({start, i - start});
+    }
+    return runs;
+}
+
+// Every step is checked against the bitmap: an allocation must be free and
+// come from the start of the smallest free run that fits, a failure means no
+// run fits, and afterwards the allocator's free ranges must be exactly the
+// bitmap's free runs (so neighbours were merged).
+void testAgainstBitmap(size_t capacity, size_t maxSize, int steps, uint32_t seed) {
+    RangeAllocator allocator(capacity);
+    std::vector<bool> used(capacity, false);
+    std::vector<Run> live;
+    std::mt19937 rng(seed);
+    int wrongAllocations = 0, missedFits = 0, wrongFree = 0;
+
+    for (int step = 0; step < steps; ++step) {
+        // Lean towards allocating while mostly empty and freeing while full.
+        size_t freeUnits = static_cast<size_t>(std::count(used.begin(), used.end(), false));
+        bool allocate = live.empty() || rng() % capacity < freeUnits;
+        if (allocate) {
+            size_t size = 1 + rng() % maxSize;
+            std::vector<Run> runs = freeRuns(used);
+            size_t bestFit = SIZE_MAX;
+            for (const Run &run : runs)
+                if (run.size >= size)
+                    bestFit = std::min(bestFit, run.size);
+
+            size_t offset = allocator.allocate(size);
+            if (offset == RangeAllocator::none) {
+                missedFits += bestFit != SIZE_MAX;
+                continue;
+            }
+            auto run = std::find_if(runs.begin(), runs.end(), [&](const Run &r) { return r.offset == offset; });
+            if (run == runs.end() || run->size != bestFit) {
+                ++wrongAllocations;
+                continue;
+            }
+            std::fill(used.begin() + offset, used.begin() + offset + size, true);
+            live.push_back({offset, size});
+        } else {
+            size_t index = rng() % live.size();
+            Run run = live[index];
+            live[index] = live.back();
+            live.pop_back();
+            allocator.free(run.offset, run.size);
+            std::fill(used.begin() + run.offset, used.begin() + run.offset + run.size, false);
+        }
+
+        std::vector<Run> runs = freeRuns(used);
+        size_t total = 0, largest = 0;
+        for (const Run &run : runs) {
+            total += run.size;
+            largest = std::max(largest, run.size);
+        }
+        wrongFree += allocator.freeSpace() != total || allocator.largestFree() != largest
+                     || allocator.freeRanges() != runs.size();
+    }
+
+    if (wrongAllocations || missedFits || wrongFree)
+        std::printf("  capacity %zu: %d bad allocations, %d missed fits, %d bad free lists\n", capacity,
+                    wrongAllocations, missedFits, wrongFree);
+    CHECK(wrongAllocations == 0);
+    CHECK(missedFits == 0);
+    CHECK(wrongFree == 0);
+
+    // Freeing everything leaves one range covering the whole space again.
+    for (const Run &run : live)
+        allocator.free(run.offset, run.size);
+    CHECK(allocator.freeRanges() == 1 && allocator.largestFree() == capacity);
+}
+
+void testEdges() {
+    RangeAllocator empty(0);
+    CHECK(empty.allocate(1) == RangeAllocator::none);
+
+    RangeAllocator allocator(10);
+    CHECK(allocator.allocate(0) == RangeAllocator::none);
+    CHECK(allocator.allocate(11) == RangeAllocator::none);
+    CHECK(allocator.allocate(10) == 0);
+    CHECK(allocator.allocate(1) == RangeAllocator::none);
+    allocator.free(0, 10);
+    CHECK(allocator.largestFree() == 10);
+}
+
+}
+
+int main() {
+    testEdges();
+    // Small sizes against a small space, and sizes up to the whole space.
+    testAgainstBitmap(1024, 16, 200000, 1);
+    testAgainstBitmap(512, 512, 50000, 2);
+    return check::result();
+}
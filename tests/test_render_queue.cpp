@@ -0,0 +1,183 @@
+// radix::sort against std::stable_sort, the DrawKey layouts, and RenderQueue
+// packets that don't fit its capacity.
+#include "check.hpp"
+#include "include/render_queue.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Sorts (key, index) both ways; stable means equal keys keep index order.
+bool matchesStableSort(const std::vector<uint64_t> &input) {
+    std::vector<uint64_t> keys = input;
+    std::vector<uint32_t> values(keys.size());
+    std::iota(values.begin(), values.end(), 0u);
+    radix::Sorter sorter;
+    sorter.sort(keys, values);
+
+    std::vector<uint32_t> expected(input.size());
+    std::iota(expected.begin(), expected.end(), 0u);
+    std::stable_sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b) { return input[a] < input[b]; });
+    for (size_t i = 0; i < input.size(); ++i)
+        if (values[i] != expected[i] || keys[i] != input[expected[i]])
+            return false;
+    return true;
+}
+
+void testRadixSort() {
+    std::mt19937_64 rng(1);
+    for (size_t count : {0, 1, 2, 3, 100, 4096, 100000}) {
+        std::vector<uint64_t> keys(count);
+        for (uint64_t &key : keys)
+            key = rng();
+        CHECK(matchesStableSort(keys));
+
+        // Few distinct keys, so stability matters.
+        for (uint64_t &key : keys)
+            key = rng() % 7 * 0x0101010101010101ull;
+        CHECK(matchesStableSort(keys));
+
+        // Every byte the same: all passes are skipped.
+        std::fill(keys.begin(), keys.end(), 0x1234567890ABCDEFull);
+        CHECK(matchesStableSort(keys));
+
+        // Only the top byte differs: seven passes are skipped.
+        for (uint64_t &key : keys)
+            key = (rng() & 0xFF00000000000000ull) | 0x00FFEEDDCCBBAA99ull;
+        CHECK(matchesStableSort(keys));
+
+        // Only the bottom byte differs.
+        for (uint64_t &key : keys)
+            key = 0xAB00000000000000ull | (rng() & 0xFF);
+        CHECK(matchesStableSort(keys));
+    }
+}
+
+void testOrderedBits() {
+    const float values[] = {-1e30f, -5.0f, -1.0f, -1e-30f, -0.0f, 0.0f, 1e-30f, 0.5f, 1.0f, 3.0f, 1e30f};
+    bool ordered = true;
+    for (size_t i = 1; i < sizeof(values) / sizeof(values[0]); ++i)
+        ordered &= radix::orderedBits(values[i - 1]) < radix::orderedBits(values[i]);
+    CHECK(ordered);
+    // -0 and +0 are next to each other, with nothing in between.
+    CHECK(radix::orderedBits(0.0f) - radix::orderedBits(-0.0f) == 1);
+}
+
+// True if the keys come out in the order they were built in.
+bool sortsInOrder(const std::vector<uint64_t> &keys) {
+    std::vector<uint64_t> sorted = keys;
+    std::reverse(sorted.begin(), sorted.end());
+    std::vector<uint32_t> values(sorted.size());
+    radix::Sorter sorter;
+    sorter.sort(sorted, values);
+    return sorted == keys;
+}
+
+void testOpaqueKeys() {
+    // Pass first, then program, then texture set, then near before far.
+    CHECK(sortsInOrder({
+        DrawKey::opaque(0, 0, 0, 100.0f),
+        DrawKey::opaque(0, 0, 1, 0.5f),
+        DrawKey::opaque(0, 0, 1, 2.0f),
+        DrawKey::opaque(0, 1, 0, 0.1f),
+        DrawKey::opaque(0, 4095, 65535, 0.0f),
+        DrawKey::opaque(1, 0, 0, -3.0f),
+        DrawKey::opaque(1, 0, 0, 3.0f),
+        DrawKey::opaque(15, 0, 0, 0.0f),
+    }));
+    CHECK(DrawKey::pass(DrawKey::opaque(9, 4095, 65535, -1e30f)) == 9);
+    // Ids past their field are masked rather than spilling into the next.
+    CHECK(DrawKey::opaque(0, 4096, 0, 1.0f) == DrawKey::opaque(0, 0, 0, 1.0f));
+    CHECK(DrawKey::opaque(0, 0, 65536, 1.0f) == DrawKey::opaque(0, 0, 0, 1.0f));
+}
+
+void testTranslucentKeys() {
+    // Pass first, then far before near across negative depths and both
+    // zeros, with state only breaking ties.
+    CHECK(sortsInOrder({
+        DrawKey::translucent(0, 1e30f, 4095, 65535),
+        DrawKey::translucent(0, 10.0f, 0, 0),
+        DrawKey::translucent(0, 1.0f, 0, 5),
+        DrawKey::translucent(0, 1.0f, 1, 0),
+        DrawKey::translucent(0, 0.0f, 0, 0),
+        DrawKey::translucent(0, -0.0f, 0, 0),
+        DrawKey::translucent(0, -2.0f, 0, 0),
+        DrawKey::translucent(0, -1e30f, 0, 0),
+        DrawKey::translucent(1, 1e30f, 0, 0),
+        DrawKey::translucent(1, -1.0f, 0, 0),
+    }));
+    CHECK(DrawKey::pass(DrawKey::translucent(15, -1e30f, 4095, 65535)) == 15);
+}
+
+struct Draw {
+    int id = 0;
+};
+
+// More packets than the capacity: the rest go through the overflow list and
+// must all come back, sorted, with the capacity grown for the next frame.
+void testOverflow() {
+    RenderQueue<Draw> queue(4);
+    std::mt19937 rng(2);
+    for (int frame = 0; frame < 3; ++frame) {
+        std::vector<uint64_t> keys(50);
+        for (int i = 0; i < 50; ++i) {
+            keys[i] = rng() % 10;
+            queue.push(keys[i], {i});
+        }
+        CHECK(queue.size() == 50);
+        queue.sort();
+
+        std::vector<int> expected(50);
+        std::iota(expected.begin(), expected.end(), 0);
+        std::stable_sort(expected.begin(), expected.end(), [&](int a, int b) { return keys[a] < keys[b]; });
+        std::vector<int> replayed;
+        bool keysMatch = true;
+        queue.replay([&](uint64_t key, const Draw &draw) {
+            keysMatch &= key == keys[draw.id];
+            replayed.push_back(draw.id);
+        });
+        CHECK(keysMatch);
+        CHECK(replayed == expected);
+        queue.clear();
+        CHECK(queue.size() == 0);
+    }
+
+    // Several producers, most of them landing in overflow.
+    const int threads = 4, perThread = 5000;
+    RenderQueue<Draw> shared(16);
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; ++t)
+        producers.emplace_back([&shared, t] {
+            for (int i = 0; i < perThread; ++i)
+                shared.push(uint64_t(i), {t * perThread + i});
+        });
+    for (std::thread &producer : producers)
+        producer.join();
+    CHECK(shared.size() == size_t(threads * perThread));
+    shared.sort();
+    std::vector<int> seen(threads * perThread, 0);
+    uint64_t last = 0;
+    bool sorted = true;
+    shared.replay([&](uint64_t key, const Draw &draw) {
+        sorted &= key >= last && key == uint64_t(draw.id % perThread);
+        last = key;
+        ++seen[draw.id];
+    });
+    CHECK(sorted);
+    CHECK(std::all_of(seen.begin(), seen.end(), [](int n) { return n == 1; }));
+}
+
+}
+
+int main() {
+    testRadixSort();
+    testOrderedBits();
+    testOpaqueKeys();
+    testTranslucentKeys();
+    testOverflow();
+    return check::result();
+}
@@ -0,0 +1,130 @@
+// TextureStream against stb_image, with GL stubbed out: PNGs stepped a band
+// at a time through png::Decoder, and a TGA decoded on the worker thread,
+// must end up in the texture exactly as stbi_load returns them.
+#define STB_IMAGE_IMPLEMENTATION
+#include "include/texture_stream.hpp"
+#include "check.hpp"
+#include "gl_stub.hpp"
+#include "png_writer.hpp"
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+void writeFile(const std::string &path, const std::vector<uint8_t> &bytes) {
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+}
+
+std::vector<uint8_t> noise(size_t size, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> out(size);
+    for (uint8_t &byte : out)
+        byte = static_cast<uint8_t>(rng() >> 24);
+    return out;
+}
+
+// Uncompressed 24-bit, top row first: a format png::Decoder won't take.
+std::vector<uint8_t> tga(int width, int height, uint32_t seed) {
+    std::vector<uint8_t> file = {0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                 uint8_t(width), uint8_t(width >> 8), uint8_t(height), uint8_t(height >> 8), 24, 0x20};
+    std::vector<uint8_t> pixels = noise(size_t(width) * height * 3, seed);
+    file.insert(file.end(), pixels.begin(), pixels.end());
+    return file;
+}
+
+// Steps with no budget, so each call does a single unit of work, and checks
+// the texture against stbi_load of the same file.
+bool matchesStb(const std::string &path, const TextureDesc &desc, int rowsPerStep, int *steps = nullptr) {
+    glstub::install();
+    TextureStream stream(path, desc, rowsPerStep, 1000);
+    int count = 1;
+    while (!stream.step(0.0))
+        ++count;
+    if (steps)
+        *steps = count;
+    if (stream.failed())
+        return false;
+
+    int w, h, comp;
+    uint8_t *expected = stbi_load(path.c_str(), &w, &h, &comp, desc.desiredChannels);
+    if (!expected)
+        return false;
+    int channels = desc.desiredChannels ? desc.desiredChannels : comp;
+    const glstub::Texture &texture = glstub::state.textures[stream.ID];
+    size_t rowBytes = size_t(w) * channels;
+    bool same = texture.width == w && texture.height == h && texture.format == Image::glFormat(channels)
+                && texture.type == GL_UNSIGNED_BYTE && texture.mipmapped && stream.width == w
+                && stream.nrChannels == channels && stream.progress() == 1.0f;
+    for (int y = 0; same && y < h; ++y) {
+        int source = desc.flipVertically ? h - 1 - y : y;
+        same = std::memcmp(&texture.pixels[y * rowBytes], expected + source * rowBytes, rowBytes) == 0;
+    }
+    stbi_image_free(expected);
+    return same;
+}
+
+void testPng() {
+    pngwriter::Image rgba;
+    rgba.width = 97;
+    rgba.height = 61;
+    rgba.colorType = 6;
+    rgba.pixels = noise(rgba.rowBytes() * rgba.height, 1);
+    writeFile("test_texture_stream_rgba.png",
+              pngwriter::encode(rgba, {0, 1, 2, 3, 4}, {pngwriter::Block::Dynamic, pngwriter::Block::Stored}, 2000));
+
+    TextureDesc desc;
+    desc.flipVertically = false;
+    int steps = 0;
+    CHECK(matchesStb("test_texture_stream_rgba.png", desc, 8, &steps));
+    // The file comes in 1000-byte chunks and the rows 8 at a time.
+    CHECK(steps > 8);
+
+    desc.flipVertically = true;
+    CHECK(matchesStb("test_texture_stream_rgba.png", desc, 7));
+
+    // Grey widened to RGBA by TextureStream itself rather than by stb.
+    pngwriter::Image grey;
+    grey.width = 33;
+    grey.height = 20;
+    grey.colorType = 0;
+    grey.pixels = noise(grey.rowBytes() * grey.height, 2);
+    writeFile("test_texture_stream_grey.png", pngwriter::encode(grey, {4}, {pngwriter::Block::Fixed}));
+    desc.desiredChannels = 4;
+    CHECK(matchesStb("test_texture_stream_grey.png", desc, 64));
+}
+
+void testWorker() {
+    writeFile("test_texture_stream.tga", tga(70, 45, 3));
+    TextureDesc desc;
+    CHECK(matchesStb("test_texture_stream.tga", desc, 16));
+    desc.flipVertically = false;
+    desc.desiredChannels = 4;
+    CHECK(matchesStb("test_texture_stream.tga", desc, 16));
+
+    // Destroyed while the worker is still decoding: it has to stop and join.
+    writeFile("test_texture_stream_big.tga", tga(2048, 1024, 4));
+    glstub::install();
+    {
+        TextureStream stream("test_texture_stream_big.tga", {}, 64, size_t(1) << 30);
+        stream.step(0.0);
+        CHECK(stream.currentStage() == TextureStream::Stage::Decode);
+    }
+
+    glstub::install();
+    TextureStream missing("test_texture_stream_missing.tga");
+    CHECK(missing.step() && missing.failed());
+}
+
+}
+
+int main() {
+    testPng();
+    testWorker();
+    for (const char *path : {"test_texture_stream_rgba.png", "test_texture_stream_grey.png", "test_texture_stream.tga",
+                             "test_texture_stream_big.tga"})
+        std::remove(path);
+    return check::result();
+}
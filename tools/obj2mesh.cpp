@@ -0,0 +1,122 @@
+// Cooks a Wavefront OBJ into the binary mesh format (include/mesh_format.hpp):
+// a chain of simplified LODs, optimized for the vertex cache, overdraw and
+// vertex fetch, packed, and laid out so the runtime only has to map the file
+// and upload it.
+//
+//     obj2mesh model.obj model.mesh
+#include "include/mesh_format.hpp"
+#include "include/mesh_optimize.hpp"
+#include "include/mesh_simplify.hpp"
+#include "include/obj_import.hpp"
+#include "include/vertex_pack.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::cout << "Usage: obj2mesh <input.obj> <output.mesh>" << std::endl;
+        return -1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    obj::Mesh mesh = obj::load(argv[1]);
+    if (mesh.empty())
+        return -1;
+
+    const int stride = obj::Mesh::floatsPerVertex;
+    std::vector<uint32_t> &indices = mesh.indices;
+    size_t vertexCount = mesh.vertexCount();
+    meshopt::VertexCacheStats before = meshopt::analyzeVertexCache(indices.data(), indices.size(), vertexCount);
+
+    glm::vec3 low(INFINITY), high(-INFINITY);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        glm::vec3 p(mesh.vertices[i * stride], mesh.vertices[i * stride + 1], mesh.vertices[i * stride + 2]);
+        low = glm::min(low, p);
+        high = glm::max(high, p);
+    }
+    glm::vec3 center = (low + high) * 0.5f;
+    float radius = 0.0f;
+    for (size_t i = 0; i < vertexCount; ++i) {
+        glm::vec3 p(mesh.vertices[i * stride], mesh.vertices[i * stride + 1], mesh.vertices[i * stride + 2]);
+        radius = std::max(radius, glm::length(p - center));
+    }
+
+    meshopt::optimizeVertexCache(indices.data(), indices.size(), vertexCount);
+    meshopt::optimizeOverdraw(indices.data(), indices.size(), mesh.vertices.data(), vertexCount, stride);
+
+    // Each LOD aims for half the triangles of the one before, simplified from
+    // the full mesh so its error is measured against the original. The chain
+    // ends when a LOD would be too coarse to be worth drawing or barely
+    // smaller than the last.
+    const size_t maxLods = 8, minTriangles = 64;
+    const float maxError = 0.05f * radius;
+    std::vector<meshfile::LodRecord> lods = {{0, static_cast<uint32_t>(indices.size()), 0.0f, 0}};
+    std::vector<uint32_t> allIndices = indices, lod(indices.size());
+    std::string stopped;
+    while (lods.size() < maxLods) {
+        size_t target = lods.back().indexCount / 6 * 3;
+        if (target < minTriangles * 3)
+            break;
+        float error = 0.0f;
+        size_t locked = 0;
+        size_t count = meshopt::simplify(lod.data(), indices.data(), indices.size(), mesh.vertices.data(), vertexCount,
+                                         stride, target, maxError, &error, &locked);
+        if (count > lods.back().indexCount / 4 * 3) {
+            // Say why, so a mesh that gets no LODs isn't a mystery.
+            std::ostringstream reason;
+            reason << "LOD chain stopped: " << target / 3 << " triangles wanted, " << count / 3 << " reached; ";
+            if (locked * 2 >= vertexCount)
+                reason << locked << " of " << vertexCount << " vertices are locked where seams or borders meet"
+                       << " (a flat-shaded mesh? give it smooth normals)";
+            else
+                reason << "further collapses exceed the error limit of " << maxError;
+            stopped = reason.str();
+            break;
+        }
+        meshopt::optimizeVertexCache(lod.data(), count, vertexCount);
+        // selectLod() relies on errors growing down the chain.
+        error = std::max(error, lods.back().error);
+        lods.push_back({static_cast<uint32_t>(allIndices.size()), static_cast<uint32_t>(count), error, 0});
+        allIndices.insert(allIndices.end(), lod.begin(), lod.begin() + count);
+    }
+
+    // LOD 0 uses every vertex, so fetch order follows it; coarser LODs pick
+    // from the same vertices.
+    std::vector<float> ordered(mesh.vertices.size());
+    vertexCount = meshopt::optimizeVertexFetch(ordered.data(), allIndices.data(), allIndices.size(),
+                                               mesh.vertices.data(), vertexCount, stride * sizeof(float));
+    ordered.resize(vertexCount * stride);
+    meshopt::VertexCacheStats after = meshopt::analyzeVertexCache(allIndices.data(), indices.size(), vertexCount);
+
+    meshfile::CookedMesh cooked;
+    cooked.attributes = {
+        {0, 3, vertexpack::Format::Float, 0},          // position
+        {1, 3, vertexpack::Format::Snorm10x3_2, 3},    // normal
+        {2, 2, vertexpack::Format::Half, 6},           // texture coords
+    };
+    cooked.vertices = vertexpack::pack(ordered.data(), vertexCount, stride, cooked.attributes);
+    cooked.indices = allIndices;
+    cooked.lods = lods;
+    cooked.boundsMin = low;
+    cooked.boundsMax = high;
+    cooked.sphereCenter = center;
+    cooked.sphereRadius = radius;
+
+    if (!meshfile::write(argv[2], cooked))
+        return -1;
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << argv[2] << ": " << vertexCount << " vertices, " << cooked.vertices.layout.stride
+              << " bytes a vertex, ACMR " << before.acmr << " -> " << after.acmr << " (" << ms << " ms)" << std::endl;
+    for (size_t i = 0; i < lods.size(); ++i)
+        std::cout << "  LOD " << i << ": " << lods[i].indexCount / 3 << " triangles, error " << lods[i].error
+                  << " (" << lods[i].error / radius * 100.0f << "% of radius)" << std::endl;
+    if (!stopped.empty())
+        std::cout << "  " << stopped << std::endl;
+    return 0;
+}